@@ -1,7 +1,9 @@
 #version 330 core
 
+in vec4 vColor;
+
 out vec4 color;
 
 void main() {
-    color = vec4(1.0);
+    color = vColor;
 }
\ No newline at end of file
@@ -6,7 +6,10 @@ layout (location = 2) in vec2 size;
 
 uniform mat4 projection;
 
+out vec4 vColor;
+
 void main() 
 {
+	vColor = vec4(1.0);
 	gl_Position = projection * vec4((pos * size) + offset, 0.0, 1.0);
 }
\ No newline at end of file
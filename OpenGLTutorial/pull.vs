@@ -0,0 +1,123 @@
+// Vertex pulling: no vertex buffers or attributes. Instance records are
+// fetched by gl_InstanceID and corners are generated from gl_VertexID.
+// The #version line, USE_SSBO and PACKED_INSTANCES are supplied by the
+// program loader.
+
+struct Instance {
+	vec2 offset;
+	vec2 size;
+	vec4 color;
+	int shape;
+};
+
+#ifdef PACKED_INSTANCES
+// 12-byte records: unorm16 position over the arena, RGBA8 colour,
+// size class and shape id (see PackedInstance in instances.h)
+uniform vec2 arenaSize;
+
+// Two size classes per vec4: a vec2 array would take a whole vec4 slot
+// per element, which alone is the GL 3.3 minimum of 1024 components
+uniform vec4 sizeClasses[128];
+
+vec2 sizeClass(uint idx)
+{
+	vec4 pair = sizeClasses[idx >> 1];
+	return (idx & 1u) == 0u ? pair.xy : pair.zw;
+}
+
+Instance decodeInstance(uint pos, uint color, uint attr)
+{
+	vec2 offset = vec2(float(pos & 0xFFFFu), float(pos >> 16)) / 65535.0 * arenaSize;
+	vec4 rgba = vec4(float(color & 0xFFu), float((color >> 8) & 0xFFu), float((color >> 16) & 0xFFu), float(color >> 24)) / 255.0;
+	return Instance(offset, sizeClass(attr & 0xFFu), rgba, int((attr >> 8) & 0xFFu));
+}
+
+#ifdef USE_SSBO
+struct PackedInstance {
+	uint pos;
+	uint color;
+	uint attr;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+	PackedInstance instances[];
+};
+
+Instance fetchInstance(int idx)
+{
+	PackedInstance p = instances[idx];
+	return decodeInstance(p.pos, p.color, p.attr);
+}
+#else
+uniform usamplerBuffer instances;
+
+Instance fetchInstance(int idx)
+{
+	return decodeInstance(texelFetch(instances, idx * 3).r, texelFetch(instances, idx * 3 + 1).r, texelFetch(instances, idx * 3 + 2).r);
+}
+#endif
+
+#else
+uniform int shape;
+
+#ifdef USE_SSBO
+struct FullInstance {
+	vec2 offset;
+	vec2 size;
+	vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+	FullInstance instances[];
+};
+
+Instance fetchInstance(int idx)
+{
+	FullInstance f = instances[idx];
+	return Instance(f.offset, f.size, f.color, shape);
+}
+#else
+uniform samplerBuffer instances;
+
+Instance fetchInstance(int idx)
+{
+	vec4 a = texelFetch(instances, idx * 2);
+	vec4 b = texelFetch(instances, idx * 2 + 1);
+	return Instance(a.xy, a.zw, b, shape);
+}
+#endif
+
+#endif
+
+uniform mat4 projection;
+uniform int baseInstance;
+uniform int noSegments;
+
+out vec4 vColor;
+
+const vec2 quadCorners[6] = vec2[6](
+	vec2(0.5, 0.5), vec2(-0.5, 0.5), vec2(-0.5, -0.5),
+	vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5)
+);
+
+vec2 corner(int instShape)
+{
+	if (instShape == 0) {
+		return quadCorners[gl_VertexID];
+	}
+
+	//Triangle fan around the centre, 3 vertices per segment
+	int cornerIdx = gl_VertexID % 3;
+	if (cornerIdx == 0) {
+		return vec2(0.0);
+	}
+	float theta = 6.28318530718 * float(gl_VertexID / 3 + cornerIdx - 1) / float(noSegments);
+	return 0.5 * vec2(cos(theta), sin(theta));
+}
+
+void main()
+{
+	Instance inst = fetchInstance(baseInstance + gl_InstanceID);
+	vColor = inst.color;
+	gl_Position = projection * vec4((corner(inst.shape) * inst.size) + inst.offset, 0.0, 1.0);
+}
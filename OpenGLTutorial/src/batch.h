@@ -0,0 +1,121 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "sim.h"
+#include "rules.h"
+#include "bot.h"
+#include "rally.h"
+#include "columns.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Headless bot against bot matches, shared by the batch tools, and the
+	rally store they write. Every random number in match i comes from
+	(seed, i, tick), so any match of a batch can be replayed on its own,
+	whichever thread or process first played it.
+*/
+
+/* - Matches - */
+
+struct BatchParams {
+	SimParams sim;
+	BotParams bot;
+	uint32_t noBalls = 1;
+	uint64_t noTicks = 60000;
+	uint64_t seed = 0;
+};
+
+//Play one Match under Rules (see rules.h), Appending its Rallies to rows
+template<typename Rules, typename Alloc>
+inline void playMatchRules(const BatchParams& batch, const Level& level, uint32_t match, std::vector<RallyRow, Alloc>& rows)
+{
+	SimState state;
+	SimEvents events;
+	RallyTracker tracker;
+	initSim(state, level, batch.noBalls, batch.sim, batch.seed, match);
+	initRallyTracker(tracker, state, match);
+
+	for (uint64_t t = 0; t < batch.noTicks; t++) {
+		events.clear();
+		stepSimRules<Rules>(state, level, botMatchInput(state, batch.sim, batch.bot, batch.bot), batch.sim, &events);
+		trackRallies(tracker, state, events, rows);
+	}
+}
+
+template<typename Alloc>
+using MatchKernel = void (*)(const BatchParams&, const Level&, uint32_t, std::vector<RallyRow, Alloc>&);
+
+//The Kernel for a Batch's Mode, Chosen Once before its Matches are Played
+template<typename Alloc>
+inline MatchKernel<Alloc> selectMatchKernel(const BatchParams& batch, const Level& level)
+{
+	static const MatchKernel<Alloc> kernels[NO_RULE_SETS] = {
+		playMatchRules<RuleSet<1, false, false, true>, Alloc>,
+		playMatchRules<RuleSet<0, false, false, true>, Alloc>,
+		playMatchRules<RuleSet<1, true, false, true>, Alloc>,
+		playMatchRules<RuleSet<0, true, false, true>, Alloc>,
+		playMatchRules<RuleSet<1, false, true, true>, Alloc>,
+		playMatchRules<RuleSet<0, false, true, true>, Alloc>,
+		playMatchRules<RuleSet<1, true, true, true>, Alloc>,
+		playMatchRules<RuleSet<0, true, true, true>, Alloc>
+	};
+	return kernels[ruleSetIndex(batch.sim, level, std::min(batch.noBalls, MAX_BALLS))];
+}
+
+//Play one Match, Appending its Rallies to rows
+template<typename Alloc>
+inline void playMatch(const BatchParams& batch, const Level& level, uint32_t match, std::vector<RallyRow, Alloc>& rows)
+{
+	selectMatchKernel<Alloc>(batch, level)(batch, level, match, rows);
+}
+
+/* - Rally Store - */
+
+//One Writer per Column, Shared by the Workers
+struct RallyStore {
+	ColumnWriter columns[NO_RALLY_COLUMNS];
+	std::mutex mutex;
+	uint64_t noRows = 0;
+};
+
+inline bool openRallyStore(RallyStore& store, const std::string& dir)
+{
+	for (uint32_t i = 0; i < NO_RALLY_COLUMNS; i++) {
+		//Match Ids Mostly Repeat or Count Up, so they Delta Encode to a Bit or Two
+		ColumnEncoding encoding = i == 0 ? COLUMN_DELTA : COLUMN_FOR;
+		if (!openColumnWriter(store.columns[i], dir + "/" + RALLY_COLUMNS[i] + ".col", encoding)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//Append a Worker's Rows in One Go, Keeping each Worker's Matches Together
+template<typename Alloc>
+inline void appendRallies(RallyStore& store, std::vector<RallyRow, Alloc>& rows)
+{
+	std::lock_guard<std::mutex> lock(store.mutex);
+	for (uint32_t c = 0; c < NO_RALLY_COLUMNS; c++) {
+		for (const RallyRow& row : rows) {
+			appendColumn(store.columns[c], rallyField(row, c));
+		}
+	}
+	store.noRows += rows.size();
+	rows.clear();
+}
+
+inline bool closeRallyStore(RallyStore& store)
+{
+	bool ok = true;
+	for (uint32_t i = 0; i < NO_RALLY_COLUMNS; i++) {
+		ok = closeColumnWriter(store.columns[i]) && ok;
+	}
+	return ok;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "sim.h"
+
+#include <cstdint>
+#include <cmath>
+
+/*
+	Computer players for headless batch runs. A bot holds its paddle's
+	buttons towards where the most urgent incoming ball is, with a dead
+	zone so it does not jitter around the target. Aim noise moves the
+	target by a random amount that changes every noisePeriod ticks.
+*/
+
+/* - Bot Settings - */
+
+struct BotParams {
+	float deadZone = 8.0f;		//Arena Units around the Target the Paddle Rests in
+	float reach = 0.8f;			//Share of the Arena Width the Bot Watches, from its Own Side
+	float aimNoise = 0.0f;		//Largest Aim Error, Arena Units
+	uint32_t noisePeriod = 100;	//Ticks each Aim Error is Held for
+};
+
+/* - Input - */
+
+//Buttons for the Paddle on side (0 left, 1 right)
+inline uint8_t botInput(const SimState& state, uint32_t side, const SimParams& params, const BotParams& bot)
+{
+	const vec2& paddle = state.paddles[side];
+
+	//Soonest Ball Heading this Way and within Reach, Centre of the Arena if None
+	float target = params.arenaHeight / 2.0f;
+	float soonest = INFINITY;
+	for (uint32_t i = 0; i < state.noBalls; i++) {
+		const Ball& ball = state.balls[i];
+		float dist = fabsf(ball.pos.x - paddle.x);
+		bool incoming = side == 0 ? ball.vel.x < 0.0f : ball.vel.x > 0.0f;
+		if (!incoming || dist > bot.reach * params.arenaWidth) {
+			continue;
+		}
+
+		float eta = dist / fabsf(ball.vel.x);
+		if (eta < soonest) {
+			soonest = eta;
+			target = ball.pos.y;
+		}
+	}
+
+	//Error Scaled in Fixed Point, since a Fused Multiply-Add here would Change Decisions between Builds
+	if (bot.aimNoise > 0.0f) {
+		fixed u = (fixed)(simRandom(state, state.tick / bot.noisePeriod, RANDOM_BOT, side).v[0] >> 16);
+		target += fromFixed(fixedMul(2 * u - FIXED_ONE, toFixed(bot.aimNoise)));
+	}
+
+	uint8_t up = side == 0 ? INPUT_P0_UP : INPUT_P1_UP;
+	uint8_t down = side == 0 ? INPUT_P0_DOWN : INPUT_P1_DOWN;
+	if (target > paddle.y + bot.deadZone) {
+		return up;
+	}
+	if (target < paddle.y - bot.deadZone) {
+		return down;
+	}
+	return 0;
+}
+
+//Both Paddles Played by Bots
+inline uint8_t botMatchInput(const SimState& state, const SimParams& params, const BotParams& left, const BotParams& right)
+{
+	return botInput(state, 0, params, left) | botInput(state, 1, params, right);
+}
+
+#endif
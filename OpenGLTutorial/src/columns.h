@@ -0,0 +1,423 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLUMNS_SSE2
+#endif
+
+/*
+	Column store for large tables of unsigned 32-bit values, one file per
+	column. Values are cut into blocks of COLUMN_BLOCK_SIZE; each block is
+	stored as the minimum of its values and the rest bit-packed as offsets
+	from it (frame of reference), optionally after delta encoding for
+	columns that mostly count up. Files are little-endian and read through
+	a memory mapping, one block at a time, so tables far larger than memory
+	can be scanned.
+
+	Layout: ColumnHeader, the blocks, then a directory of block offsets.
+*/
+
+/* - Format - */
+
+const char COLUMN_MAGIC[4] = { 'P', 'C', 'O', 'L' };
+const uint32_t COLUMN_VERSION = 1;
+const uint32_t COLUMN_BLOCK_SIZE = 1024;
+
+enum ColumnEncoding {
+	COLUMN_FOR = 0,		//Offsets from the Block Minimum
+	COLUMN_DELTA = 1	//Zigzag Differences from the Previous Value, then as COLUMN_FOR
+};
+
+struct ColumnHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t encoding;
+	uint32_t blockSize;
+	uint64_t noValues;
+	uint64_t noBlocks;
+	uint64_t directoryOffset;
+	uint32_t minValue;
+	uint32_t maxValue;
+};
+
+static_assert(sizeof(ColumnHeader) == 48, "ColumnHeader layout is part of the file format");
+
+//Followed by ceil(count * bits / 32) + 1 Words, the Spare Word Lets Decoding Always Read 64 Bits
+struct ColumnBlock {
+	uint32_t first;		//First Value, Delta Encoding Only
+	uint32_t base;
+	uint32_t bits;
+	uint32_t count;
+};
+
+inline uint32_t zigzag(int32_t v)
+{
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v)
+{
+	return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+//Bits Needed to Hold v
+inline uint32_t bitWidth(uint32_t v)
+{
+	uint32_t bits = 0;
+	while (v) {
+		bits++;
+		v >>= 1;
+	}
+	return bits;
+}
+
+/* - Writing - */
+
+//Column being Appended to, Blocks are Encoded as they Fill
+struct ColumnWriter {
+	std::ofstream file;
+	ColumnHeader header;
+	std::vector<uint32_t> pending;
+	std::vector<uint64_t> directory;
+	uint64_t pos;
+};
+
+inline bool openColumnWriter(ColumnWriter& writer, const std::string& path, ColumnEncoding encoding)
+{
+	writer.file.open(path, std::ios::binary | std::ios::trunc);
+	if (!writer.file.is_open()) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	writer.header = {};
+	memcpy(writer.header.magic, COLUMN_MAGIC, 4);
+	writer.header.version = COLUMN_VERSION;
+	writer.header.encoding = encoding;
+	writer.header.blockSize = COLUMN_BLOCK_SIZE;
+	writer.header.minValue = 0xFFFFFFFF;
+	writer.pending.clear();
+	writer.directory.clear();
+
+	//Header is Rewritten with the Final Counts on Close
+	writer.file.write((const char*)&writer.header, sizeof(ColumnHeader));
+	writer.pos = sizeof(ColumnHeader);
+	return true;
+}
+
+//Encode and Write the Pending Values as One Block
+inline void writeColumnBlock(ColumnWriter& writer)
+{
+	std::vector<uint32_t>& values = writer.pending;
+	uint32_t count = (uint32_t)values.size();
+	if (count == 0) {
+		return;
+	}
+
+	ColumnBlock block = {};
+	block.first = values[0];
+	block.count = count;
+
+	std::vector<uint32_t> codes(count);
+	if (writer.header.encoding == COLUMN_DELTA) {
+		for (uint32_t i = 1; i < count; i++) {
+			codes[i] = zigzag((int32_t)(values[i] - values[i - 1]));
+		}
+		codes[0] = count > 1 ? codes[1] : 0;
+	}
+	else {
+		codes = values;
+	}
+
+	uint32_t lo = codes[0];
+	uint32_t hi = codes[0];
+	for (uint32_t code : codes) {
+		lo = code < lo ? code : lo;
+		hi = code > hi ? code : hi;
+	}
+	block.base = lo;
+	block.bits = bitWidth(hi - lo);
+
+	//Little-Endian Bit Stream, Value i at Bit i * bits
+	std::vector<uint32_t> words((count * (uint64_t)block.bits + 31) / 32 + 1, 0);
+	for (uint32_t i = 0; i < count && block.bits > 0; i++) {
+		uint64_t bit = (uint64_t)i * block.bits;
+		uint64_t v = (uint64_t)(codes[i] - lo) << (bit & 31);
+		words[bit >> 5] |= (uint32_t)v;
+		words[(bit >> 5) + 1] |= (uint32_t)(v >> 32);
+	}
+
+	for (uint32_t v : values) {
+		writer.header.minValue = v < writer.header.minValue ? v : writer.header.minValue;
+		writer.header.maxValue = v > writer.header.maxValue ? v : writer.header.maxValue;
+	}
+
+	writer.directory.push_back(writer.pos);
+	writer.file.write((const char*)&block, sizeof(block));
+	writer.file.write((const char*)words.data(), words.size() * sizeof(uint32_t));
+	writer.pos += sizeof(block) + words.size() * sizeof(uint32_t);
+	writer.header.noValues += count;
+	values.clear();
+}
+
+inline void appendColumn(ColumnWriter& writer, uint32_t value)
+{
+	writer.pending.push_back(value);
+	if (writer.pending.size() == COLUMN_BLOCK_SIZE) {
+		writeColumnBlock(writer);
+	}
+}
+
+//Write the Last Partial Block, the Directory and the Final Header
+inline bool closeColumnWriter(ColumnWriter& writer)
+{
+	writeColumnBlock(writer);
+	writer.header.noBlocks = writer.directory.size();
+
+	//Blocks End on 4 Bytes, the Directory is Read in Place as 8 Byte Offsets
+	if (writer.pos % sizeof(uint64_t) != 0) {
+		const uint32_t padding = 0;
+		writer.file.write((const char*)&padding, sizeof(padding));
+		writer.pos += sizeof(padding);
+	}
+	writer.header.directoryOffset = writer.pos;
+	if (writer.header.noValues == 0) {
+		writer.header.minValue = 0;
+	}
+	writer.file.write((const char*)writer.directory.data(), writer.directory.size() * sizeof(uint64_t));
+	writer.file.seekp(0);
+	writer.file.write((const char*)&writer.header, sizeof(ColumnHeader));
+	bool ok = writer.file.good();
+	writer.file.close();
+	return ok;
+}
+
+/* - Reading - */
+
+struct ColumnFile {
+	MappedFile mapped;
+	ColumnHeader header;
+	const uint64_t* directory = NULL;
+};
+
+inline void closeColumnFile(ColumnFile& column)
+{
+	unmapFile(column.mapped);
+	column.directory = NULL;
+}
+
+inline bool openColumnFile(ColumnFile& column, const std::string& path)
+{
+	if (!mapFile(column.mapped, path.c_str())) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	const char* base = (const char*)column.mapped.data;
+	if (column.mapped.size < sizeof(ColumnHeader)) {
+		std::cout << path << " is not a column file" << std::endl;
+		unmapFile(column.mapped);
+		return false;
+	}
+	memcpy(&column.header, base, sizeof(ColumnHeader));
+
+	//Bounds are Compared by Division so a Crafted Offset or Count cannot Wrap Past the Size
+	const ColumnHeader& header = column.header;
+	uint64_t size = column.mapped.size;
+	bool valid = memcmp(header.magic, COLUMN_MAGIC, 4) == 0 && header.version == COLUMN_VERSION
+		&& header.blockSize == COLUMN_BLOCK_SIZE
+		&& (header.encoding == COLUMN_FOR || header.encoding == COLUMN_DELTA)
+		&& header.directoryOffset % sizeof(uint64_t) == 0
+		&& header.directoryOffset <= size
+		&& header.noBlocks <= (size - header.directoryOffset) / sizeof(uint64_t)
+		&& header.noBlocks == header.noValues / COLUMN_BLOCK_SIZE + (header.noValues % COLUMN_BLOCK_SIZE != 0 ? 1 : 0);
+	if (!valid) {
+		std::cout << path << " is not a version " << COLUMN_VERSION << " column file" << std::endl;
+		unmapFile(column.mapped);
+		return false;
+	}
+	column.directory = (const uint64_t*)(base + header.directoryOffset);
+
+	//Every Block is Checked Here, so decodeColumnBlock can Trust them: Full but for the Last,
+	//at most 32 Bits a Value, and Header and Words Inside the File
+	for (uint64_t b = 0; b < header.noBlocks; b++) {
+		uint64_t offset = column.directory[b];
+		bool blockValid = offset % sizeof(uint32_t) == 0 && offset <= size - sizeof(ColumnBlock);
+		if (blockValid) {
+			ColumnBlock block;
+			memcpy(&block, base + offset, sizeof(block));
+			uint64_t expected = header.noValues - b * COLUMN_BLOCK_SIZE;
+			uint64_t noWords = ((uint64_t)block.count * block.bits + 31) / 32 + 1;
+			blockValid = block.count == (expected < COLUMN_BLOCK_SIZE ? expected : COLUMN_BLOCK_SIZE) && block.bits <= 32
+				&& noWords <= (size - offset - sizeof(ColumnBlock)) / sizeof(uint32_t);
+		}
+		if (!blockValid) {
+			std::cout << path << " has a corrupt block " << b << std::endl;
+			closeColumnFile(column);
+			return false;
+		}
+	}
+	return true;
+}
+
+//Decode Block idx into out (COLUMN_BLOCK_SIZE Values), Returning how many it Holds; openColumnFile has Checked the Block
+inline uint32_t decodeColumnBlock(const ColumnFile& column, uint64_t idx, uint32_t* out)
+{
+	const char* ptr = (const char*)column.mapped.data + column.directory[idx];
+	ColumnBlock block;
+	memcpy(&block, ptr, sizeof(block));
+	const uint32_t* words = (const uint32_t*)(ptr + sizeof(block));
+	uint32_t count = block.count;
+	uint32_t bits = block.bits;
+
+	//Unpack Offsets, Reading the Two Words each Value can Straddle
+	if (bits == 0) {
+		memset(out, 0, count * sizeof(uint32_t));
+	}
+	else {
+		uint64_t mask = (1ull << bits) - 1;
+		uint64_t bit = 0;
+		for (uint32_t i = 0; i < count; i++, bit += bits) {
+			uint64_t pair = words[bit >> 5] | (uint64_t)words[(bit >> 5) + 1] << 32;
+			out[i] = (uint32_t)((pair >> (bit & 31)) & mask);
+		}
+	}
+
+	//Add the Block Base
+	uint32_t i = 0;
+#ifdef COLUMNS_SSE2
+	__m128i base = _mm_set1_epi32((int)block.base);
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(out + i));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_add_epi32(v, base));
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] += block.base;
+	}
+
+	if (column.header.encoding == COLUMN_DELTA) {
+		out[0] = block.first;
+		for (uint32_t j = 1; j < count; j++) {
+			out[j] = out[j - 1] + (uint32_t)unzigzag(out[j]);
+		}
+	}
+	return count;
+}
+
+/* - Query Kernels - */
+
+//Lane Masks are all Ones for Rows that Pass, Zero Otherwise
+
+//Every Row Passes
+inline void resetMask(uint32_t* mask, uint32_t count)
+{
+	memset(mask, 0xFF, count * sizeof(uint32_t));
+}
+
+//Keep Rows with lo <= v <= hi
+inline void filterRange(const uint32_t* v, uint32_t count, uint32_t lo, uint32_t hi, uint32_t* mask)
+{
+	uint32_t i = 0;
+#ifdef COLUMNS_SSE2
+	//SSE2 only Compares Signed, so Flip the Sign Bits to Order Unsigned Values
+	const __m128i flip = _mm_set1_epi32((int)0x80000000);
+	const __m128i loF = _mm_xor_si128(_mm_set1_epi32((int)lo), flip);
+	const __m128i hiF = _mm_xor_si128(_mm_set1_epi32((int)hi), flip);
+	for (; i + 4 <= count; i += 4) {
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(v + i)), flip);
+		__m128i out = _mm_or_si128(_mm_cmplt_epi32(x, loF), _mm_cmpgt_epi32(x, hiF));
+		__m128i m = _mm_loadu_si128((const __m128i*)(mask + i));
+		_mm_storeu_si128((__m128i*)(mask + i), _mm_andnot_si128(out, m));
+	}
+#endif
+	for (; i < count; i++) {
+		mask[i] &= (v[i] >= lo && v[i] <= hi) ? 0xFFFFFFFF : 0;
+	}
+}
+
+struct ColumnStats {
+	uint64_t count = 0;
+	uint64_t sum = 0;
+	uint32_t min = 0xFFFFFFFF;
+	uint32_t max = 0;
+};
+
+//Count, Sum, Min and Max of the Rows that Pass
+inline void accumulateStats(const uint32_t* v, const uint32_t* mask, uint32_t count, ColumnStats& stats)
+{
+	uint32_t i = 0;
+#ifdef COLUMNS_SSE2
+	const __m128i flip = _mm_set1_epi32((int)0x80000000);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	__m128i passed = zero;
+	__m128i minF = _mm_set1_epi32(0x7FFFFFFF);		//0xFFFFFFFF Flipped
+	__m128i maxF = _mm_set1_epi32((int)0x80000000);	//0 Flipped
+	for (; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(v + i));
+		__m128i m = _mm_loadu_si128((const __m128i*)(mask + i));
+		passed = _mm_sub_epi32(passed, m);
+
+		//Widen to 64-bit Lanes before Summing so Blocks of Large Values cannot Overflow
+		__m128i kept = _mm_and_si128(x, m);
+		sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(kept, zero));
+		sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(kept, zero));
+
+		//Masked Out Lanes Take the Neutral Value
+		__m128i xF = _mm_xor_si128(x, flip);
+		__m128i forMin = _mm_or_si128(_mm_and_si128(m, xF), _mm_andnot_si128(m, _mm_set1_epi32(0x7FFFFFFF)));
+		__m128i forMax = _mm_or_si128(_mm_and_si128(m, xF), _mm_andnot_si128(m, flip));
+		__m128i lt = _mm_cmplt_epi32(forMin, minF);
+		minF = _mm_or_si128(_mm_and_si128(lt, forMin), _mm_andnot_si128(lt, minF));
+		__m128i gt = _mm_cmpgt_epi32(forMax, maxF);
+		maxF = _mm_or_si128(_mm_and_si128(gt, forMax), _mm_andnot_si128(gt, maxF));
+	}
+
+	alignas(16) uint64_t sums[2];
+	alignas(16) uint32_t counts[4];
+	alignas(16) uint32_t mins[4];
+	alignas(16) uint32_t maxs[4];
+	_mm_store_si128((__m128i*)sums, sum);
+	_mm_store_si128((__m128i*)counts, passed);
+	_mm_store_si128((__m128i*)mins, _mm_xor_si128(minF, flip));
+	_mm_store_si128((__m128i*)maxs, _mm_xor_si128(maxF, flip));
+	stats.sum += sums[0] + sums[1];
+	for (int j = 0; j < 4; j++) {
+		stats.count += counts[j];
+		stats.min = mins[j] < stats.min ? mins[j] : stats.min;
+		stats.max = maxs[j] > stats.max ? maxs[j] : stats.max;
+	}
+#endif
+	for (; i < count; i++) {
+		if (mask[i]) {
+			stats.count++;
+			stats.sum += v[i];
+			stats.min = v[i] < stats.min ? v[i] : stats.min;
+			stats.max = v[i] > stats.max ? v[i] : stats.max;
+		}
+	}
+}
+
+//Count Passing Rows into Bins of width binWidth Starting at lo, Clamping Outliers into the End Bins
+inline void accumulateHistogram(const uint32_t* v, const uint32_t* mask, uint32_t count, uint32_t lo, uint32_t binWidth, std::vector<uint64_t>& bins)
+{
+	uint32_t last = (uint32_t)bins.size() - 1;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t bin = v[i] < lo ? 0 : (v[i] - lo) / binWidth;
+		bin = bin > last ? last : bin;
+		bins[bin] += mask[i] & 1;
+	}
+}
+
+#endif
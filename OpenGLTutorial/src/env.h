@@ -0,0 +1,89 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include "sim.h"
+#include "bot.h"
+
+#include <cstdint>
+
+/*
+	Pong as a reinforcement learning environment: the agent plays the left
+	paddle against a bot, is rewarded +1 for each point it wins and -1 for
+	each it loses, and an episode ends when a side reaches the points to
+	win or the step limit runs out. Each step holds the action for a few
+	simulation ticks. Episodes of environment i use match numbers i,
+	i + noEnvs, i + 2 noEnvs and so on, so every episode draws its own
+	random numbers and can be replayed from (seed, match).
+*/
+
+/* - Environment - */
+
+struct EnvParams {
+	SimParams sim;
+	BotParams bot;
+	uint32_t noBalls = 1;
+	uint32_t ticksPerStep = 16;
+	uint32_t pointsToWin = 5;
+	uint32_t maxSteps = 10000;
+	uint64_t seed = 0;
+	uint32_t noEnvs = 1;
+};
+
+struct Env {
+	SimState state;
+	uint32_t index = 0;
+	uint32_t episode = 0;
+	uint32_t steps = 0;
+};
+
+inline void resetEnv(Env& env, const Level& level, const EnvParams& params)
+{
+	initSim(env.state, level, params.noBalls, params.sim, params.seed, env.index + env.episode * params.noEnvs);
+	env.steps = 0;
+}
+
+//Left Paddle's View: Paddle Heights, then each Ball, Scaled to about -1 to 1
+inline void observeEnv(const Env& env, const EnvParams& params, float* obs)
+{
+	const SimState& state = env.state;
+	float sx = 2.0f / params.sim.arenaWidth;
+	float sy = 2.0f / params.sim.arenaHeight;
+	float sv = 1.0f / params.sim.ballMaxSpeed;
+	obs[0] = state.paddles[0].y * sy - 1.0f;
+	obs[1] = state.paddles[1].y * sy - 1.0f;
+	for (uint32_t i = 0; i < params.noBalls; i++) {
+		const Ball& ball = state.balls[i];
+		obs[2 + i * 4] = ball.pos.x * sx - 1.0f;
+		obs[3 + i * 4] = ball.pos.y * sy - 1.0f;
+		obs[4 + i * 4] = ball.vel.x * sv;
+		obs[5 + i * 4] = ball.vel.y * sv;
+	}
+}
+
+//Hold action (0 Stay, 1 Up, 2 Down) for a Step's Ticks; Returns 0, or 1 when a Side has Won and 2 when out of Steps,
+//Resetting for the Next Episode then. The Codes Match env_shm.h's EnvAction and EnvDone
+inline uint8_t stepEnv(Env& env, const Level& level, uint8_t action, const EnvParams& params, float& reward)
+{
+	uint8_t buttons = action == 1 ? INPUT_P0_UP : action == 2 ? INPUT_P0_DOWN : 0;
+	uint32_t before[2] = { env.state.score[0], env.state.score[1] };
+	for (uint32_t t = 0; t < params.ticksPerStep; t++) {
+		stepSim(env.state, level, buttons | botInput(env.state, 1, params.sim, params.bot), params.sim);
+	}
+	reward = (float)(env.state.score[0] - before[0]) - (float)(env.state.score[1] - before[1]);
+	env.steps++;
+
+	uint8_t done = 0;
+	if (env.state.score[0] >= params.pointsToWin || env.state.score[1] >= params.pointsToWin) {
+		done = 1;
+	}
+	else if (env.steps >= params.maxSteps) {
+		done = 2;
+	}
+	if (done) {
+		env.episode++;
+		resetEnv(env, level, params);
+	}
+	return done;
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef ENV_SHM_H
+#define ENV_SHM_H
+
+/*
+	Shared memory layout between envserver (see tools/envserver.cpp) and a
+	trainer process. Plain C, so trainers in C or anything with a C FFI can
+	include it as is (strict C modes need _GNU_SOURCE defined first, for
+	syscall). Linux only: POSIX shared memory and futexes.
+
+	The region starts with an EnvShmHeader, then four arrays at the
+	offsets it gives, each cache line aligned:
+		float observations[noEnvs][obsFloats]
+		uint8_t actions[noEnvs]		ENV_ACTION_*
+		float rewards[noEnvs]
+		uint8_t dones[noEnvs]		ENV_DONE_*
+
+	A step is a handshake on two words. The trainer writes actions, then
+	posts step number n to request; the server steps every environment,
+	writes observations, rewards and dones in place, then posts n to done.
+	Waiters spin for a while before sleeping on a futex, so back to back
+	steps never enter the kernel, and a trainer that sleeps costs no CPU.
+*/
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* - Layout - */
+
+#define ENV_SHM_MAGIC 0x564E45474E4F50ULL	/* "PONGENV" */
+#define ENV_SHM_VERSION 1
+#define ENV_SHM_DEFAULT_NAME "/pong-env"
+#define ENV_SHM_ALIGNMENT 64
+
+//Trainer's Paddle is the Left One, Side 0
+enum EnvAction {
+	ENV_ACTION_STAY = 0,
+	ENV_ACTION_UP = 1,
+	ENV_ACTION_DOWN = 2
+};
+
+//Episodes Reset Themselves; the Observation after a Done is the Next Episode's First
+enum EnvDone {
+	ENV_DONE_NOT = 0,
+	ENV_DONE_TERMINAL = 1,	//A Side Reached the Points to Win
+	ENV_DONE_TRUNCATED = 2	//Ran out of Steps
+};
+
+//A Futex Word on its Own Cache Line, with a Count of Sleepers so Posting Skips the Wake when Nobody Sleeps
+typedef struct EnvShmWord {
+	uint32_t value;
+	uint32_t sleepers;
+	uint8_t pad[ENV_SHM_ALIGNMENT - 8];
+} EnvShmWord;
+
+typedef struct EnvShmHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t noEnvs;
+	uint32_t obsFloats;			//2 Paddle Heights, then x, y, vx, vy per Ball, all about -1 to 1
+	uint32_t noBalls;
+	uint32_t ticksPerStep;		//Simulation Ticks per Step, at 1 kHz
+	uint32_t stop;				//Set by the Trainer before Posting, to Shut the Server Down
+	uint64_t obsOffset;
+	uint64_t actionOffset;
+	uint64_t rewardOffset;
+	uint64_t doneOffset;
+	uint64_t totalSize;
+	uint8_t pad[2 * ENV_SHM_ALIGNMENT - 72];
+	EnvShmWord request;			//Step Number the Trainer Wants
+	EnvShmWord done;			//Step Number the Server has Finished
+} EnvShmHeader;
+
+//Both Sides must Agree on the Layout; a Negative Array Size Fails the Build where it does not Hold
+typedef char envShmHeaderSize[sizeof(EnvShmHeader) == 4 * ENV_SHM_ALIGNMENT ? 1 : -1];
+
+static inline uint64_t envShmAlign(uint64_t offset)
+{
+	return (offset + ENV_SHM_ALIGNMENT - 1) & ~(uint64_t)(ENV_SHM_ALIGNMENT - 1);
+}
+
+//Fill the Sizes and Offsets for noEnvs Environments
+static inline void envShmLayout(EnvShmHeader* header, uint32_t noEnvs, uint32_t noBalls, uint32_t ticksPerStep)
+{
+	header->magic = ENV_SHM_MAGIC;
+	header->version = ENV_SHM_VERSION;
+	header->noEnvs = noEnvs;
+	header->obsFloats = 2 + 4 * noBalls;
+	header->noBalls = noBalls;
+	header->ticksPerStep = ticksPerStep;
+	header->stop = 0;
+	header->obsOffset = envShmAlign(sizeof(EnvShmHeader));
+	header->actionOffset = envShmAlign(header->obsOffset + (uint64_t)noEnvs * header->obsFloats * sizeof(float));
+	header->rewardOffset = envShmAlign(header->actionOffset + noEnvs);
+	header->doneOffset = envShmAlign(header->rewardOffset + (uint64_t)noEnvs * sizeof(float));
+	header->totalSize = envShmAlign(header->doneOffset + noEnvs);
+}
+
+static inline float* envObservations(EnvShmHeader* header)
+{
+	return (float*)((uint8_t*)header + header->obsOffset);
+}
+
+static inline uint8_t* envActions(EnvShmHeader* header)
+{
+	return (uint8_t*)header + header->actionOffset;
+}
+
+static inline float* envRewards(EnvShmHeader* header)
+{
+	return (float*)((uint8_t*)header + header->rewardOffset);
+}
+
+static inline uint8_t* envDones(EnvShmHeader* header)
+{
+	return (uint8_t*)header + header->doneOffset;
+}
+
+/* - Handshake - */
+
+static inline void envCpuRelax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+//Wait for the Word to Change from old, Spinning spins Times before Sleeping; Returns the New Value
+static inline uint32_t envShmWait(EnvShmWord* word, uint32_t old, uint32_t spins)
+{
+	uint32_t value;
+	for (uint32_t i = 0; i < spins; i++) {
+		value = __atomic_load_n(&word->value, __ATOMIC_ACQUIRE);
+		if (value != old) {
+			return value;
+		}
+		envCpuRelax();
+	}
+
+	//Counted before the Last Check, so a Post Either Sees the Sleeper or is Seen by the Check
+	__atomic_fetch_add(&word->sleepers, 1, __ATOMIC_SEQ_CST);
+	while ((value = __atomic_load_n(&word->value, __ATOMIC_SEQ_CST)) == old) {
+		syscall(SYS_futex, &word->value, FUTEX_WAIT, old, NULL, NULL, 0);
+	}
+	__atomic_fetch_sub(&word->sleepers, 1, __ATOMIC_SEQ_CST);
+	return value;
+}
+
+//Publish value, Releasing every Write before it, and Wake any Sleepers
+static inline void envShmPost(EnvShmWord* word, uint32_t value)
+{
+	__atomic_store_n(&word->value, value, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&word->sleepers, __ATOMIC_SEQ_CST) != 0) {
+		syscall(SYS_futex, &word->value, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+#endif
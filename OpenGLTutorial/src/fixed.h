@@ -0,0 +1,100 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cstdint>
+
+/*
+	Q16.16 fixed point math. Everything here is integer arithmetic, so the
+	results are bit-identical whatever the compiler, optimisation level or
+	instruction set; float code gives no such promise once fused
+	multiply-adds, vectorisation or library sinf and cosf get involved.
+*/
+
+/* - Q16.16 - */
+
+typedef int32_t fixed;
+
+const int FIXED_SHIFT = 16;
+const fixed FIXED_ONE = 1 << FIXED_SHIFT;
+const fixed FIXED_HALF = FIXED_ONE / 2;
+
+//Nearest Fixed Value; Exact in Double, so the Same on every Machine
+inline fixed toFixed(double value)
+{
+	double scaled = value * FIXED_ONE;
+	return (fixed)(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+inline float fromFixed(fixed value)
+{
+	return (float)value * (1.0f / FIXED_ONE);
+}
+
+inline fixed fixedAbs(fixed value)
+{
+	return value < 0 ? -value : value;
+}
+
+inline fixed fixedMul(fixed a, fixed b)
+{
+	return (fixed)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+inline fixed fixedDiv(fixed a, fixed b)
+{
+	return (fixed)((int64_t)a * FIXED_ONE / b);
+}
+
+//Integer Square Root, Rounded Down
+inline uint32_t isqrt64(uint64_t value)
+{
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)root;
+}
+
+//Length of (x, y); the Squares are Q32.32, so their Root is Q16.16
+inline fixed fixedLength(fixed x, fixed y)
+{
+	return (fixed)isqrt64((uint64_t)((int64_t)x * x + (int64_t)y * y));
+}
+
+/* - Trigonometry - */
+
+//Taylor Series in Horner Form, within a Few Units in the Last Place for |angle| <= pi / 2
+inline fixed fixedSin(fixed angle)
+{
+	fixed sq = fixedMul(angle, angle);
+	fixed t = FIXED_ONE - fixedMul(sq, FIXED_ONE / 110);
+	t = FIXED_ONE - fixedMul(sq, t) / 72;
+	t = FIXED_ONE - fixedMul(sq, t) / 42;
+	t = FIXED_ONE - fixedMul(sq, t) / 20;
+	t = FIXED_ONE - fixedMul(sq, t) / 6;
+	return fixedMul(angle, t);
+}
+
+inline fixed fixedCos(fixed angle)
+{
+	fixed sq = fixedMul(angle, angle);
+	fixed t = FIXED_ONE - fixedMul(sq, FIXED_ONE / 132);
+	t = FIXED_ONE - fixedMul(sq, t) / 90;
+	t = FIXED_ONE - fixedMul(sq, t) / 56;
+	t = FIXED_ONE - fixedMul(sq, t) / 30;
+	t = FIXED_ONE - fixedMul(sq, t) / 12;
+	return FIXED_ONE - fixedMul(sq, t) / 2;
+}
+
+#endif
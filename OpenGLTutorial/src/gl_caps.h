@@ -0,0 +1,351 @@
+#ifndef GL_CAPS_H
+#define GL_CAPS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+/*
+	The bundled glad loader only covers GL 3.3 with no extensions, so the
+	entry points for the 4.x fast paths are declared and loaded here. Each
+	block is guarded the same way glad guards its own versions, so
+	regenerating glad with a newer API simply takes over these names.
+*/
+
+/* - Enums Missing from the 3.3 Loader - */
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+#endif
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#endif
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/* - Entry Points Missing from the 3.3 Loader - */
+
+#ifndef GL_VERSION_4_2
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount, GLuint baseinstance);
+PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC glad_ext_glDrawElementsInstancedBaseInstance = NULL;
+#define glDrawElementsInstancedBaseInstance glad_ext_glDrawElementsInstancedBaseInstance
+#endif
+
+#ifndef GL_VERSION_4_3
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void* userParam);
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_ext_glMultiDrawElementsIndirect = NULL;
+PFNGLDISPATCHCOMPUTEPROC glad_ext_glDispatchCompute = NULL;
+PFNGLMEMORYBARRIERPROC glad_ext_glMemoryBarrier = NULL;
+PFNGLDEBUGMESSAGECALLBACKPROC glad_ext_glDebugMessageCallback = NULL;
+#define glMultiDrawElementsIndirect glad_ext_glMultiDrawElementsIndirect
+#define glDispatchCompute glad_ext_glDispatchCompute
+#define glMemoryBarrier glad_ext_glMemoryBarrier
+#define glDebugMessageCallback glad_ext_glDebugMessageCallback
+#endif
+
+#ifndef GL_VERSION_4_4
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+PFNGLBUFFERSTORAGEPROC glad_ext_glBufferStorage = NULL;
+#define glBufferStorage glad_ext_glBufferStorage
+#endif
+
+#ifndef GL_VERSION_4_5
+typedef void (APIENTRYP PFNGLCREATEBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSTORAGEPROC)(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERDATAPROC)(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSUBDATAPROC)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+typedef void* (APIENTRYP PFNGLMAPNAMEDBUFFERRANGEPROC)(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void (APIENTRYP PFNGLCREATEVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+typedef void (APIENTRYP PFNGLVERTEXARRAYVERTEXBUFFERPROC)(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+typedef void (APIENTRYP PFNGLVERTEXARRAYELEMENTBUFFERPROC)(GLuint vaobj, GLuint buffer);
+typedef void (APIENTRYP PFNGLENABLEVERTEXARRAYATTRIBPROC)(GLuint vaobj, GLuint index);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBFORMATPROC)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBBINDINGPROC)(GLuint vaobj, GLuint attribindex, GLuint bindingindex);
+typedef void (APIENTRYP PFNGLVERTEXARRAYBINDINGDIVISORPROC)(GLuint vaobj, GLuint bindingindex, GLuint divisor);
+PFNGLCREATEBUFFERSPROC glad_ext_glCreateBuffers = NULL;
+PFNGLNAMEDBUFFERSTORAGEPROC glad_ext_glNamedBufferStorage = NULL;
+PFNGLNAMEDBUFFERDATAPROC glad_ext_glNamedBufferData = NULL;
+PFNGLNAMEDBUFFERSUBDATAPROC glad_ext_glNamedBufferSubData = NULL;
+PFNGLMAPNAMEDBUFFERRANGEPROC glad_ext_glMapNamedBufferRange = NULL;
+PFNGLCREATEVERTEXARRAYSPROC glad_ext_glCreateVertexArrays = NULL;
+PFNGLVERTEXARRAYVERTEXBUFFERPROC glad_ext_glVertexArrayVertexBuffer = NULL;
+PFNGLVERTEXARRAYELEMENTBUFFERPROC glad_ext_glVertexArrayElementBuffer = NULL;
+PFNGLENABLEVERTEXARRAYATTRIBPROC glad_ext_glEnableVertexArrayAttrib = NULL;
+PFNGLVERTEXARRAYATTRIBFORMATPROC glad_ext_glVertexArrayAttribFormat = NULL;
+PFNGLVERTEXARRAYATTRIBBINDINGPROC glad_ext_glVertexArrayAttribBinding = NULL;
+PFNGLVERTEXARRAYBINDINGDIVISORPROC glad_ext_glVertexArrayBindingDivisor = NULL;
+#define glCreateBuffers glad_ext_glCreateBuffers
+#define glNamedBufferStorage glad_ext_glNamedBufferStorage
+#define glNamedBufferData glad_ext_glNamedBufferData
+#define glNamedBufferSubData glad_ext_glNamedBufferSubData
+#define glMapNamedBufferRange glad_ext_glMapNamedBufferRange
+#define glCreateVertexArrays glad_ext_glCreateVertexArrays
+#define glVertexArrayVertexBuffer glad_ext_glVertexArrayVertexBuffer
+#define glVertexArrayElementBuffer glad_ext_glVertexArrayElementBuffer
+#define glEnableVertexArrayAttrib glad_ext_glEnableVertexArrayAttrib
+#define glVertexArrayAttribFormat glad_ext_glVertexArrayAttribFormat
+#define glVertexArrayAttribBinding glad_ext_glVertexArrayAttribBinding
+#define glVertexArrayBindingDivisor glad_ext_glVertexArrayBindingDivisor
+#endif
+
+#ifndef GL_KHR_parallel_shader_compile
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_ext_glMaxShaderCompilerThreadsKHR = NULL;
+#define glMaxShaderCompilerThreadsKHR glad_ext_glMaxShaderCompilerThreadsKHR
+#endif
+
+/* - Capability Detection - */
+
+//Render Tiers, each one a superset of the previous
+enum GLTier {
+	GL_TIER_BASELINE = 0,	//3.3 core: bind-to-edit, one draw per object
+	GL_TIER_EXTENDED,		//Some of the fast paths below available through extensions
+	GL_TIER_MODERN			//Persistent mapped instance streams, indirect draws and DSA
+};
+
+//Context Version, Extensions and Selected Fast Paths
+struct GLCaps {
+	int versionMajor = 0;
+	int versionMinor = 0;
+	std::vector<std::string> extensions;
+
+	bool baseInstance = false;
+	bool persistentMapping = false;
+	bool indirectDraw = false;
+	bool dsa = false;
+	bool compute = false;
+	bool ssbo = false;
+	bool debugOutput = false;
+	bool parallelCompile = false;
+
+	GLTier tier = GL_TIER_BASELINE;
+};
+
+//Capabilities of the Current Context
+GLCaps glCaps;
+
+//Check Context Version
+bool hasVersion(const GLCaps& caps, int major, int minor)
+{
+	return caps.versionMajor > major || (caps.versionMajor == major && caps.versionMinor >= minor);
+}
+
+//Check Extension String
+bool hasExtension(const GLCaps& caps, const char* name)
+{
+	return std::binary_search(caps.extensions.begin(), caps.extensions.end(), std::string(name));
+}
+
+//Load Entry Point, Preferring the Core Name and Falling Back to the Extension Name
+template<typename T>
+bool loadProc(T& proc, const char* name, const char* extName = NULL)
+{
+	proc = (T)glfwGetProcAddress(name);
+	if (!proc && extName) {
+		proc = (T)glfwGetProcAddress(extName);
+	}
+	return proc != NULL;
+}
+
+//Detect Version and Extensions, Load Fast Path Entry Points and Select Tier
+void detectGLCaps(GLCaps& caps)
+{
+	glGetIntegerv(GL_MAJOR_VERSION, &caps.versionMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &caps.versionMinor);
+
+	//Sorted so lookups can binary search
+	GLint noExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &noExtensions);
+	caps.extensions.clear();
+	caps.extensions.reserve(noExtensions);
+	for (GLint i = 0; i < noExtensions; i++) {
+		caps.extensions.push_back((const char*)glGetStringi(GL_EXTENSIONS, i));
+	}
+	std::sort(caps.extensions.begin(), caps.extensions.end());
+
+	//A path is only enabled when the driver advertises it and every entry point resolved
+	if (hasVersion(caps, 4, 2) || hasExtension(caps, "GL_ARB_base_instance")) {
+		caps.baseInstance = loadProc(glDrawElementsInstancedBaseInstance, "glDrawElementsInstancedBaseInstance");
+	}
+
+	if (hasVersion(caps, 4, 4) || hasExtension(caps, "GL_ARB_buffer_storage")) {
+		caps.persistentMapping = loadProc(glBufferStorage, "glBufferStorage");
+	}
+
+	if (hasVersion(caps, 4, 3) || hasExtension(caps, "GL_ARB_multi_draw_indirect")) {
+		caps.indirectDraw = loadProc(glMultiDrawElementsIndirect, "glMultiDrawElementsIndirect");
+	}
+
+	if (hasVersion(caps, 4, 3) || hasExtension(caps, "GL_ARB_compute_shader")) {
+		caps.compute = loadProc(glDispatchCompute, "glDispatchCompute")
+			&& loadProc(glMemoryBarrier, "glMemoryBarrier");
+	}
+
+	//Buffer Blocks also Need Explicit Bindings in the Shader (4.2 or 420pack)
+	caps.ssbo = hasVersion(caps, 4, 3) || (hasExtension(caps, "GL_ARB_shader_storage_buffer_object")
+		&& (hasVersion(caps, 4, 2) || hasExtension(caps, "GL_ARB_shading_language_420pack")));
+
+	if (hasVersion(caps, 4, 3) || hasExtension(caps, "GL_KHR_debug")) {
+		caps.debugOutput = loadProc(glDebugMessageCallback, "glDebugMessageCallback", "glDebugMessageCallbackKHR");
+	}
+
+	if (hasExtension(caps, "GL_KHR_parallel_shader_compile")) {
+		caps.parallelCompile = loadProc(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsKHR");
+	}
+	else if (hasExtension(caps, "GL_ARB_parallel_shader_compile")) {
+		caps.parallelCompile = loadProc(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsARB");
+	}
+
+	if (hasVersion(caps, 4, 5) || hasExtension(caps, "GL_ARB_direct_state_access")) {
+		caps.dsa = loadProc(glCreateBuffers, "glCreateBuffers")
+			&& loadProc(glNamedBufferStorage, "glNamedBufferStorage")
+			&& loadProc(glNamedBufferData, "glNamedBufferData")
+			&& loadProc(glNamedBufferSubData, "glNamedBufferSubData")
+			&& loadProc(glMapNamedBufferRange, "glMapNamedBufferRange")
+			&& loadProc(glCreateVertexArrays, "glCreateVertexArrays")
+			&& loadProc(glVertexArrayVertexBuffer, "glVertexArrayVertexBuffer")
+			&& loadProc(glVertexArrayElementBuffer, "glVertexArrayElementBuffer")
+			&& loadProc(glEnableVertexArrayAttrib, "glEnableVertexArrayAttrib")
+			&& loadProc(glVertexArrayAttribFormat, "glVertexArrayAttribFormat")
+			&& loadProc(glVertexArrayAttribBinding, "glVertexArrayAttribBinding")
+			&& loadProc(glVertexArrayBindingDivisor, "glVertexArrayBindingDivisor");
+	}
+
+	//Select Tier from the Paths the Renderer Uses; Base Instance and Compute are Detected but nothing Draws with them Yet
+	if (caps.persistentMapping && caps.indirectDraw && caps.dsa) {
+		caps.tier = GL_TIER_MODERN;
+	}
+	else if (caps.persistentMapping || caps.indirectDraw || caps.dsa) {
+		caps.tier = GL_TIER_EXTENDED;
+	}
+	else {
+		caps.tier = GL_TIER_BASELINE;
+	}
+}
+
+//Tier Name
+const char* tierName(GLTier tier)
+{
+	switch (tier) {
+	case GL_TIER_MODERN:
+		return "modern";
+	case GL_TIER_EXTENDED:
+		return "extended";
+	default:
+		return "baseline (3.3)";
+	}
+}
+
+//Print Context and Selected Fast Paths
+void reportGLCaps(const GLCaps& caps)
+{
+	std::cout << "OpenGL " << caps.versionMajor << "." << caps.versionMinor
+		<< " (" << glGetString(GL_RENDERER) << ", " << glGetString(GL_VENDOR) << ")" << std::endl;
+	std::cout << "Render tier: " << tierName(caps.tier) << std::endl;
+	std::cout << "  persistent mapping:  " << (caps.persistentMapping ? "yes" : "no") << std::endl;
+	std::cout << "  indirect draws:      " << (caps.indirectDraw ? "yes" : "no") << std::endl;
+	std::cout << "  direct state access: " << (caps.dsa ? "yes" : "no") << std::endl;
+	std::cout << "  SSBO:                " << (caps.ssbo ? "yes" : "no") << std::endl;
+	std::cout << "  base instance:       " << (caps.baseInstance ? "yes" : "no") << " (unused)" << std::endl;
+	std::cout << "  compute:             " << (caps.compute ? "yes" : "no") << " (unused)" << std::endl;
+	std::cout << "  debug output:        " << (caps.debugOutput ? "yes" : "no") << std::endl;
+	std::cout << "  parallel compile:    " << (caps.parallelCompile ? "yes" : "no") << std::endl;
+}
+
+/* - Optional Driver Features - */
+
+//Short Names for a Debug Message's Source and Type
+const char* debugSourceName(GLenum source)
+{
+	switch (source) {
+	case GL_DEBUG_SOURCE_API: return "api";
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+	case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+	case GL_DEBUG_SOURCE_APPLICATION: return "application";
+	default: return "other";
+	}
+}
+
+const char* debugTypeName(GLenum type)
+{
+	switch (type) {
+	case GL_DEBUG_TYPE_ERROR: return "error";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behaviour";
+	case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+	case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+	default: return "other";
+	}
+}
+
+//Print Driver Debug Messages with where they Came from, so the Call or Shader can be Found
+void APIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+	(void)length;
+	(void)userParam;
+	if (severity == GL_DEBUG_SEVERITY_NOTIFICATION) {
+		return;
+	}
+	std::cout << "GL debug (" << debugSourceName(source) << ", " << debugTypeName(type) << ", id " << id << "): " << message << std::endl;
+}
+
+//Turn on the Fast Paths that Need No Further Setup
+void enableGLFeatures(const GLCaps& caps)
+{
+#ifdef _DEBUG
+	if (caps.debugOutput) {
+		glEnable(GL_DEBUG_OUTPUT);
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(debugMessageCallback, NULL);
+	}
+#endif
+
+	if (caps.parallelCompile) {
+		//Let the driver pick the thread count
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+}
+
+#endif
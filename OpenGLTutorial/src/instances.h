@@ -0,0 +1,249 @@
+#ifndef INSTANCES_H
+#define INSTANCES_H
+
+#include "vecmath.h"
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INSTANCES_SSE2
+#endif
+
+/*
+	Per-instance records fetched by pull.vs with gl_InstanceID. New
+	properties are added here and in the shader's decode, with no new
+	buffers or attributes.
+*/
+
+/* - Full Precision Instance Record - */
+
+//Matches "struct Instance" in pull.vs (std430) and two RGBA32F texels in the texture buffer path
+struct InstanceRecord {
+	vec2 offset;
+	vec2 size;
+	vec4 color;
+};
+
+static_assert(sizeof(InstanceRecord) == 8 * sizeof(float), "InstanceRecord must stay tightly packed for pull.vs");
+
+//Texels per Record in the Texture Buffer Path
+const unsigned int INSTANCE_RECORD_TEXELS = sizeof(InstanceRecord) / sizeof(vec4);
+
+//Shapes Generated from gl_VertexID
+enum InstanceShape {
+	SHAPE_QUAD = 0,
+	SHAPE_CIRCLE = 1
+};
+
+/* - Quantized Instance Record - */
+
+//12 bytes against 32 for InstanceRecord, decoded by pull.vs with PACKED_INSTANCES
+struct PackedInstance {
+	uint32_t pos;	//x | y << 16, unsigned normalized over the arena
+	uint32_t color;	//RGBA8, red in the low byte
+	uint32_t attr;	//size class | shape << 8
+};
+
+static_assert(sizeof(PackedInstance) == 12, "PackedInstance must stay 3 words for pull.vs");
+
+//Words per Record in the Texture Buffer Path (R32UI)
+const unsigned int PACKED_INSTANCE_TEXELS = sizeof(PackedInstance) / sizeof(uint32_t);
+
+//Sizes Referenced by 8-bit Size Class, Uploaded Once as a Uniform Array
+const unsigned int MAX_SIZE_CLASSES = 256;
+
+struct SizeClassTable {
+	vec2 sizes[MAX_SIZE_CLASSES];
+	unsigned int count = 0;
+};
+
+//Find or Add the Class for a Size, Class 0 when the Table is Full
+inline uint8_t getSizeClass(SizeClassTable& table, vec2 size)
+{
+	for (unsigned int i = 0; i < table.count; i++) {
+		if (table.sizes[i].x == size.x && table.sizes[i].y == size.y) {
+			return (uint8_t)i;
+		}
+	}
+	if (table.count == MAX_SIZE_CLASSES) {
+		return 0;
+	}
+	table.sizes[table.count] = size;
+	return (uint8_t)table.count++;
+}
+
+//Attribute Word from Size Class and Shape
+inline uint32_t packInstanceAttr(uint8_t sizeClass, InstanceShape shape)
+{
+	return (uint32_t)sizeClass | ((uint32_t)shape << 8);
+}
+
+//Quantize to [0, max] with Round to Nearest
+inline uint32_t quantizeUnorm(float v, float max)
+{
+	v = v * max + 0.5f;
+	v = v < 0.0f ? 0.0f : (v > max ? max : v);
+	return (uint32_t)v;
+}
+
+//Pack One Record
+inline PackedInstance packInstance(const InstanceRecord& src, uint32_t attr, vec2 invArena)
+{
+	PackedInstance ret;
+	ret.pos = quantizeUnorm(src.offset.x * invArena.x, 65535.0f)
+		| (quantizeUnorm(src.offset.y * invArena.y, 65535.0f) << 16);
+	ret.color = quantizeUnorm(src.color.x, 255.0f)
+		| (quantizeUnorm(src.color.y, 255.0f) << 8)
+		| (quantizeUnorm(src.color.z, 255.0f) << 16)
+		| (quantizeUnorm(src.color.w, 255.0f) << 24);
+	ret.attr = attr;
+	return ret;
+}
+
+//Pack Records, Four at a Time with SSE2 (sizes are carried by attrs, not re-quantized)
+inline void packInstances(const InstanceRecord* src, const uint32_t* attrs, unsigned int noInstances, vec2 arenaSize, PackedInstance* dst)
+{
+	vec2 invArena = { 1.0f / arenaSize.x, 1.0f / arenaSize.y };
+	unsigned int i = 0;
+
+#ifdef INSTANCES_SSE2
+	const __m128 invArenaPair = _mm_setr_ps(invArena.x, invArena.y, invArena.x, invArena.y);
+	const __m128 colorScale = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 posMax = _mm_set1_ps(65535.0f);
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i flip = _mm_set1_epi16((short)0x8000);
+
+	for (; i + 4 <= noInstances; i += 4) {
+		//Offsets of Records i..i+3 as [x0 y0 x1 y1], [x2 y2 x3 y3]
+		__m128 r0 = _mm_loadu_ps(&src[i + 0].offset.x);
+		__m128 r1 = _mm_loadu_ps(&src[i + 1].offset.x);
+		__m128 r2 = _mm_loadu_ps(&src[i + 2].offset.x);
+		__m128 r3 = _mm_loadu_ps(&src[i + 3].offset.x);
+		__m128 p01 = _mm_movelh_ps(r0, r1);
+		__m128 p23 = _mm_movelh_ps(r2, r3);
+
+		//Same operation order as quantizeUnorm so both paths give identical words
+		p01 = _mm_mul_ps(_mm_mul_ps(p01, invArenaPair), posMax);
+		p23 = _mm_mul_ps(_mm_mul_ps(p23, invArenaPair), posMax);
+		p01 = _mm_min_ps(_mm_max_ps(_mm_add_ps(p01, half), zero), posMax);
+		p23 = _mm_min_ps(_mm_max_ps(_mm_add_ps(p23, half), zero), posMax);
+
+		//Unsigned 16-bit Pack via Biased Signed Saturation, Each 32-bit Lane Becomes x | y << 16
+		__m128i q01 = _mm_sub_epi32(_mm_cvttps_epi32(p01), bias);
+		__m128i q23 = _mm_sub_epi32(_mm_cvttps_epi32(p23), bias);
+		__m128i pos = _mm_xor_si128(_mm_packs_epi32(q01, q23), flip);
+
+		//Colours as RGBA8 Words
+		__m128i c0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&src[i + 0].color.x), colorScale), half));
+		__m128i c1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&src[i + 1].color.x), colorScale), half));
+		__m128i c2 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&src[i + 2].color.x), colorScale), half));
+		__m128i c3 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&src[i + 3].color.x), colorScale), half));
+		__m128i color = _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+
+		//Interleave into the 12-byte Records
+		alignas(16) uint32_t posWords[4];
+		alignas(16) uint32_t colorWords[4];
+		_mm_store_si128((__m128i*)posWords, pos);
+		_mm_store_si128((__m128i*)colorWords, color);
+		for (unsigned int j = 0; j < 4; j++) {
+			dst[i + j].pos = posWords[j];
+			dst[i + j].color = colorWords[j];
+			dst[i + j].attr = attrs[i + j];
+		}
+	}
+#endif
+
+	for (; i < noInstances; i++) {
+		dst[i] = packInstance(src[i], attrs[i], invArena);
+	}
+}
+
+/* - Dense Instance Arrays - */
+
+//Slot of an Instance that has been Removed
+const uint32_t DENSE_REMOVED = 0xFFFFFFFF;
+
+//Live Instances Packed at the Front of one or more Parallel Arrays, so a Single Draw of noLive Covers them
+struct DenseInstances {
+	std::vector<uint32_t> slotOf;	//Slot per Instance Id
+	std::vector<uint32_t> idOf;		//Instance Id per Slot
+	uint32_t noLive;
+
+	//Slots Rewritten since the Last Flush
+	std::vector<uint32_t> patches;
+};
+
+//Record Moved by a Removal, Applied to every Parallel Array
+struct DenseMove {
+	uint32_t from;
+	uint32_t to;
+};
+
+//Instance i Starts in Slot i
+inline void initDenseInstances(DenseInstances& dense, uint32_t noInstances)
+{
+	dense.slotOf.resize(noInstances);
+	dense.idOf.resize(noInstances);
+	for (uint32_t i = 0; i < noInstances; i++) {
+		dense.slotOf[i] = dense.idOf[i] = i;
+	}
+	dense.noLive = noInstances;
+	dense.patches.clear();
+}
+
+//Remove Instance id by Moving the Last Live Slot into its Gap; false if Nothing has to Move
+inline bool removeDense(DenseInstances& dense, uint32_t id, DenseMove& move)
+{
+	uint32_t slot = dense.slotOf[id];
+	if (slot == DENSE_REMOVED) {
+		return false;
+	}
+
+	uint32_t last = --dense.noLive;
+	dense.slotOf[id] = DENSE_REMOVED;
+	if (slot == last) {
+		return false;
+	}
+
+	uint32_t movedId = dense.idOf[last];
+	dense.idOf[slot] = movedId;
+	dense.slotOf[movedId] = slot;
+	dense.patches.push_back(slot);
+	move = { last, slot };
+	return true;
+}
+
+template<typename T>
+void applyDenseMove(T* records, const DenseMove& move)
+{
+	records[move.to] = records[move.from];
+}
+
+//Call onRun(first, count) for each Run of Adjacent Patched Slots still Live, then Clear the Patches
+template<typename F>
+void flushDensePatches(DenseInstances& dense, F onRun)
+{
+	std::vector<uint32_t>& patches = dense.patches;
+	std::sort(patches.begin(), patches.end());
+	patches.erase(std::unique(patches.begin(), patches.end()), patches.end());
+
+	//Slots Past noLive were Moved Again Later in the Frame and are no Longer Drawn
+	size_t i = 0;
+	while (i < patches.size() && patches[i] < dense.noLive) {
+		uint32_t first = patches[i];
+		uint32_t count = 1;
+		while (i + count < patches.size() && patches[i + count] == first + count && first + count < dense.noLive) {
+			count++;
+		}
+		onRun(first, count);
+		i += count;
+	}
+	patches.clear();
+}
+
+#endif
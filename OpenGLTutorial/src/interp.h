@@ -0,0 +1,204 @@
+#ifndef INTERP_H
+#define INTERP_H
+
+#include "net.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/*
+	Smooth drawing of server snapshots. Snapshots are held in a jitter
+	buffer and drawn a little in the past, interpolating between the two
+	either side of the drawn time. How far in the past adapts to the
+	network: the buffer tracks how late each snapshot arrives compared to
+	the earliest one could, and waits long enough to cover all but the
+	latest few. When the next snapshot has not arrived in time, balls are
+	extrapolated along their velocity for a short while instead.
+*/
+
+/* - Jitter Buffer - */
+
+const uint32_t JITTER_CAPACITY = 32;
+
+struct JitterParams {
+	float deviations = 2.5f;			//Standard Deviations of Arrival Lateness the Delay Covers
+	float offsetCreep = 0.001f;			//Seconds per Second the Base Latency Estimate Rises, so it Follows Clock Drift and Route Changes
+	float growSeconds = 0.1f;			//Time to Close most of the Gap when the Delay has to Grow
+	float shrinkSeconds = 2.0f;			//And when it can Shrink, Slower so a Brief Calm does not Invite the Next Stall
+	float maxWarp = 0.25f;				//Fastest the Delay Changes, Seconds per Second, so Play Slows or Hurries but never Runs Backwards
+	float maxExtrapolation = 0.1f;		//Seconds Balls are Carried Past the Newest Snapshot
+};
+
+struct JitterBuffer {
+	SnapshotPacket snapshots[JITTER_CAPACITY];	//Sorted by Tick
+	uint32_t noSnapshots = 0;
+	float tickRate = 1000.0f;
+	bool started = false;
+
+	//Arrival Model, in Seconds of Local Clock
+	double offset = 0.0;		//Least Arrival Time minus Server Time, the Latency with no Queueing
+	double lastArrival = 0.0;
+	double lateMean = 0.0;		//Arrival Time past the Offset, Smoothed
+	double lateVar = 0.0;
+	double interval = 0.0;		//Server Time between Snapshots, Smoothed
+	double delay = 0.0;			//Current Playout Delay past the Offset
+	double lastSample = 0.0;
+
+	//Counters, for Reporting
+	uint64_t noReceived = 0;
+	uint64_t noLate = 0;			//Arrived after its Time had been Drawn
+	uint64_t noFrames = 0;
+	uint64_t noExtrapolated = 0;	//Frames Drawn Past the Newest Snapshot
+};
+
+inline void initJitterBuffer(JitterBuffer& buffer, float tickRate)
+{
+	buffer = JitterBuffer();
+	buffer.tickRate = tickRate;
+}
+
+//Server Time the Buffer Draws at the Local Time
+inline double playoutTime(const JitterBuffer& buffer, double time)
+{
+	return time - buffer.offset - buffer.delay;
+}
+
+//Delay that would Cover the Lateness Measured so Far, Plus One Interval so there is a Snapshot Either Side
+inline double targetDelay(const JitterBuffer& buffer, const JitterParams& params)
+{
+	return buffer.lateMean + params.deviations * sqrt(buffer.lateVar) + buffer.interval;
+}
+
+//Add a Snapshot Arriving at the Local Time; Duplicates and ones Older than what is Drawn are Dropped
+inline void pushSnapshot(JitterBuffer& buffer, const SnapshotPacket& packet, double time, const JitterParams& params)
+{
+	buffer.noReceived++;
+	double serverTime = packet.tick / buffer.tickRate;
+	double sample = time - serverTime;
+	if (!buffer.started) {
+		buffer.started = true;
+		buffer.offset = sample;
+		buffer.lastArrival = time;
+		buffer.lastSample = time;
+	}
+
+	//Lowest Latency Seen, Allowed to Creep Up
+	buffer.offset = std::min(sample, buffer.offset + params.offsetCreep * (time - buffer.lastArrival));
+	buffer.lastArrival = time;
+
+	//Smoothed as in RTP's Jitter Estimate (RFC 3550), Variance Alongside
+	double late = sample - buffer.offset;
+	double deviation = late - buffer.lateMean;
+	buffer.lateMean += deviation / 16.0;
+	buffer.lateVar += (deviation * deviation - buffer.lateVar) / 16.0;
+
+	//Already Drawn Past, Too Late to Help
+	if (buffer.noSnapshots > 0 && serverTime <= playoutTime(buffer, time) && packet.tick < buffer.snapshots[buffer.noSnapshots - 1].tick) {
+		buffer.noLate++;
+		return;
+	}
+
+	//Insert in Tick Order, Reordered Packets Included
+	uint32_t at = buffer.noSnapshots;
+	while (at > 0 && buffer.snapshots[at - 1].tick > packet.tick) {
+		at--;
+	}
+	if (at > 0 && buffer.snapshots[at - 1].tick == packet.tick) {
+		return;
+	}
+	if (at == buffer.noSnapshots && buffer.noSnapshots > 0) {
+		double gap = (packet.tick - buffer.snapshots[at - 1].tick) / buffer.tickRate;
+		buffer.interval = buffer.interval == 0.0 ? gap : buffer.interval + (gap - buffer.interval) / 16.0;
+	}
+	if (buffer.noSnapshots == JITTER_CAPACITY) {
+		if (at == 0) {
+			return;
+		}
+		std::copy(buffer.snapshots + 1, buffer.snapshots + at, buffer.snapshots);
+		at--;
+		buffer.noSnapshots--;
+	}
+	std::copy_backward(buffer.snapshots + at, buffer.snapshots + buffer.noSnapshots, buffer.snapshots + buffer.noSnapshots + 1);
+	buffer.snapshots[at] = packet;
+	buffer.noSnapshots++;
+}
+
+//Balls Served Again Jump Across the Arena, and are Snapped rather than Swept there
+inline bool ballJumped(const Ball& a, const Ball& b, float seconds)
+{
+	float speed = std::max(length(a.vel), length(b.vel));
+	float reach = speed * seconds * 1.5f + 1.0f;
+	return lengthSq(b.pos - a.pos) > reach * reach;
+}
+
+//Positions to Draw at the Local Time; Returns the Number of Balls, 0 before the First Snapshot
+inline uint32_t sampleJitterBuffer(JitterBuffer& buffer, double time, const JitterParams& params, vec2* paddles, vec2* balls)
+{
+	if (buffer.noSnapshots == 0) {
+		return 0;
+	}
+
+	//Grow the Delay Quickly and Shrink it Slowly, by Warping the Speed of Play
+	double elapsed = std::max(0.0, time - buffer.lastSample);
+	buffer.lastSample = time;
+	double target = targetDelay(buffer, params);
+	double seconds = target > buffer.delay ? params.growSeconds : params.shrinkSeconds;
+	double change = (target - buffer.delay) * std::min(1.0, elapsed / seconds);
+	buffer.delay += std::max(-params.maxWarp * elapsed, std::min(params.maxWarp * elapsed, change));
+	buffer.noFrames++;
+
+	//Snapshots Either Side of the Drawn Time, Keeping One Before it
+	double tick = playoutTime(buffer, time) * buffer.tickRate;
+	uint32_t next = 0;
+	while (next < buffer.noSnapshots && buffer.snapshots[next].tick <= tick) {
+		next++;
+	}
+	if (next > 1) {
+		std::copy(buffer.snapshots + next - 1, buffer.snapshots + buffer.noSnapshots, buffer.snapshots);
+		buffer.noSnapshots -= next - 1;
+		next = 1;
+	}
+
+	//Before the Oldest, as when Starting; Drawn as it is
+	const SnapshotPacket& a = buffer.snapshots[next == 0 ? 0 : next - 1];
+	if (next == 0) {
+		paddles[0] = a.paddles[0];
+		paddles[1] = a.paddles[1];
+		for (uint32_t i = 0; i < a.noBalls; i++) {
+			balls[i] = a.balls[i].pos;
+		}
+		return a.noBalls;
+	}
+
+	//Past the Newest, Paddles Hold and Balls Carry On for a While
+	if (next == buffer.noSnapshots) {
+		buffer.noExtrapolated++;
+		float ahead = (float)std::min((double)params.maxExtrapolation, (tick - a.tick) / buffer.tickRate);
+		paddles[0] = a.paddles[0];
+		paddles[1] = a.paddles[1];
+		for (uint32_t i = 0; i < a.noBalls; i++) {
+			balls[i] = a.balls[i].pos + a.balls[i].vel * ahead;
+		}
+		return a.noBalls;
+	}
+
+	const SnapshotPacket& b = buffer.snapshots[next];
+	float t = (float)((tick - a.tick) / (double)(b.tick - a.tick));
+	float span = (b.tick - a.tick) / buffer.tickRate;
+	lerpPoints(paddles, a.paddles, b.paddles, t, 2);
+	uint32_t noBalls = std::min(a.noBalls, b.noBalls);
+	for (uint32_t i = 0; i < noBalls; i++) {
+		const Ball& from = a.balls[i];
+		const Ball& to = b.balls[i];
+		if (ballJumped(from, to, span)) {
+			balls[i] = t < 0.5f ? from.pos : to.pos;
+		}
+		else {
+			balls[i] = lerp(from.pos, to.pos, t);
+		}
+	}
+	return noBalls;
+}
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "vecmath.h"
+#include "instances.h"
+#include "fixed.h"
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/*
+	Obstacles between the paddles and the bounding volume hierarchy the
+	ball is tested against. The BVH is built once, when a level is generated
+	or compiled; building reorders the obstacles so every leaf covers a
+	contiguous run of them.
+
+	Level only points at its arrays, so they can live in the owned vectors
+	or directly in a mapped level file (see level_file.h).
+*/
+
+/* - Level Data - */
+
+//Hit Points of Obstacles that Cannot be Destroyed (bumpers)
+const uint32_t OBSTACLE_STATIC = 0xFFFFFFFF;
+
+struct Obstacle {
+	AABB box;
+	uint32_t hp;
+};
+
+//Internal Nodes have count 0 and Children at first and first + 1, Leaves Cover Obstacles [first, first + count)
+struct BVHNode {
+	AABB box;
+	uint32_t first;
+	uint32_t count;
+};
+
+//Obstacles per Leaf
+const uint32_t BVH_LEAF_SIZE = 4;
+
+//Deepest Path the Builder Produces for 32-bit Obstacle Counts, with Headroom
+const uint32_t BVH_MAX_DEPTH = 64;
+
+struct Level {
+	const Obstacle* obstacles = NULL;
+	uint32_t noObstacles = 0;
+	const BVHNode* nodes = NULL;
+	uint32_t noNodes = 0;
+
+	//One Render Record per Obstacle, in the same Order
+	InstanceRecord* records = NULL;
+
+	//Storage for Levels Built in Memory, Empty for Mapped Levels
+	std::vector<Obstacle> obstacleStore;
+	std::vector<BVHNode> nodeStore;
+	std::vector<InstanceRecord> recordStore;
+};
+
+//Point a Level at its Owned Storage
+inline void bindLevelStorage(Level& level)
+{
+	level.obstacles = level.obstacleStore.data();
+	level.noObstacles = (uint32_t)level.obstacleStore.size();
+	level.nodes = level.nodeStore.data();
+	level.noNodes = (uint32_t)level.nodeStore.size();
+	level.records = level.recordStore.data();
+}
+
+/* - BVH Construction - */
+
+//Box Centre along an Axis (times two, only used for ordering)
+inline float centroid(const AABB& box, int axis)
+{
+	return axis == 0 ? box.min.x + box.max.x : box.min.y + box.max.y;
+}
+
+//Split Obstacles [first, first + count) into a Subtree at Node idx
+inline void buildBVHNode(std::vector<Obstacle>& obstacles, std::vector<BVHNode>& nodes, uint32_t idx, uint32_t first, uint32_t count)
+{
+	AABB bounds = obstacles[first].box;
+	AABB centres = { { centroid(bounds, 0), centroid(bounds, 1) }, { centroid(bounds, 0), centroid(bounds, 1) } };
+	for (uint32_t i = first + 1; i < first + count; i++) {
+		const AABB& box = obstacles[i].box;
+		bounds = merge(bounds, box);
+		AABB c = { { centroid(box, 0), centroid(box, 1) }, { centroid(box, 0), centroid(box, 1) } };
+		centres = merge(centres, c);
+	}
+	nodes[idx].box = bounds;
+
+	if (count <= BVH_LEAF_SIZE) {
+		nodes[idx].first = first;
+		nodes[idx].count = count;
+		return;
+	}
+
+	//Median Split along the Axis with the Widest Spread of Centres
+	int axis = (centres.max.x - centres.min.x) >= (centres.max.y - centres.min.y) ? 0 : 1;
+	uint32_t half = count / 2;
+	std::nth_element(obstacles.begin() + first, obstacles.begin() + first + half, obstacles.begin() + first + count,
+		[axis](const Obstacle& a, const Obstacle& b) { return centroid(a.box, axis) < centroid(b.box, axis); });
+
+	uint32_t left = (uint32_t)nodes.size();
+	nodes.push_back(BVHNode());
+	nodes.push_back(BVHNode());
+	nodes[idx].first = left;
+	nodes[idx].count = 0;
+
+	buildBVHNode(obstacles, nodes, left, first, half);
+	buildBVHNode(obstacles, nodes, left + 1, first + half, count - half);
+}
+
+//Render Record for an Obstacle, Bumpers Grey and Bricks Orange
+inline InstanceRecord obstacleRecord(const Obstacle& obstacle)
+{
+	const AABB& box = obstacle.box;
+	InstanceRecord ret;
+	ret.offset = { (box.min.x + box.max.x) / 2.0f, (box.min.y + box.max.y) / 2.0f };
+	ret.size = { box.max.x - box.min.x, box.max.y - box.min.y };
+	ret.color = obstacle.hp == OBSTACLE_STATIC ? vec4{ 0.5f, 0.5f, 0.5f, 1.0f } : vec4{ 1.0f, 0.6f, 0.2f, 1.0f };
+	return ret;
+}
+
+//Build the Hierarchy and Render Records over level.obstacleStore, Reordering it, then Bind the Storage
+inline void buildLevel(Level& level)
+{
+	level.nodeStore.clear();
+	level.recordStore.clear();
+	if (!level.obstacleStore.empty()) {
+		//A Binary Tree with Leaves of up to BVH_LEAF_SIZE has Fewer than 2n Nodes
+		level.nodeStore.reserve(2 * level.obstacleStore.size() / BVH_LEAF_SIZE + 1);
+		level.nodeStore.push_back(BVHNode());
+		buildBVHNode(level.obstacleStore, level.nodeStore, 0, 0, (uint32_t)level.obstacleStore.size());
+
+		level.recordStore.reserve(level.obstacleStore.size());
+		for (const Obstacle& obstacle : level.obstacleStore) {
+			level.recordStore.push_back(obstacleRecord(obstacle));
+		}
+	}
+	bindLevelStorage(level);
+}
+
+/* - BVH Validation - */
+
+//Whether a Hierarchy from Outside (a level file) is Safe to Query: Leaves Inside the Obstacles, every Node but
+//the Root the Child of Exactly One Interior Node Earlier in the Array, and no Deeper than queryBVH's Stack
+inline bool validateBVH(const Level& level)
+{
+	if (level.noNodes == 0) {
+		return true;
+	}
+
+	std::vector<uint32_t> depth(level.noNodes, 0);
+	depth[0] = 1;
+	for (uint32_t i = 0; i < level.noNodes; i++) {
+		const BVHNode& node = level.nodes[i];
+
+		//Only Reached through a Parent, so a Node Nobody Claimed is Unreachable or Shared
+		if (depth[i] == 0) {
+			return false;
+		}
+
+		if (node.count > 0) {
+			if (node.count > level.noObstacles || node.first > level.noObstacles - node.count) {
+				return false;
+			}
+			continue;
+		}
+
+		if (node.first <= i || node.first >= level.noNodes - 1 || depth[i] >= BVH_MAX_DEPTH) {
+			return false;
+		}
+		for (uint32_t child = node.first; child < node.first + 2; child++) {
+			if (depth[child] != 0) {
+				return false;
+			}
+			depth[child] = depth[i] + 1;
+		}
+	}
+	return true;
+}
+
+/* - BVH Queries - */
+
+//Call onHit(obstacleIdx) for Every Obstacle whose Box Overlaps box
+template<typename F>
+void queryBVH(const Level& level, const AABB& box, F onHit)
+{
+	if (level.noNodes == 0) {
+		return;
+	}
+
+	uint32_t stack[BVH_MAX_DEPTH];
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top > 0) {
+		const BVHNode& node = level.nodes[stack[--top]];
+		if (!overlaps(node.box, box)) {
+			continue;
+		}
+
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				if (overlaps(level.obstacles[i].box, box)) {
+					onHit(i);
+				}
+			}
+		}
+		else {
+			stack[top++] = node.first;
+			stack[top++] = node.first + 1;
+		}
+	}
+}
+
+/* - Level Generation - */
+
+//Fill the Area between the Paddles with a Grid of Bricks, with a Static Bumper on every 12th Row and Column
+inline void genBrickLevel(Level& level, uint32_t noObstacles, float arenaWidth, float arenaHeight)
+{
+	level.obstacleStore.clear();
+	if (noObstacles == 0) {
+		buildLevel(level);
+		return;
+	}
+
+	//Middle 60% of the Arena, Cells Kept Roughly Square
+	float width = arenaWidth * 0.6f;
+	uint32_t cols = (uint32_t)ceilf(sqrtf(noObstacles * width / arenaHeight));
+	uint32_t rows = (noObstacles + cols - 1) / cols;
+
+	//Corners Worked Out in Fixed Point, so Compilers Fusing Multiply-Adds cannot Move Bricks between Builds
+	fixed left = toFixed(arenaWidth * 0.2f);
+	fixed cellWidth = toFixed((double)width / cols);
+	fixed cellHeight = toFixed((double)arenaHeight / rows);
+	fixed insetX = cellWidth / 10;
+	fixed insetY = cellHeight / 10;
+
+	level.obstacleStore.reserve(noObstacles);
+	for (uint32_t i = 0; i < noObstacles; i++) {
+		uint32_t col = i % cols;
+		uint32_t row = i / cols;
+
+		fixed x = left + (fixed)col * cellWidth;
+		fixed y = (fixed)row * cellHeight;
+
+		Obstacle obstacle;
+		obstacle.box.min = { fromFixed(x + insetX), fromFixed(y + insetY) };
+		obstacle.box.max = { fromFixed(x + cellWidth - insetX), fromFixed(y + cellHeight - insetY) };
+		obstacle.hp = (row % 12 == 6 && col % 12 == 6) ? OBSTACLE_STATIC : 1;
+		level.obstacleStore.push_back(obstacle);
+	}
+
+	buildLevel(level);
+}
+
+#endif
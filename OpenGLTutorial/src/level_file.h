@@ -0,0 +1,172 @@
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include "level.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+/*
+	Binary level files: a header followed by the obstacle, BVH node and
+	render record arrays exactly as Level uses them, each section 64-byte
+	aligned. Loading maps the file and points a Level at the sections, so
+	nothing is parsed or copied; records can go straight to genBufferObject.
+	Files are little-endian and written by tools/levelc.
+*/
+
+/* - Format - */
+
+const char LEVEL_FILE_MAGIC[4] = { 'P', 'L', 'V', 'L' };
+const uint32_t LEVEL_FILE_VERSION = 1;
+const uint64_t LEVEL_FILE_ALIGNMENT = 64;
+
+struct LevelFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t noObstacles;
+	uint32_t noNodes;
+	float arenaWidth;
+	float arenaHeight;
+	uint32_t reserved;
+
+	//Byte Offsets from the Start of the File
+	uint64_t obstaclesOffset;
+	uint64_t nodesOffset;
+	uint64_t recordsOffset;
+	uint64_t fileSize;
+};
+
+static_assert(sizeof(LevelFileHeader) == 64, "LevelFileHeader layout is part of the file format");
+
+//Round up to the Section Alignment
+inline uint64_t alignLevelOffset(uint64_t offset)
+{
+	return (offset + LEVEL_FILE_ALIGNMENT - 1) & ~(LEVEL_FILE_ALIGNMENT - 1);
+}
+
+/* - Writing - */
+
+//Write a Built Level and the Arena it was Made for
+inline bool writeLevelFile(const char* path, const Level& level, float arenaWidth, float arenaHeight)
+{
+	LevelFileHeader header = {};
+	memcpy(header.magic, LEVEL_FILE_MAGIC, 4);
+	header.version = LEVEL_FILE_VERSION;
+	header.headerSize = sizeof(LevelFileHeader);
+	header.noObstacles = level.noObstacles;
+	header.noNodes = level.noNodes;
+	header.arenaWidth = arenaWidth;
+	header.arenaHeight = arenaHeight;
+	header.obstaclesOffset = alignLevelOffset(sizeof(LevelFileHeader));
+	header.nodesOffset = alignLevelOffset(header.obstaclesOffset + level.noObstacles * sizeof(Obstacle));
+	header.recordsOffset = alignLevelOffset(header.nodesOffset + level.noNodes * sizeof(BVHNode));
+	header.fileSize = header.recordsOffset + level.noObstacles * sizeof(InstanceRecord);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	//Sections with Zero Padding up to each Offset
+	const char zeros[LEVEL_FILE_ALIGNMENT] = {};
+	uint64_t pos = 0;
+	auto writeSection = [&](uint64_t offset, const void* data, uint64_t size) {
+		file.write(zeros, offset - pos);
+		file.write((const char*)data, size);
+		pos = offset + size;
+	};
+	writeSection(0, &header, sizeof(header));
+	writeSection(header.obstaclesOffset, level.obstacles, level.noObstacles * sizeof(Obstacle));
+	writeSection(header.nodesOffset, level.nodes, level.noNodes * sizeof(BVHNode));
+	writeSection(header.recordsOffset, level.records, level.noObstacles * sizeof(InstanceRecord));
+
+	return file.good();
+}
+
+/* - Loading - */
+
+//Mapped Level File, Unmapped with unloadLevelFile
+struct LevelFile {
+	MappedFile mapped;
+	LevelFileHeader header;
+};
+
+//count Records of recordSize from offset End by fileSize
+inline bool levelSectionFits(uint64_t offset, uint64_t count, uint64_t recordSize, uint64_t fileSize)
+{
+	return offset <= fileSize && count <= (fileSize - offset) / recordSize;
+}
+
+//Map a Level File and Point level at its Sections; Records are Copy on Write so they can be Edited in Place
+inline bool loadLevelFile(LevelFile& file, Level& level, const char* path)
+{
+	if (!mapFile(file.mapped, path, true)) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	const char* base = (const char*)file.mapped.data;
+	if (file.mapped.size < sizeof(LevelFileHeader)) {
+		std::cout << path << " is not a level file" << std::endl;
+		unmapFile(file.mapped);
+		return false;
+	}
+	memcpy(&file.header, base, sizeof(LevelFileHeader));
+
+	const LevelFileHeader& header = file.header;
+	if (memcmp(header.magic, LEVEL_FILE_MAGIC, 4) != 0 || header.headerSize != sizeof(LevelFileHeader)) {
+		std::cout << path << " is not a level file" << std::endl;
+		unmapFile(file.mapped);
+		return false;
+	}
+	if (header.version != LEVEL_FILE_VERSION) {
+		std::cout << path << " is level format version " << header.version << ", expected " << LEVEL_FILE_VERSION << std::endl;
+		unmapFile(file.mapped);
+		return false;
+	}
+
+	//Every Section must be Aligned and Inside the File, Compared by Division so a Crafted Offset cannot Wrap
+	bool valid = header.fileSize <= file.mapped.size
+		&& header.obstaclesOffset % LEVEL_FILE_ALIGNMENT == 0
+		&& header.nodesOffset % LEVEL_FILE_ALIGNMENT == 0
+		&& header.recordsOffset % LEVEL_FILE_ALIGNMENT == 0
+		&& levelSectionFits(header.obstaclesOffset, header.noObstacles, sizeof(Obstacle), header.fileSize)
+		&& levelSectionFits(header.nodesOffset, header.noNodes, sizeof(BVHNode), header.fileSize)
+		&& levelSectionFits(header.recordsOffset, header.noObstacles, sizeof(InstanceRecord), header.fileSize);
+	if (!valid) {
+		std::cout << path << " is truncated or corrupt" << std::endl;
+		unmapFile(file.mapped);
+		return false;
+	}
+
+	level.obstacleStore.clear();
+	level.nodeStore.clear();
+	level.recordStore.clear();
+	level.obstacles = (const Obstacle*)(base + header.obstaclesOffset);
+	level.noObstacles = header.noObstacles;
+	level.nodes = (const BVHNode*)(base + header.nodesOffset);
+	level.noNodes = header.noNodes;
+	level.records = (InstanceRecord*)(base + header.recordsOffset);
+
+	//Node Contents Steer Indexing in queryBVH, so they are Checked too
+	if (!validateBVH(level)) {
+		std::cout << path << " has a corrupt bounding volume hierarchy" << std::endl;
+		level = Level();
+		unmapFile(file.mapped);
+		return false;
+	}
+	return true;
+}
+
+//Release a Mapped Level; Levels Pointing into it must not be Used Afterwards
+inline void unloadLevelFile(LevelFile& file)
+{
+	unmapFile(file.mapped);
+}
+
+#endif
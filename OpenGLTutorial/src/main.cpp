@@ -1,10 +1,27 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "gl_caps.h"
+#include "vecmath.h"
+#include "instances.h"
+#include "sim.h"
+#include "level_file.h"
+#include "replay.h"
+#include "interp.h"
+#include "udp.h"
+
+#include <cmath>
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 // Settings
 unsigned int scrWidth = 800;
@@ -12,25 +29,15 @@ unsigned int scrHeight = 600;
 const char* title = "Pong";
 GLuint shaderProgram;
 
-//Graphics Parameters
-const float PADDLE_SPEED = 175.0f;
-const float PADDLE_HEIGHT = 100.0f;
-const float PADDLE_WIDTH = 10.0f;
-const float HALF_PADDLE_HEIGHT = PADDLE_HEIGHT / 2.0f;
-const float HALF_PADDLE_WIDTH = PADDLE_WIDTH / 2.0f;
-const float BALL_DIAMETER = 16.0f;
-const float BALL_RADIUS = BALL_DIAMETER / 2.0f;
-const float PADDLE_OFFSET_BOUNDS = HALF_PADDLE_HEIGHT + BALL_RADIUS;
-
-/* - 2D Vector Structure - */
-struct vec2 {
-	float x;
-	float y;
-};
+//Bytes Sent through updateData, for --stats
+size_t uploadBytes = 0;
+
+//Game Parameters (arena size, paddle and ball dimensions and speeds)
+SimParams simParams;
 
 //Public Offsets Arrays
 vec2 paddleOffsets[2];
-vec2 ballOffsets[1];
+vec2 ballOffsets[MAX_BALLS];
 
 /* - Initialization Methods - */
 
@@ -65,7 +72,15 @@ void createWindow(GLFWwindow*& window, const char* title, unsigned int width, un
 //Load GLAD Library
 bool loadGLAD() 
 {
-	return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		return false;
+	}
+
+	//Load 4.x Entry Points and Select Fast Paths
+	detectGLCaps(glCaps);
+	reportGLCaps(glCaps);
+	enableGLFeatures(glCaps);
+	return true;
 }
 
 /* - Shader Methods - */
@@ -95,15 +110,15 @@ std::string readFile(const char* filename)
 	return ret;
 }
 
-//Generate Shader
-int genShader(const char* filepath, GLenum type) 
+//Generate Shader, Optionally Prefixed with a Header (#version and #defines)
+int genShader(const char* filepath, GLenum type, const char* header = "") 
 {
 	std::string shaderSrc = readFile(filepath);
-	const GLchar* shader = shaderSrc.c_str();
+	const GLchar* shader[] = { header, shaderSrc.c_str() };
 
 	//Build and Compile Shader
 	int shaderObj = glCreateShader(type);
-	glShaderSource(shaderObj, 1, &shader, NULL);
+	glShaderSource(shaderObj, 2, shader, NULL);
 	glCompileShader(shaderObj);
 
 	//Check for Errors
@@ -120,11 +135,11 @@ int genShader(const char* filepath, GLenum type)
 }
 
 //Generate Shader Program
-int genShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath) 
+int genShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, const char* vertexHeader = "") 
 {
 	int shaderProgram = glCreateProgram();
 
-	int vertexShader = genShader(vertexShaderPath, GL_VERTEX_SHADER);
+	int vertexShader = genShader(vertexShaderPath, GL_VERTEX_SHADER, vertexHeader);
 	int fragmentShader = genShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
 
 	if (vertexShader == -1 || fragmentShader == -1) {
@@ -159,18 +174,13 @@ void bindShader(int shaderProgram)
 }
 
 //Set Projection
-void setOrthographicProjection(int shaderProgram, float left, float right, float bottom, float top, float near, float far) 
+void setOrthographicProjection(int shaderProgram, float left, float right, float bottom, float top, float zNear, float zFar) 
 {
-	float mat[4][4] = {
-		{ 2.0f / (right - left), 0.0f, 0.0f, 0.0f },
-		{ 0.0f, 2.0f / (top - bottom), 0.0f, 0.0f },
-		{ 0.0f, 0.0f, -2.0f / (far - near), 0.0f },
-		{ -(right + left) / (right - left), -(top + bottom) / (top - bottom), -(far + near) / (far - near), 1.0f }
-	};
+	mat4 projection = orthographic(left, right, bottom, top, zNear, zFar);
 
 	//Bind Shader
 	bindShader(shaderProgram);
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, matrixData(projection));
 }
 
 //Delete Shader
@@ -190,17 +200,41 @@ struct VAO {
 	GLuint EBO;
 };
 
+//VAO that Buffer and Attribute Calls Apply to (set by genVAO)
+GLuint editVAO = 0;
+
+//VAO Currently Bound for Drawing
+GLuint boundVAO = 0;
+
 //Generate VAO
 void genVAO(VAO* vao) 
 {
-	glGenVertexArrays(1, &vao->val);
-	glBindVertexArray(vao->val);
+	if (glCaps.dsa) {
+		//DSA: Create without binding, later calls name the VAO directly
+		glCreateVertexArrays(1, &vao->val);
+	}
+	else {
+		glGenVertexArrays(1, &vao->val);
+		glBindVertexArray(vao->val);
+		boundVAO = vao->val;
+	}
+	editVAO = vao->val;
 }
 
 //Generate Buffer of Certain Type and Set Data
 template<typename T>
 void genBufferObject(GLuint& bo, GLenum type, GLuint noElements, T* data, GLenum usage) 
 {
+	if (glCaps.dsa) {
+		glCreateBuffers(1, &bo);
+		glNamedBufferData(bo, noElements * sizeof(T), data, usage);
+		if (type == GL_ELEMENT_ARRAY_BUFFER) {
+			//Element Buffer is VAO State
+			glVertexArrayElementBuffer(editVAO, bo);
+		}
+		return;
+	}
+
 	glGenBuffers(1, &bo);
 	glBindBuffer(type, bo);
 	glBufferData(type, noElements * sizeof(T), data, usage);
@@ -210,14 +244,52 @@ void genBufferObject(GLuint& bo, GLenum type, GLuint noElements, T* data, GLenum
 template<typename T>
 void updateData(GLuint& bo, GLintptr offset, GLuint noElements, T*data) 
 {
-	glBindBuffer(GL_ARRAY_BUFFER, bo);
-	glBufferSubData(GL_ARRAY_BUFFER, offset, noElements * sizeof(T), data);
+	uploadBytes += noElements * sizeof(T);
+
+	if (glCaps.dsa) {
+		glNamedBufferSubData(bo, offset, noElements * sizeof(T), data);
+		return;
+	}
+
+	//Copy Write Target Accepts any Buffer and Leaves the Array and VAO Bindings Untouched
+	glBindBuffer(GL_COPY_WRITE_BUFFER, bo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, noElements * sizeof(T), data);
+}
+
+//Re-specify Whole Buffer, Letting the Driver Orphan Storage Still in Use by the GPU
+template<typename T>
+void orphanData(GLuint& bo, GLuint noElements, T* data, GLenum usage)
+{
+	uploadBytes += noElements * sizeof(T);
+
+	if (glCaps.dsa) {
+		glNamedBufferData(bo, noElements * sizeof(T), NULL, usage);
+		glNamedBufferSubData(bo, 0, noElements * sizeof(T), data);
+		return;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, bo);
+	glBufferData(GL_COPY_WRITE_BUFFER, noElements * sizeof(T), NULL, usage);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, noElements * sizeof(T), data);
 }
 
 //Set Attribute Pointers
 template<typename T>
 void setAttPointer(GLuint& bo, GLuint idx, GLuint size, GLenum type, GLuint stride, GLuint offset, GLuint divisor = 0) 
 {
+	if (glCaps.dsa) {
+		//One binding point per attribute, matching the bind-to-edit layout
+		glVertexArrayVertexBuffer(editVAO, idx, bo, offset * sizeof(T), stride * sizeof(T));
+		glVertexArrayAttribFormat(editVAO, idx, size, type, GL_FALSE, 0);
+		glVertexArrayAttribBinding(editVAO, idx, idx);
+		glEnableVertexArrayAttrib(editVAO, idx);
+		if (divisor > 0) {
+			//Reset idx attribute every divisor iteration through instances
+			glVertexArrayBindingDivisor(editVAO, idx, divisor);
+		}
+		return;
+	}
+
 	glBindBuffer(GL_ARRAY_BUFFER, bo);
 	glVertexAttribPointer(idx, size, type, GL_FALSE, stride * sizeof(T), (void*)(offset * sizeof(T)));
 	glEnableVertexAttribArray(idx);
@@ -227,23 +299,81 @@ void setAttPointer(GLuint& bo, GLuint idx, GLuint size, GLenum type, GLuint stri
 	}
 }
 
+//Bind VAO, Skipping Redundant Binds
+void bindVAO(GLuint vao)
+{
+	if (boundVAO != vao) {
+		glBindVertexArray(vao);
+		boundVAO = vao;
+	}
+}
+
 //Draw VAO
 void draw(VAO vao, GLenum mode, GLuint count, GLenum type, GLint indices, GLuint instanceCount = 1) 
 {
-	glBindVertexArray(vao.val);
+	bindVAO(vao.val);
 	glDrawElementsInstanced(mode, count, type, (void*)indices, instanceCount);
 }
 
+/* - Indirect Draw Methods - */
+
+//Indexed Draw Parameters Laid Out as glMultiDrawElementsIndirect Reads them
+struct DrawElementsCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+//Draw Commands Kept in a Buffer Object, One per VAO, with Instance Counts Patched only when they Change
+struct IndirectDraws {
+	GLuint bo;
+	std::vector<DrawElementsCommand> commands;
+};
+
+//Generate Command Buffer (needs glCaps.indirectDraw)
+void genIndirectDraws(IndirectDraws& draws, const std::vector<DrawElementsCommand>& commands)
+{
+	draws.commands = commands;
+	genBufferObject<DrawElementsCommand>(draws.bo, GL_DRAW_INDIRECT_BUFFER, (GLuint)commands.size(), draws.commands.data(), GL_DYNAMIC_DRAW);
+}
+
+//Set Command idx's Instance Count, Uploading the Four Bytes only when it Changed
+void setDrawInstances(IndirectDraws& draws, GLuint idx, GLuint instanceCount)
+{
+	DrawElementsCommand& command = draws.commands[idx];
+	if (command.instanceCount != instanceCount) {
+		command.instanceCount = instanceCount;
+		updateData<GLuint>(draws.bo, idx * sizeof(DrawElementsCommand) + offsetof(DrawElementsCommand, instanceCount), 1, &command.instanceCount);
+	}
+}
+
+//Draw VAO with Command idx, Read by the GPU from the Command Buffer
+void drawIndirect(const IndirectDraws& draws, VAO vao, GLenum mode, GLuint idx)
+{
+	bindVAO(vao.val);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draws.bo);
+	glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (void*)(idx * sizeof(DrawElementsCommand)), 1, 0);
+}
+
+void cleanup(IndirectDraws& draws)
+{
+	glDeleteBuffers(1, &draws.bo);
+}
+
 //Unbind Buffer
 void unbindBuffer(GLenum type) 
 {
-	glBindBuffer(type, 0);
+	if (!glCaps.dsa) {
+		glBindBuffer(type, 0);
+	}
 }
 
 //Unbind VAO
 void unbindVAO() 
 {
-	glBindVertexArray(0);
+	bindVAO(0);
 }
 
 //Deallocate VAO/VBO Memory
@@ -256,6 +386,242 @@ void cleanup(VAO vao)
 	glDeleteVertexArrays(1, &vao.val);
 }
 
+/* - Instance Buffer Methods - */
+
+//CPU Copy of a Buffer Object's Instances, with a Dirty Flag per Page of Instances
+template<typename T>
+struct InstanceBuffer {
+	GLuint bo;
+	T* data;
+	GLuint noElements;
+	std::vector<bool> dirtyPages;
+	GLuint pageSize;
+	GLuint noDirtyPages;
+
+	//Owned Copy, Unused when Tracking Caller Storage
+	std::vector<T> store;
+};
+
+//Share of Dirty Pages above which the Whole Buffer is Re-specified Instead
+const float ORPHAN_THRESHOLD = 0.5f;
+
+//Track Caller Storage Matching a Buffer Object; only Edit it through setInstance Afterwards
+template<typename T>
+void initInstanceBufferInPlace(InstanceBuffer<T>& buf, GLuint bo, GLuint noElements, T* storage, GLuint pageSize)
+{
+	buf.bo = bo;
+	buf.data = storage;
+	buf.noElements = noElements;
+	buf.pageSize = pageSize;
+	buf.dirtyPages.assign((noElements + pageSize - 1) / pageSize, false);
+	buf.noDirtyPages = 0;
+}
+
+//Track an Existing Buffer Object that Already Holds initial, Keeping a Copy
+template<typename T>
+void initInstanceBuffer(InstanceBuffer<T>& buf, GLuint bo, GLuint noElements, const T* initial, GLuint pageSize)
+{
+	buf.store.assign(initial, initial + noElements);
+	initInstanceBufferInPlace(buf, bo, noElements, buf.store.data(), pageSize);
+}
+
+//Flag the Page Holding Instance idx
+template<typename T>
+void markDirty(InstanceBuffer<T>& buf, GLuint idx)
+{
+	GLuint page = idx / buf.pageSize;
+	if (!buf.dirtyPages[page]) {
+		buf.dirtyPages[page] = true;
+		buf.noDirtyPages++;
+	}
+}
+
+//Write Instance, only Dirtying its Page when the Value Changed
+template<typename T>
+void setInstance(InstanceBuffer<T>& buf, GLuint idx, const T& value)
+{
+	if (memcmp(&buf.data[idx], &value, sizeof(T)) != 0) {
+		buf.data[idx] = value;
+		markDirty(buf, idx);
+	}
+}
+
+//Upload Dirty Pages, Merging Runs of Adjacent Pages into One Upload
+template<typename T>
+void flushInstances(InstanceBuffer<T>& buf)
+{
+	if (buf.noDirtyPages == 0) {
+		return;
+	}
+
+	GLuint noElements = buf.noElements;
+	GLuint noPages = (GLuint)buf.dirtyPages.size();
+	if (buf.noDirtyPages > ORPHAN_THRESHOLD * noPages) {
+		orphanData<T>(buf.bo, noElements, buf.data, GL_DYNAMIC_DRAW);
+	}
+	else {
+		GLuint page = 0;
+		while (page < noPages) {
+			if (!buf.dirtyPages[page]) {
+				page++;
+				continue;
+			}
+
+			GLuint end = page;
+			while (end < noPages && buf.dirtyPages[end]) {
+				end++;
+			}
+
+			GLuint first = page * buf.pageSize;
+			GLuint last = std::min(end * buf.pageSize, noElements);
+			updateData<T>(buf.bo, first * sizeof(T), last - first, &buf.data[first]);
+			page = end;
+		}
+	}
+
+	std::fill(buf.dirtyPages.begin(), buf.dirtyPages.end(), false);
+	buf.noDirtyPages = 0;
+}
+
+/* - Vertex Pulling Methods - */
+
+//Regions of a Persistently Mapped Stream, One per Frame the GPU may Still be Reading and One to Write
+const GLuint STREAM_REGIONS = 3;
+
+//Instance Records Fetched by pull.vs, through an SSBO (4.3+) or a Texture Buffer (3.3)
+struct PulledInstances {
+	GLuint buffer;
+	GLuint texture;
+	GLuint capacity;
+	bool ssbo;
+	bool packed;
+
+	//Persistent Streams Only: Mapped Storage of STREAM_REGIONS x capacity Records, the Region being Written,
+	//and a Fence per Region for the Last Frame that Drew from it
+	char* mapped;
+	GLuint region;
+	GLsync fences[STREAM_REGIONS];
+};
+
+//Generate Instance Buffer and the View pull.vs Reads it Through; a Stream is Rewritten every Frame
+//through a Persistent Mapping instead of Uploads (needs glCaps.persistentMapping)
+void genPulledInstances(PulledInstances* instances, GLuint capacity, bool ssbo, bool packed, bool stream = false)
+{
+	instances->capacity = capacity;
+	instances->ssbo = ssbo;
+	instances->packed = packed;
+	instances->texture = 0;
+	instances->mapped = NULL;
+	instances->region = 0;
+	for (GLuint i = 0; i < STREAM_REGIONS; i++) {
+		instances->fences[i] = 0;
+	}
+
+	GLenum type = ssbo ? GL_SHADER_STORAGE_BUFFER : GL_TEXTURE_BUFFER;
+	GLsizeiptr recordSize = packed ? sizeof(PackedInstance) : sizeof(InstanceRecord);
+	if (stream) {
+		//Immutable Storage Stays Mapped; Coherent so Writes Land without Explicit Flushes
+		GLsizeiptr size = recordSize * capacity * STREAM_REGIONS;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		if (glCaps.dsa) {
+			glCreateBuffers(1, &instances->buffer);
+			glNamedBufferStorage(instances->buffer, size, NULL, flags);
+			instances->mapped = (char*)glMapNamedBufferRange(instances->buffer, 0, size, flags);
+		}
+		else {
+			glGenBuffers(1, &instances->buffer);
+			glBindBuffer(type, instances->buffer);
+			glBufferStorage(type, size, NULL, flags);
+			instances->mapped = (char*)glMapBufferRange(type, 0, size, flags);
+		}
+	}
+	else if (packed) {
+		genBufferObject<PackedInstance>(instances->buffer, type, capacity, NULL, GL_DYNAMIC_DRAW);
+	}
+	else {
+		genBufferObject<InstanceRecord>(instances->buffer, type, capacity, NULL, GL_DYNAMIC_DRAW);
+	}
+
+	if (!ssbo) {
+		glGenTextures(1, &instances->texture);
+		glBindTexture(GL_TEXTURE_BUFFER, instances->texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, packed ? GL_R32UI : GL_RGBA32F, instances->buffer);
+	}
+}
+
+//Upload the Size Class Table and Arena Size Packed Records are Decoded Against
+void setPackedDecode(int shaderProgram, const SizeClassTable& sizeClasses, vec2 arenaSize)
+{
+	//Two Classes per vec4, so an Odd Count Sends One Unused Entry of the Table Along
+	glUniform4fv(glGetUniformLocation(shaderProgram, "sizeClasses"), (sizeClasses.count + 1) / 2, &sizeClasses.sizes[0].x);
+	glUniform2f(glGetUniformLocation(shaderProgram, "arenaSize"), arenaSize.x, arenaSize.y);
+}
+
+//Bind Instance Records for the Bound Shader
+void bindPulledInstances(PulledInstances instances, int shaderProgram)
+{
+	if (instances.ssbo) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instances.buffer);
+	}
+	else {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, instances.texture);
+		glUniform1i(glGetUniformLocation(shaderProgram, "instances"), 0);
+	}
+}
+
+//Draw Instances with Corners Generated from gl_VertexID (no vertex buffers bound)
+void drawPulled(GLuint vao, int shaderProgram, InstanceShape shape, GLuint vertexCount, GLuint baseInstance, GLuint instanceCount, GLuint noSegments = 0)
+{
+	bindVAO(vao);
+	glUniform1i(glGetUniformLocation(shaderProgram, "shape"), shape);
+	glUniform1i(glGetUniformLocation(shaderProgram, "baseInstance"), baseInstance);
+	glUniform1i(glGetUniformLocation(shaderProgram, "noSegments"), noSegments);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instanceCount);
+}
+
+//Move a Stream on to its Next Region, Waiting until the GPU has Finished the Frame that Last Read it;
+//Returns the Region's First Record, to Add to the Base Instance of Draws from it
+GLuint beginStreamRegion(PulledInstances& instances)
+{
+	instances.region = (instances.region + 1) % STREAM_REGIONS;
+	GLsync& fence = instances.fences[instances.region];
+	if (fence) {
+		//Writing Sooner would Race the GPU, so Keep Waiting however Long it Takes
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+		}
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	return instances.region * instances.capacity;
+}
+
+//Write Records first to first + count - 1 of the Current Region
+template<typename T>
+void writeStream(PulledInstances& instances, GLuint first, GLuint count, const T* data)
+{
+	memcpy(instances.mapped + (instances.region * instances.capacity + first) * sizeof(T), data, count * sizeof(T));
+	uploadBytes += count * sizeof(T);
+}
+
+//Fence the Current Region once the Frame's Last Draw from it is Submitted
+void endStreamRegion(PulledInstances& instances)
+{
+	instances.fences[instances.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+//Deallocate Instance Buffer Memory
+void cleanup(PulledInstances instances)
+{
+	for (GLuint i = 0; i < STREAM_REGIONS; i++) {
+		if (instances.fences[i]) {
+			glDeleteSync(instances.fences[i]);
+		}
+	}
+	glDeleteTextures(1, &instances.texture);
+	glDeleteBuffers(1, &instances.buffer);
+}
+
 //Generate arrays for Circle Model
 void gen2DCircleArray(float*& vertices, unsigned int*& indices, unsigned int noTriangles, float radius = 0.5f) 
 {
@@ -297,46 +663,38 @@ void frameBufferSizeCallback(GLFWwindow* window, int width, int height)
 	scrWidth = width;
 	scrHeight = height;
 
-	//Update Projection Matrix
-	setOrthographicProjection(shaderProgram, 0, width, 0, height, 0.0f, 1.0f);
+	//Update Projection Matrix, the Arena Stays Fixed and is Scaled to the Window
+	setOrthographicProjection(shaderProgram, 0, simParams.arenaWidth, 0, simParams.arenaHeight, 0.0f, 1.0f);
 }
 
-//Process Input
-void processInput(GLFWwindow* window, double deltaTime, vec2 *paddleOffset) 
+//Process Input, Returning the Buttons Held
+uint8_t processInput(GLFWwindow* window) 
 {
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
 		glfwSetWindowShouldClose(window, true);
 	}
 
+	uint8_t buttons = 0;
+
 	//Left Paddle
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-		//Bounds
-		if (paddleOffset[0].y < scrHeight - PADDLE_OFFSET_BOUNDS) { 
-			paddleOffset[0].y += deltaTime * PADDLE_SPEED;
-		}
+		buttons |= INPUT_P0_UP;
 	}
 
 	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-		//Bounds
-		if (paddleOffset[0].y > PADDLE_OFFSET_BOUNDS) {
-			paddleOffset[0].y -= deltaTime * PADDLE_SPEED;
-		}	
+		buttons |= INPUT_P0_DOWN;
 	}
 
 	//Right Paddle
 	if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-		//Bounds
-		if (paddleOffset[1].y < scrHeight - PADDLE_OFFSET_BOUNDS) {
-			paddleOffset[1].y += deltaTime * PADDLE_SPEED;
-		}
+		buttons |= INPUT_P1_UP;
 	}
 
 	if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-		//Bounds
-		if (paddleOffset[1].y > PADDLE_OFFSET_BOUNDS) {
-			paddleOffset[1].y -= deltaTime * PADDLE_SPEED;
-		}
+		buttons |= INPUT_P1_DOWN;
 	}
+
+	return buttons;
 }
 
 //Clear Screen
@@ -353,6 +711,240 @@ void newFrame(GLFWwindow* window)
 	glfwPollEvents();
 }
 
+/* - Frame Pacing Methods - */
+
+//A Submitted Frame's Fence, when it Started, Submitted and Read the Input it Shows, and its GPU Timer (0 when not Timed)
+struct FrameFence {
+	GLsync sync;
+	GLuint query;
+	double startTime;
+	double submitTime;
+	double inputTime;
+};
+
+//Frames the GPU has not Finished, Oldest First, how Long Input Took to Reach the Screen,
+//and for Just in Time Starts, Timer Queries not Held by a Frame, how Long a Frame Takes and when the Last Vsync Was
+struct FrameQueue {
+	std::deque<FrameFence> fences;
+	std::vector<GLuint> freeQueries;
+	double latencySum = 0.0;
+	unsigned int noLatencies = 0;
+	double costEstimate = 0.0;
+	double vsyncTime = 0.0;
+};
+
+//Create the Timer Queries Once, One per Frame that can be in Flight plus the One being Recorded
+void genFrameQueries(FrameQueue& queue, unsigned int maxInFlight)
+{
+	queue.freeQueries.resize(maxInFlight + 1);
+	glGenQueries((GLsizei)queue.freeQueries.size(), queue.freeQueries.data());
+}
+
+//A Free Timer Query for the Next Frame, 0 when Frames Stuck on the GPU Hold them All and it Goes Untimed
+GLuint takeFrameQuery(FrameQueue& queue)
+{
+	if (queue.freeQueries.empty()) {
+		return 0;
+	}
+	GLuint query = queue.freeQueries.back();
+	queue.freeQueries.pop_back();
+	return query;
+}
+
+//Fence the Frame just Swapped
+void fenceFrame(FrameQueue& queue, GLuint query, double startTime, double submitTime, double inputTime)
+{
+	queue.fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), query, startTime, submitTime, inputTime });
+}
+
+//Retire Finished Frames, Blocking until Fewer than maxInFlight are Left (0 Never Blocks);
+//Latency Runs from Input to when the Fence is Seen Done, so Frames Polled Late Count a Little Long
+void retireFrames(FrameQueue& queue, unsigned int maxInFlight)
+{
+	while (!queue.fences.empty()) {
+		FrameFence& frame = queue.fences.front();
+		bool block = maxInFlight > 0 && queue.fences.size() >= maxInFlight;
+		GLenum status = glClientWaitSync(frame.sync, GL_SYNC_FLUSH_COMMANDS_BIT, block ? 1000000000 : 0);
+
+		//Not Done, even after a Second's Block: Keep the Fence and Try Again Next Frame rather than Stall on its Query
+		if (status == GL_TIMEOUT_EXPIRED) {
+			if (block) {
+				std::cout << "A frame has been on the GPU for over a second, not waiting on it" << std::endl;
+			}
+			return;
+		}
+		double now = glfwGetTime();
+		if (status != GL_WAIT_FAILED) {
+			queue.latencySum += now - frame.inputTime;
+			queue.noLatencies++;
+		}
+
+		//A Frame Waited on Finished just Now, and with Vsync on it Finishes at the Flip; one Already Done Finished at some Unknown Time
+		if (status == GL_CONDITION_SATISFIED) {
+			queue.vsyncTime = now;
+		}
+
+		//CPU plus GPU Time, an Upper Bound as they Overlap; Rise at Once and Fall Slowly, so One Quick Frame does not Start the Next too Late.
+		//The Result can Lag the Fence, so a Frame whose Result is not Ready Yet is Left Out rather than Waited for
+		if (frame.query) {
+			GLuint available = GL_FALSE;
+			if (status != GL_WAIT_FAILED) {
+				glGetQueryObjectuiv(frame.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			}
+			if (available) {
+				GLuint64 gpuTime = 0;
+				glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &gpuTime);
+				double cost = frame.submitTime - frame.startTime + gpuTime * 1e-9;
+				queue.costEstimate = std::max(cost, queue.costEstimate * 0.9 + cost * 0.1);
+			}
+			queue.freeQueries.push_back(frame.query);
+		}
+
+		glDeleteSync(frame.sync);
+		queue.fences.pop_front();
+	}
+}
+
+void cleanup(FrameQueue& queue)
+{
+	for (const FrameFence& frame : queue.fences) {
+		glDeleteSync(frame.sync);
+		if (frame.query) {
+			queue.freeQueries.push_back(frame.query);
+		}
+	}
+	queue.fences.clear();
+	glDeleteQueries((GLsizei)queue.freeQueries.size(), queue.freeQueries.data());
+	queue.freeQueries.clear();
+}
+
+//Hold the Frame Back until it has just Time to be Ready for the Next Vsync, Returning how Long it Waited
+double waitForFrameStart(const FrameQueue& queue, double vsyncPeriod, double margin)
+{
+	double now = glfwGetTime();
+	double vsync = queue.vsyncTime + vsyncPeriod;
+	while (vsync <= now) {
+		vsync += vsyncPeriod;
+	}
+
+	//Already Late for that Vsync: Start at Once rather than Skip it
+	double start = vsync - queue.costEstimate - margin;
+	if (start <= now) {
+		return 0.0;
+	}
+
+	//Sleep Coarsely, then Yield through the Last Millisecond the Scheduler may Overshoot
+	if (start - now > 0.002) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(start - now - 0.001));
+	}
+	while (glfwGetTime() < start) {
+		std::this_thread::yield();
+	}
+	return start - now;
+}
+
+//Move the Simulated Paddles on by the Time not yet Simulated under the Latest Input, a Tick at a Time as stepSim Would
+void latchPaddles(const SimState& state, uint8_t input, double ahead, const SimParams& params, vec2* paddles)
+{
+	float tickLength = 1.0f / params.tickRate;
+	paddles[0] = state.paddles[0];
+	paddles[1] = state.paddles[1];
+	for (float left = (float)std::min(ahead, 0.25); left > 0.0f; left -= tickLength) {
+		float dt = std::min(left, tickLength);
+		stepPaddle(paddles[0], (input & INPUT_P0_UP) != 0, (input & INPUT_P0_DOWN) != 0, dt, params);
+		stepPaddle(paddles[1], (input & INPUT_P1_UP) != 0, (input & INPUT_P1_DOWN) != 0, dt, params);
+	}
+}
+
+/* - Client Methods - */
+
+//Server Match Played with --connect; the Server Simulates, the Client Draws its Snapshots
+struct ServerLink {
+	UdpSocket sock;
+	JoinedPacket joined;
+	JitterBuffer jitter;
+	JitterParams jitterParams;
+	uint32_t score[2];
+};
+
+//Ask the Server for a Match, Resending for a Few Seconds in Case Packets are Lost
+bool joinServer(ServerLink& link, const char* address)
+{
+	if (!openUdp(link.sock, address, NET_DEFAULT_PORT)) {
+		return false;
+	}
+
+	JoinPacket join = {};
+	initNetHeader(join.header, PACKET_JOIN);
+	join.clientId = (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+	char buffer[NET_MAX_PACKET];
+	for (int attempt = 0; attempt < 50; attempt++) {
+		if (attempt % 5 == 0) {
+			sendUdp(link.sock, &join, sizeof(join));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		int size;
+		while ((size = receiveUdp(link.sock, buffer, sizeof(buffer))) >= 0) {
+			if (packetType(buffer, size) == PACKET_JOINED && readPacket(buffer, size, link.joined) && link.joined.clientId == join.clientId) {
+				initJitterBuffer(link.jitter, (float)link.joined.params.tickRate);
+				link.score[0] = 0;
+				link.score[1] = 0;
+				std::cout << "Joined match " << link.joined.match.slot << " on side " << link.joined.side << std::endl;
+				return true;
+			}
+		}
+	}
+	std::cout << "No answer from " << address << std::endl;
+	closeUdp(link.sock);
+	return false;
+}
+
+//Buffer every Snapshot that has Arrived
+void receiveSnapshots(ServerLink& link, double time)
+{
+	char buffer[NET_MAX_PACKET];
+	SnapshotPacket snapshot;
+	int size;
+	while ((size = receiveUdp(link.sock, buffer, sizeof(buffer))) >= 0) {
+		if (packetType(buffer, size) != PACKET_SNAPSHOT || !readSnapshot(buffer, size, snapshot)) {
+			continue;
+		}
+		if (snapshot.match.slot != link.joined.match.slot || snapshot.match.generation != link.joined.match.generation) {
+			continue;
+		}
+		pushSnapshot(link.jitter, snapshot, time, link.jitterParams);
+		if (snapshot.score[0] != link.score[0] || snapshot.score[1] != link.score[1]) {
+			link.score[0] = snapshot.score[0];
+			link.score[1] = snapshot.score[1];
+			std::cout << "Score: " << link.score[0] << " - " << link.score[1] << std::endl;
+		}
+	}
+}
+
+//Send the Buttons Held, Either Set of Keys Moving the Client's Own Paddle
+void sendInput(ServerLink& link, uint8_t buttons)
+{
+	InputPacket input = {};
+	initNetHeader(input.header, PACKET_INPUT);
+	input.match = link.joined.match;
+	input.side = link.joined.side;
+	input.buttons = link.joined.side == 0 ? buttons | buttons >> 2 : buttons | buttons << 2;
+	input.tick = link.jitter.noSnapshots > 0 ? link.jitter.snapshots[link.jitter.noSnapshots - 1].tick : 0;
+	input.nonce = link.joined.nonce;
+	sendUdp(link.sock, &input, sizeof(input));
+}
+
+void leaveServer(ServerLink& link)
+{
+	LeavePacket leave = {};
+	initNetHeader(leave.header, PACKET_LEAVE);
+	leave.match = link.joined.match;
+	leave.side = link.joined.side;
+	leave.nonce = link.joined.nonce;
+	sendUdp(link.sock, &leave, sizeof(leave));
+	closeUdp(link.sock);
+}
+
 /* - Cleanup Methods - */
 
 //Terminate GLFW
@@ -361,20 +953,102 @@ void cleanup()
 	glfwTerminate();
 }
 
-int main()
+int main(int argc, char** argv)
 {
 	std::cout << "Hello, Atari!" << std::endl;
 
+	//Options
+	bool vertexPulling = false;
+	bool packedInstances = false;
+	bool showStats = false;
+	bool lateLatch = false;
+	int framesInFlight = -1;
+	bool jitStart = false;
+	unsigned int noObstacles = 0;
+	unsigned int noBalls = 1;
+	const char* levelPath = NULL;
+	const char* recordPath = NULL;
+	const char* connectAddress = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--vertex-pulling") == 0) {
+			vertexPulling = true;
+		}
+		else if (strcmp(argv[i], "--packed-instances") == 0) {
+			//Quantized records are only read through vertex pulling
+			vertexPulling = true;
+			packedInstances = true;
+		}
+		else if (strcmp(argv[i], "--stats") == 0) {
+			showStats = true;
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+			noObstacles = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+			levelPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+			noBalls = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--fixed-point") == 0) {
+			simParams.fixedPoint = 1;
+		}
+		else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+			connectAddress = argv[++i];
+		}
+		else if (strcmp(argv[i], "--late-latch") == 0) {
+			lateLatch = true;
+		}
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+			framesInFlight = std::max(0, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--jit-start") == 0) {
+			jitStart = true;
+		}
+	}
+
+	//The Server Picks the Parameters and Ball Count; its Snapshots Carry no Obstacles, so None are Drawn
+	ServerLink link;
+	if (connectAddress) {
+		if (!joinServer(link, connectAddress)) {
+			return -1;
+		}
+		simParams = link.joined.params;
+		noBalls = link.joined.noBalls;
+		noObstacles = 0;
+		levelPath = NULL;
+		recordPath = NULL;
+	}
+
 	//Timing
 	double deltaTime = 0.0;
 	double lastFrame = 0.0;
 
-	//Initialization
-	initGLFW(3, 3);
+	//Level, Mapped from a Level File or Generated, Setting the Arena Size before the Projection Uses it
+	Level level;
+	LevelFile levelFile;
+	if (levelPath) {
+		if (!loadLevelFile(levelFile, level, levelPath)) {
+			return -1;
+		}
+		simParams.arenaWidth = levelFile.header.arenaWidth;
+		simParams.arenaHeight = levelFile.header.arenaHeight;
+	}
+	else {
+		genBrickLevel(level, noObstacles, simParams.arenaWidth, simParams.arenaHeight);
+	}
+	noObstacles = level.noObstacles;
 
-	//Create Window
+	//Create Window, Requesting the Newest Context and Falling Back to 3.3
+	const unsigned int glVersions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
 	GLFWwindow* window = nullptr;
-	createWindow(window, title, scrWidth, scrHeight, frameBufferSizeCallback);
+	for (unsigned int i = 0; i < 4 && !window; i++) {
+		initGLFW(glVersions[i][0], glVersions[i][1]);
+		createWindow(window, title, scrWidth, scrHeight, frameBufferSizeCallback);
+	}
 	if (!window) {
 		std::cout << "Could not create window." << std::endl;
 		cleanup();
@@ -390,9 +1064,50 @@ int main()
 
 	glViewport(0, 0, (float)scrWidth, (float)scrHeight);
 
+	//Packed Records Decode against a Size Table of MAX_SIZE_CLASSES / 2 vec4s, plus 7 vec4 Slots of Other Uniforms in pull.vs
+	GLint maxVertexUniforms = 0;
+	glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &maxVertexUniforms);
+	if (packedInstances && maxVertexUniforms < (GLint)(MAX_SIZE_CLASSES * 2 + 7 * 4)) {
+		std::cout << "Only " << maxVertexUniforms << " vertex uniform components, drawing full instance records" << std::endl;
+		packedInstances = false;
+	}
+
 	//Shaders
-	GLuint shaderProgram = genShaderProgram("main.vs", "main.fs");
-	setOrthographicProjection(shaderProgram, 0, scrWidth, 0, scrHeight, 0.0f, 1.0f);
+	bool pullFromSSBO = vertexPulling && glCaps.ssbo;
+	if (vertexPulling) {
+		std::string pullHeader = "#version 330 core\n";
+		if (pullFromSSBO) {
+			pullHeader = hasVersion(glCaps, 4, 3) ? "#version 430 core\n"
+				: "#version 330 core\n#extension GL_ARB_shader_storage_buffer_object : require\n#extension GL_ARB_shading_language_420pack : require\n";
+			pullHeader += "#define USE_SSBO\n";
+		}
+		if (packedInstances) {
+			pullHeader += "#define PACKED_INSTANCES\n";
+		}
+		shaderProgram = genShaderProgram("pull.vs", "main.fs", pullHeader.c_str());
+	}
+	else {
+		shaderProgram = genShaderProgram("main.vs", "main.fs");
+	}
+	setOrthographicProjection(shaderProgram, 0, simParams.arenaWidth, 0, simParams.arenaHeight, 0.0f, 1.0f);
+
+	/* - Simulation - */
+
+	SimState state;
+	SimEvents events;
+	initSim(state, level, noBalls, simParams);
+	noBalls = state.noBalls;
+
+	//Input per Tick for --record, Enough with the Level and Parameters to Replay the Match
+	Replay replay;
+	replay.params = simParams;
+	replay.noBalls = noBalls;
+	replay.noObstacles = noObstacles;
+	replay.levelPath = levelPath ? levelPath : "";
+
+	//Fixed Tick, Decoupled from the Frame Rate
+	double tickLength = 1.0 / simParams.tickRate;
+	double tickAccumulator = 0.0;
 
 	/* - Paddle VAOs and VBOs - */
 
@@ -411,12 +1126,12 @@ int main()
 	};
 
 	//Offsets Array
-	paddleOffsets[0] = { 35.0f, scrHeight / 2.0f };
-	paddleOffsets[1] = { scrWidth - 35.0f, scrHeight / 2.0f };
+	paddleOffsets[0] = state.paddles[0];
+	paddleOffsets[1] = state.paddles[1];
 
 	//Size Array
 	vec2 paddleSizes[] = {
-		PADDLE_WIDTH, PADDLE_HEIGHT
+		simParams.paddleWidth, simParams.paddleHeight
 	};
 
 	//Setup VAO
@@ -450,11 +1165,13 @@ int main()
 	gen2DCircleArray(ballVertices, ballIndices, noTriangles, 0.5f);
 
 	//Offsets Array
-	ballOffsets[0] = { scrWidth / 2.0f, scrHeight / 2.0f };
+	for (unsigned int i = 0; i < noBalls; i++) {
+		ballOffsets[i] = state.balls[i].pos;
+	}
 
 	//Size Array
 	vec2 ballSizes[] = {
-		BALL_DIAMETER, BALL_DIAMETER
+		simParams.ballDiameter, simParams.ballDiameter
 	};
 
 	//Setup VAO/VBOs
@@ -464,14 +1181,14 @@ int main()
 	//Position VBO
 	genBufferObject<float>(ballVAO.posVBO, GL_ARRAY_BUFFER, 2 * (noTriangles + 1), ballVertices, GL_STATIC_DRAW);
 	setAttPointer<float>(ballVAO.posVBO, 0, 2, GL_FLOAT, 2, 0);
-	
+
 	//Offset VBO
-	genBufferObject<vec2>(ballVAO.offsetVBO, GL_ARRAY_BUFFER, 1, ballOffsets, GL_DYNAMIC_DRAW);
+	genBufferObject<vec2>(ballVAO.offsetVBO, GL_ARRAY_BUFFER, noBalls, ballOffsets, GL_DYNAMIC_DRAW);
 	setAttPointer<float>(ballVAO.offsetVBO, 1, 2, GL_FLOAT, 2, 0, 1);
 
-	//Size VBO
+	//Size VBO, Shared by every Ball
 	genBufferObject<vec2>(ballVAO.sizeVBO, GL_ARRAY_BUFFER, 1, ballSizes, GL_STATIC_DRAW);
-	setAttPointer<float>(ballVAO.sizeVBO, 2, 2, GL_FLOAT, 2, 0, 1);
+	setAttPointer<float>(ballVAO.sizeVBO, 2, 2, GL_FLOAT, 2, 0, noBalls);
 
 	//EBO
 	genBufferObject<unsigned int>(ballVAO.EBO, GL_ELEMENT_ARRAY_BUFFER, 3 * noTriangles, ballIndices, GL_STATIC_DRAW);
@@ -480,37 +1197,441 @@ int main()
 	unbindBuffer(GL_ARRAY_BUFFER);
 	unbindVAO();
 
+	/* - Obstacle VAOs and VBOs - */
+
+	//Setup VAO, Same Quad as the Paddles, Offset and Size Read from the Level's Records
+	VAO obstacleVAO = {};
+	if (noObstacles > 0) {
+		genVAO(&obstacleVAO);
+
+		genBufferObject<float>(obstacleVAO.posVBO, GL_ARRAY_BUFFER, 2 * 4, paddleVertices, GL_STATIC_DRAW);
+		setAttPointer<float>(obstacleVAO.posVBO, 0, 2, GL_FLOAT, 2, 0);
+
+		//Records Straight from the Level (mapped file or generated), Offset then Size within each
+		genBufferObject<InstanceRecord>(obstacleVAO.offsetVBO, GL_ARRAY_BUFFER, noObstacles, level.records, GL_DYNAMIC_DRAW);
+		setAttPointer<float>(obstacleVAO.offsetVBO, 1, 2, GL_FLOAT, 8, 0, 1);
+		setAttPointer<float>(obstacleVAO.offsetVBO, 2, 2, GL_FLOAT, 8, 2, 1);
+
+		genBufferObject<GLuint>(obstacleVAO.EBO, GL_ELEMENT_ARRAY_BUFFER, 2 * 4, paddleIndices, GL_STATIC_DRAW);
+
+		unbindBuffer(GL_ARRAY_BUFFER);
+		unbindVAO();
+	}
+
+	/* - Indirect Draws - */
+
+	//The Same Three Draws, their Parameters Kept in a Buffer the GPU Reads, so Breaking a Brick Patches a Count
+	bool indirectDraws = !vertexPulling && glCaps.indirectDraw;
+	IndirectDraws drawCommands = {};
+	if (indirectDraws) {
+		genIndirectDraws(drawCommands, {
+			{ 3 * 2, 2, 0, 0, 0 },
+			{ 3 * noTriangles, noBalls, 0, 0, 0 },
+			{ 3 * 2, noObstacles, 0, 0, 0 }
+		});
+	}
+
+	/* - Vertex Pulling Buffers - */
+
+	//Paddles then Balls, Rewritten every Frame, Straight into a Persistent Mapping where Supported
+	GLuint ballRecord = 2;
+	GLuint noRecords = ballRecord + noBalls;
+	std::vector<InstanceRecord> instanceRecords(noRecords);
+	bool streamInstances = vertexPulling && glCaps.persistentMapping;
+	PulledInstances pulledInstances;
+	genPulledInstances(&pulledInstances, noRecords, pullFromSSBO, packedInstances, streamInstances);
+
+	//First Record of the Stream Region this Frame Writes, 0 without a Stream
+	GLuint streamBase = 0;
+
+	//Quantized Copies and their Size Class/Shape Words
+	std::vector<PackedInstance> packedRecords(noRecords);
+	SizeClassTable sizeClasses;
+	std::vector<uint32_t> instanceAttrs(noRecords);
+	instanceAttrs[0] = instanceAttrs[1] = packInstanceAttr(getSizeClass(sizeClasses, paddleSizes[0]), SHAPE_QUAD);
+	for (GLuint i = ballRecord; i < noRecords; i++) {
+		instanceAttrs[i] = packInstanceAttr(getSizeClass(sizeClasses, ballSizes[0]), SHAPE_CIRCLE);
+	}
+
+	//Obstacles in their own Buffer, Static until Destroyed; the Packed Copy is Built once at Load
+	vec2 arenaSize = { simParams.arenaWidth, simParams.arenaHeight };
+	PulledInstances pulledObstacles = {};
+	std::vector<PackedInstance> packedObstacles;
+	std::vector<uint32_t> obstacleAttrs(noObstacles);
+	if (vertexPulling && noObstacles > 0) {
+		genPulledInstances(&pulledObstacles, noObstacles, pullFromSSBO, packedInstances);
+		if (packedInstances) {
+			for (GLuint i = 0; i < noObstacles; i++) {
+				obstacleAttrs[i] = packInstanceAttr(getSizeClass(sizeClasses, level.records[i].size), SHAPE_QUAD);
+			}
+			packedObstacles.resize(noObstacles);
+			packInstances(level.records, obstacleAttrs.data(), noObstacles, arenaSize, packedObstacles.data());
+			updateData<PackedInstance>(pulledObstacles.buffer, 0, noObstacles, packedObstacles.data());
+		}
+		else {
+			updateData<InstanceRecord>(pulledObstacles.buffer, 0, noObstacles, level.records);
+		}
+	}
+
+	/* - Dirty Tracked Instance Data - */
+
+	//One Page per Instance for the Tiny Arrays, Pages of 64 where Obstacles Live
+	InstanceBuffer<vec2> paddleOffsetBuffer;
+	InstanceBuffer<vec2> ballOffsetBuffer;
+	InstanceBuffer<InstanceRecord> recordBuffer;
+	InstanceBuffer<PackedInstance> packedBuffer;
+	initInstanceBuffer(paddleOffsetBuffer, paddleVAO.offsetVBO, 2, paddleOffsets, 1);
+	initInstanceBuffer(ballOffsetBuffer, ballVAO.offsetVBO, noBalls, ballOffsets, 1);
+
+	//Pulled Records Start Out Unwritten, so Upload them on the First Frame
+	initInstanceBuffer(recordBuffer, pulledInstances.buffer, noRecords, instanceRecords.data(), 1);
+	initInstanceBuffer(packedBuffer, pulledInstances.buffer, noRecords, packedRecords.data(), 1);
+	for (GLuint i = 0; i < noRecords; i++) {
+		markDirty(recordBuffer, i);
+		markDirty(packedBuffer, i);
+	}
+
+	//Live Obstacles Kept Dense, Swap Removed in Place (in the mapped file's private pages for loaded levels),
+	//so level.records Stops Following Obstacle Order once Bricks Break
+	DenseInstances obstacleSlots;
+	initDenseInstances(obstacleSlots, noObstacles);
+	GLuint obstacleBO = vertexPulling ? pulledObstacles.buffer : obstacleVAO.offsetVBO;
+	size_t obstacleUploadBytes = 0;
+	size_t noDestroyed = 0;
+
+	//Empty VAO, Required by Core Profile Draws
+	VAO pullVAO = {};
+	genVAO(&pullVAO);
+	unbindVAO();
+
+	/* - Frame Pacing - */
+
+	//Frames in Flight as Asked, else One for the Late Latch or a Just in Time Start so Input is not Queued behind
+	//Frames the Driver Buffers, else as Many as the Driver Likes; --stats Fences every Frame to Time Input
+	FrameQueue frameQueue;
+	unsigned int maxFramesInFlight = framesInFlight >= 0 ? framesInFlight : (lateLatch || jitStart ? 1 : 0);
+
+	//Just in Time Starts Take the Vsync from the Last Frame Finishing while Waited on, so Need Vsync and a Single Frame in Flight
+	const double JIT_MARGIN = 0.001;
+	double vsyncPeriod = 1.0 / 60.0;
+	double frameHeldBack = 0.0;
+	if (jitStart) {
+		if (maxFramesInFlight != 1) {
+			std::cout << "--jit-start keeps one frame in flight" << std::endl;
+			maxFramesInFlight = 1;
+		}
+		glfwSwapInterval(1);
+		genFrameQueries(frameQueue, maxFramesInFlight);
+		const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+		if (mode && mode->refreshRate > 0) {
+			vsyncPeriod = 1.0 / mode->refreshRate;
+		}
+	}
+
+	//Upload the Paddles and Draw them, on their Own for the Late Latch
+	auto drawPaddles = [&]() {
+		if (vertexPulling) {
+			for (GLuint i = 0; i < 2; i++) {
+				instanceRecords[i] = { paddleOffsets[i], paddleSizes[0], { 1.0f, 1.0f, 1.0f, 1.0f } };
+			}
+			if (packedInstances) {
+				packInstances(instanceRecords.data(), instanceAttrs.data(), 2, arenaSize, packedRecords.data());
+			}
+			if (streamInstances && packedInstances) {
+				writeStream<PackedInstance>(pulledInstances, 0, 2, packedRecords.data());
+			}
+			else if (streamInstances) {
+				writeStream<InstanceRecord>(pulledInstances, 0, 2, instanceRecords.data());
+			}
+			else if (packedInstances) {
+				for (GLuint i = 0; i < 2; i++) {
+					setInstance(packedBuffer, i, packedRecords[i]);
+				}
+				flushInstances(packedBuffer);
+			}
+			else {
+				for (GLuint i = 0; i < 2; i++) {
+					setInstance(recordBuffer, i, instanceRecords[i]);
+				}
+				flushInstances(recordBuffer);
+			}
+			bindPulledInstances(pulledInstances, shaderProgram);
+			drawPulled(pullVAO.val, shaderProgram, SHAPE_QUAD, 3 * 2, streamBase, 2);
+		}
+		else {
+			for (GLuint i = 0; i < 2; i++) {
+				setInstance(paddleOffsetBuffer, i, paddleOffsets[i]);
+			}
+			flushInstances(paddleOffsetBuffer);
+			if (indirectDraws) {
+				drawIndirect(drawCommands, paddleVAO, GL_TRIANGLES, 0);
+			}
+			else {
+				draw(paddleVAO, GL_TRIANGLES, 3 * 2, GL_UNSIGNED_INT, 0, 2);
+			}
+		}
+	};
+
+	//Upload Statistics
+	double statStart = glfwGetTime();
+	unsigned int statFrames = 0;
+
 	//Render Loop
-	while (!glfwWindowShouldClose(window)) 
+	while (!glfwWindowShouldClose(window))
 	{
+		//Wait for the GPU to Catch Up when Capped, then Start as Late as the Next Vsync Allows
+		retireFrames(frameQueue, maxFramesInFlight);
+		if (jitStart) {
+			frameHeldBack += waitForFrameStart(frameQueue, vsyncPeriod, JIT_MARGIN);
+
+			//Keys Read Below Come from the Last Poll, so Poll Again after the Wait
+			glfwPollEvents();
+		}
+
+		//Time the GPU's Share of the Frame for the Next Start
+		double frameStart = glfwGetTime();
+		GLuint frameQuery = 0;
+		if (jitStart && (frameQuery = takeFrameQuery(frameQueue))) {
+			glBeginQuery(GL_TIME_ELAPSED, frameQuery);
+		}
+
 		//Update time
 		deltaTime = glfwGetTime() - lastFrame;
 		lastFrame += deltaTime;
 
 		//Input
-		processInput(window, deltaTime, paddleOffsets);
+		uint8_t input = processInput(window);
+		double inputTime = glfwGetTime();
+
+		//Draw the Server's Match between Buffered Snapshots, or Simulate Locally
+		if (connectAddress) {
+			receiveSnapshots(link, lastFrame);
+			if (!lateLatch) {
+				sendInput(link, input);
+			}
+			sampleJitterBuffer(link.jitter, lastFrame, link.jitterParams, paddleOffsets, ballOffsets);
+		}
+
+		//Simulate the Ticks that Fit in this Frame, Dropping Time after a Long Stall
+		tickAccumulator += connectAddress ? 0.0 : std::min(deltaTime, 0.25);
+		while (tickAccumulator >= tickLength) {
+			events.clear();
+			if (recordPath) {
+				stepRecorded(replay, state, level, input, simParams, events);
+			}
+			else {
+				stepSim(state, level, input, simParams, &events);
+			}
+			tickAccumulator -= tickLength;
+
+			//Remove Destroyed Obstacles, Patching the Record Moved into each Gap at the Next Flush
+			for (uint32_t idx : events.destroyed) {
+				DenseMove move;
+				if (removeDense(obstacleSlots, idx, move)) {
+					applyDenseMove(level.records, move);
+					if (packedInstances) {
+						applyDenseMove(packedObstacles.data(), move);
+					}
+				}
+				noDestroyed++;
+			}
+
+			if (events.scoredBy >= 0) {
+				std::cout << "Score: " << state.score[0] << " - " << state.score[1] << std::endl;
+			}
+		}
+
+		//Copy Simulation State to the Offsets Arrays
+		if (!connectAddress) {
+			paddleOffsets[0] = state.paddles[0];
+			paddleOffsets[1] = state.paddles[1];
+			for (unsigned int i = 0; i < noBalls; i++) {
+				ballOffsets[i] = state.balls[i].pos;
+			}
+		}
+
+		//One Small Upload per Run of Patched Obstacle Slots
+		size_t frameUploadBytes = uploadBytes;
+		flushDensePatches(obstacleSlots, [&](uint32_t first, uint32_t count) {
+			if (packedInstances) {
+				updateData<PackedInstance>(obstacleBO, first * sizeof(PackedInstance), count, packedObstacles.data() + first);
+			}
+			else {
+				updateData<InstanceRecord>(obstacleBO, first * sizeof(InstanceRecord), count, level.records + first);
+			}
+		});
+		obstacleUploadBytes += uploadBytes - frameUploadBytes;
 
 		//Clear screen for new frame
 		clearScreen();
 
-		//Update Data
-		updateData<vec2>(paddleVAO.offsetVBO, 0, 2, paddleOffsets);
-		updateData<vec2>(ballVAO.offsetVBO, 0, 1, ballOffsets);
+		//Late Latching Leaves the Paddle Records Alone until the Latch
+		GLuint firstRecord = lateLatch ? ballRecord : 0;
+
+		if (vertexPulling) {
+			//Update Data, One Packed Buffer for Every Instance
+			for (unsigned int i = 0; i < 2; i++) {
+				instanceRecords[i] = { paddleOffsets[i], paddleSizes[0], { 1.0f, 1.0f, 1.0f, 1.0f } };
+			}
+			for (unsigned int i = 0; i < noBalls; i++) {
+				instanceRecords[ballRecord + i] = { ballOffsets[i], ballSizes[0], { 1.0f, 1.0f, 1.0f, 1.0f } };
+			}
+
+			bindShader(shaderProgram);
+			if (packedInstances) {
+				packInstances(instanceRecords.data(), instanceAttrs.data(), noRecords, arenaSize, packedRecords.data());
+				setPackedDecode(shaderProgram, sizeClasses, arenaSize);
+			}
+
+			//A Stream Takes the whole Frame Unconditionally, the Upload Path only what Changed
+			if (streamInstances) {
+				streamBase = beginStreamRegion(pulledInstances);
+				if (packedInstances) {
+					writeStream<PackedInstance>(pulledInstances, firstRecord, noRecords - firstRecord, packedRecords.data() + firstRecord);
+				}
+				else {
+					writeStream<InstanceRecord>(pulledInstances, firstRecord, noRecords - firstRecord, instanceRecords.data() + firstRecord);
+				}
+			}
+			else if (packedInstances) {
+				for (GLuint i = firstRecord; i < noRecords; i++) {
+					setInstance(packedBuffer, i, packedRecords[i]);
+				}
+				flushInstances(packedBuffer);
+			}
+			else {
+				for (GLuint i = firstRecord; i < noRecords; i++) {
+					setInstance(recordBuffer, i, instanceRecords[i]);
+				}
+				flushInstances(recordBuffer);
+			}
+
+			//Render Object
+			bindPulledInstances(pulledInstances, shaderProgram);
+			if (!lateLatch) {
+				drawPulled(pullVAO.val, shaderProgram, SHAPE_QUAD, 3 * 2, streamBase, 2);
+			}
+			drawPulled(pullVAO.val, shaderProgram, SHAPE_CIRCLE, 3 * noTriangles, streamBase + ballRecord, noBalls, noTriangles);
+			if (noObstacles > 0) {
+				bindPulledInstances(pulledObstacles, shaderProgram);
+				drawPulled(pullVAO.val, shaderProgram, SHAPE_QUAD, 3 * 2, 0, obstacleSlots.noLive);
+			}
+		}
+		else {
+			//Update Data, only what Moved
+			for (GLuint i = 0; i < 2 && !lateLatch; i++) {
+				setInstance(paddleOffsetBuffer, i, paddleOffsets[i]);
+			}
+			for (GLuint i = 0; i < noBalls; i++) {
+				setInstance(ballOffsetBuffer, i, ballOffsets[i]);
+			}
+			flushInstances(paddleOffsetBuffer);
+			flushInstances(ballOffsetBuffer);
+
+			//Render Object
+			bindShader(shaderProgram);
+			if (indirectDraws) {
+				if (!lateLatch) {
+					drawIndirect(drawCommands, paddleVAO, GL_TRIANGLES, 0);
+				}
+				drawIndirect(drawCommands, ballVAO, GL_TRIANGLES, 1);
+				if (noObstacles > 0) {
+					setDrawInstances(drawCommands, 2, obstacleSlots.noLive);
+					drawIndirect(drawCommands, obstacleVAO, GL_TRIANGLES, 2);
+				}
+			}
+			else {
+				if (!lateLatch) {
+					draw(paddleVAO, GL_TRIANGLES, 3 * 2, GL_UNSIGNED_INT, 0, 2);
+				}
+				draw(ballVAO, GL_TRIANGLES, 3 * noTriangles, GL_UNSIGNED_INT, 0, noBalls);
+				if (noObstacles > 0) {
+					draw(obstacleVAO, GL_TRIANGLES, 3 * 2, GL_UNSIGNED_INT, 0, obstacleSlots.noLive);
+				}
+			}
+		}
 
-		//Render Object
-		bindShader(shaderProgram);
-		draw(paddleVAO, GL_TRIANGLES, 3 * 2, GL_UNSIGNED_INT, 0, 2);
-		draw(ballVAO, GL_TRIANGLES, 3 * noTriangles, GL_UNSIGNED_INT, 0);
+		//Latch: Read Input Again now the Rest of the Frame is Submitted, and Draw the Paddles it Moves
+		if (lateLatch) {
+			glfwPollEvents();
+			input = processInput(window);
+			inputTime = glfwGetTime();
+			if (connectAddress) {
+				sendInput(link, input);
+			}
+			else {
+				latchPaddles(state, input, tickAccumulator + (inputTime - lastFrame), simParams, paddleOffsets);
+			}
+			drawPaddles();
+		}
 
-		//Swap frames
+		//Report Upload Bandwidth Once a Second
+		statFrames++;
+		if (showStats && glfwGetTime() - statStart >= 1.0) {
+			std::cout << "upload: " << uploadBytes / statFrames << " bytes/frame over " << statFrames << " frames" << std::endl;
+			if (noDestroyed > 0) {
+				std::cout << "obstacles: " << obstacleSlots.noLive << " live, " << obstacleUploadBytes / noDestroyed << " bytes uploaded per destroyed brick" << std::endl;
+			}
+			if (connectAddress) {
+				const JitterBuffer& jitter = link.jitter;
+				std::cout << "jitter buffer: " << jitter.delay * 1000.0 << " ms delay, " << jitter.noExtrapolated << " of " << jitter.noFrames
+					<< " frames extrapolated, " << jitter.noLate << " of " << jitter.noReceived << " snapshots late" << std::endl;
+			}
+			if (frameQueue.noLatencies > 0) {
+				std::cout << "input to frame done: " << frameQueue.latencySum / frameQueue.noLatencies * 1000.0 << " ms over " << frameQueue.noLatencies << " frames" << std::endl;
+			}
+			if (jitStart) {
+				std::cout << "frame start: held back " << frameHeldBack / statFrames * 1000.0 << " ms a frame, frames take up to " << frameQueue.costEstimate * 1000.0 << " ms" << std::endl;
+			}
+			frameQueue.latencySum = 0.0;
+			frameQueue.noLatencies = 0;
+			frameHeldBack = 0.0;
+			uploadBytes = 0;
+			statFrames = 0;
+			statStart = glfwGetTime();
+		}
+
+		//Swap frames, the Stream Region Free again once the GPU is Past Here
+		if (streamInstances) {
+			endStreamRegion(pulledInstances);
+		}
+		if (frameQuery) {
+			glEndQuery(GL_TIME_ELAPSED);
+		}
+		double submitTime = glfwGetTime();
 		newFrame(window);
+		if (maxFramesInFlight > 0 || showStats) {
+			fenceFrame(frameQueue, frameQuery, frameStart, submitTime, inputTime);
+		}
 	}
+	retireFrames(frameQueue, 1);
 
 	//Cleanup Memory
+	cleanup(frameQueue);
 	cleanup(paddleVAO);
 	cleanup(ballVAO);
+	if (noObstacles > 0) {
+		cleanup(obstacleVAO);
+	}
+	cleanup(pulledInstances);
+	if (indirectDraws) {
+		cleanup(drawCommands);
+	}
+	if (vertexPulling && noObstacles > 0) {
+		cleanup(pulledObstacles);
+	}
+	glDeleteVertexArrays(1, &pullVAO.val);
 	deleteShader(shaderProgram);
 	cleanup();
+	unloadLevelFile(levelFile);
+
+	if (connectAddress) {
+		leaveServer(link);
+	}
+
+	if (recordPath && !writeReplay(recordPath, replay)) {
+		return -1;
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* - Memory Mapped Files - */
+
+struct MappedFile {
+	void* data = NULL;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#endif
+};
+
+//Map a Whole File; Copy on Write Mappings can be Modified without Touching the File
+inline bool mapFile(MappedFile& mapped, const char* path, bool copyOnWrite = false)
+{
+#ifdef _WIN32
+	mapped.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mapped.file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(mapped.file, &size);
+	mapped.size = (size_t)size.QuadPart;
+	if (mapped.size == 0) {
+		CloseHandle(mapped.file);
+		mapped.file = INVALID_HANDLE_VALUE;
+		return false;
+	}
+
+	mapped.mapping = CreateFileMappingA(mapped.file, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (mapped.mapping) {
+		mapped.data = MapViewOfFile(mapped.mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	}
+	if (!mapped.data) {
+		if (mapped.mapping) {
+			CloseHandle(mapped.mapping);
+		}
+		CloseHandle(mapped.file);
+		mapped.mapping = NULL;
+		mapped.file = INVALID_HANDLE_VALUE;
+		return false;
+	}
+	return true;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	mapped.size = (size_t)st.st_size;
+
+	//The Mapping Keeps its own Reference, the Descriptor is not Needed Afterwards
+	void* data = mmap(NULL, mapped.size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	mapped.data = data;
+	return true;
+#endif
+}
+
+//Release a Mapping
+inline void unmapFile(MappedFile& mapped)
+{
+	if (!mapped.data) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(mapped.data);
+	CloseHandle(mapped.mapping);
+	CloseHandle(mapped.file);
+	mapped.mapping = NULL;
+	mapped.file = INVALID_HANDLE_VALUE;
+#else
+	munmap(mapped.data, mapped.size);
+#endif
+	mapped.data = NULL;
+	mapped.size = 0;
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef NET_H
+#define NET_H
+
+#include "schema.h"
+#include "sim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+	Packets between game clients and the dedicated server. Every packet is
+	a plain struct sent as raw little-endian bytes, starting with a
+	NetHeader. The server owns the simulation: clients send the buttons
+	they hold, and the server sends back snapshots of the match, carrying
+	the rolling state hash (see hashTick) so peers can compare their runs.
+	Snapshots are bit-packed on the wire (see schema.h): positions to 1/32
+	of an arena unit and velocities to 1/16, carrying only the balls in
+	play. That is plenty for drawing and bots; replays keep exact state.
+
+	Source addresses are not trusted until shown to be real: a client's
+	inputs must echo the nonce the server sent it in JOINED before its seat
+	counts, and requests that are answered before that, JOIN and
+	STATS_QUERY, are padded to the size of their replies, so a spoofed
+	address can draw no more traffic than was sent in its name.
+*/
+
+/* - Protocol - */
+
+const char NET_MAGIC[4] = { 'P', 'N', 'E', 'T' };
+const uint32_t NET_VERSION = 3;
+const uint16_t NET_DEFAULT_PORT = 27015;
+const size_t NET_MAX_PACKET = 1200;
+
+enum PacketType {
+	PACKET_JOIN = 1,		//Client Asks for a Match
+	PACKET_JOINED = 2,		//Server Assigns a Match and Side
+	PACKET_INPUT = 3,		//Client's Buttons
+	PACKET_SNAPSHOT = 4,	//Server's Match State
+	PACKET_LEAVE = 5,		//Client is Done, the Match Ends
+	PACKET_STATS_QUERY = 6,	//Anyone Asks for Server Load
+	PACKET_STATS = 7
+};
+
+struct NetHeader {
+	char magic[4];
+	uint16_t version;
+	uint16_t type;
+};
+
+//Names a Match Slot and which Use of it, so Packets for an Ended Match are Ignored after the Slot is Reused
+struct MatchHandle {
+	uint32_t slot;
+	uint32_t generation;
+};
+
+struct JoinedPacket {
+	NetHeader header;
+	uint32_t clientId;
+	uint32_t side;
+	MatchHandle match;
+	uint64_t seed;
+	uint32_t noBalls;
+	uint32_t nonce;			//Chosen by the Server, Echoed in every Input and Leave
+	SimParams params;
+};
+
+//Padded to the Size of the JOINED it is Answered with
+struct JoinPacket {
+	NetHeader header;
+	uint32_t clientId;		//Chosen by the Client, Echoed so it can Tell Replies Apart
+	uint32_t reserved;
+	uint8_t padding[sizeof(JoinedPacket) - sizeof(NetHeader) - 8];
+};
+
+struct InputPacket {
+	NetHeader header;
+	MatchHandle match;
+	uint32_t side;
+	uint32_t buttons;		//Only the Side's Own InputButtons Count
+	uint64_t tick;			//Newest Snapshot Tick the Client had Seen
+	uint32_t nonce;			//From JOINED; the First Input to Echo it Confirms the Seat
+	uint32_t reserved;
+};
+
+struct LeavePacket {
+	NetHeader header;
+	MatchHandle match;
+	uint32_t side;
+	uint32_t nonce;
+};
+
+struct SnapshotPacket {
+	NetHeader header;
+	MatchHandle match;
+	uint64_t tick;
+	uint64_t hash;
+	vec2 paddles[2];
+	uint32_t score[2];
+	uint32_t noBalls;
+	uint32_t reserved;
+	Ball balls[MAX_BALLS];
+};
+
+struct StatsPacket {
+	NetHeader header;
+	uint32_t noMatches;			//Running
+	uint32_t noWaiting;			//Waiting for a Second Player, or for Players to Answer their Join
+	uint32_t noThreads;
+	float busyCores;			//Worker Time Spent Stepping per Second of Wall Time, Last Second
+	float matchesPerCore;		//Running Matches a Core could Keep Up with, at the Current Cost per Match
+	float tickJitterMean;		//Round Start Lateness, Microseconds, Last Second
+	float tickJitterMax;
+	uint32_t noOverruns;		//Rounds Missed because a Round Ran Long, Since Start
+	uint64_t noTicks;			//Match Ticks Stepped Since Start
+};
+
+//Padded to the Size of the STATS it is Answered with
+struct StatsQueryPacket {
+	NetHeader header;
+	uint8_t padding[sizeof(StatsPacket) - sizeof(NetHeader)];
+};
+
+/* - Snapshot Schema - */
+
+//Quantization Ranges, from the Default Arena with a Margin for Balls Leaving it, and the Fastest a Ball Goes
+const int32_t WIRE_ARENA_WIDTH = 800;
+const int32_t WIRE_ARENA_HEIGHT = 600;
+const int32_t WIRE_MARGIN = 64;
+const int32_t WIRE_MAX_SPEED = 1024;
+
+static_assert(SimParams().arenaWidth == WIRE_ARENA_WIDTH && SimParams().arenaHeight == WIRE_ARENA_HEIGHT, "Snapshot ranges follow the default arena");
+static_assert(SimParams().ballMaxSpeed <= WIRE_MAX_SPEED, "Snapshot velocities must reach the fastest ball");
+
+typedef QuantizedCodec<-WIRE_MARGIN, WIRE_ARENA_WIDTH + WIRE_MARGIN, 32> WireX;
+typedef QuantizedCodec<-WIRE_MARGIN, WIRE_ARENA_HEIGHT + WIRE_MARGIN, 32> WireY;
+typedef QuantizedCodec<-WIRE_MAX_SPEED, WIRE_MAX_SPEED, 16> WireSpeed;
+
+typedef Schema<
+	Field<vec2, float, &vec2::x, WireX>,
+	Field<vec2, float, &vec2::y, WireY>
+> PositionSchema;
+
+typedef Schema<
+	Field<vec2, float, &vec2::x, WireSpeed>,
+	Field<vec2, float, &vec2::y, WireSpeed>
+> VelocitySchema;
+
+typedef Schema<
+	Field<Ball, vec2, &Ball::pos, PositionSchema>,
+	Field<Ball, vec2, &Ball::vel, VelocitySchema>
+> BallSchema;
+
+typedef Schema<
+	Field<MatchHandle, uint32_t, &MatchHandle::slot, UIntCodec<32>>,
+	Field<MatchHandle, uint32_t, &MatchHandle::generation, UIntCodec<32>>
+> MatchHandleSchema;
+
+//Ticks in 40 Bits Last 34 Years at 1 kHz
+typedef Schema<
+	Field<SnapshotPacket, MatchHandle, &SnapshotPacket::match, MatchHandleSchema>,
+	Field<SnapshotPacket, uint64_t, &SnapshotPacket::tick, UIntCodec<40>>,
+	Field<SnapshotPacket, uint64_t, &SnapshotPacket::hash, UIntCodec<64>>,
+	Field<SnapshotPacket, vec2[2], &SnapshotPacket::paddles, ArrayCodec<PositionSchema, 2>>,
+	Field<SnapshotPacket, uint32_t[2], &SnapshotPacket::score, ArrayCodec<UIntCodec<16>, 2>>,
+	CountedField<SnapshotPacket, &SnapshotPacket::noBalls, Ball, MAX_BALLS, &SnapshotPacket::balls, BallSchema>
+> SnapshotSchema;
+
+//Largest Snapshot on the Wire, and the Buffer to Encode One into
+const size_t SNAPSHOT_WIRE_BYTES = sizeof(NetHeader) + SnapshotSchema::maxBytes;
+const size_t SNAPSHOT_WIRE_BUFFER = SNAPSHOT_WIRE_BYTES + SCHEMA_SLACK;
+
+static_assert(SNAPSHOT_WIRE_BUFFER <= NET_MAX_PACKET, "Snapshots must fit in one datagram, and be decodable in place from a receive buffer");
+
+/* - Packing - */
+
+inline void initNetHeader(NetHeader& header, PacketType type)
+{
+	memcpy(header.magic, NET_MAGIC, 4);
+	header.version = NET_VERSION;
+	header.type = (uint16_t)type;
+}
+
+//Packet Type, or 0 if the Datagram is not a Packet of this Version
+inline uint16_t packetType(const void* data, size_t size)
+{
+	NetHeader header;
+	if (size < sizeof(header)) {
+		return 0;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, NET_MAGIC, 4) != 0 || header.version != NET_VERSION) {
+		return 0;
+	}
+	return header.type;
+}
+
+//Copy a Received Packet of Type T, False if it is Too Short
+template<typename T>
+inline bool readPacket(const void* data, size_t size, T& packet)
+{
+	if (size < sizeof(T)) {
+		return false;
+	}
+	memcpy(&packet, data, sizeof(T));
+	return true;
+}
+
+inline void packSnapshot(SnapshotPacket& packet, MatchHandle match, const SimState& state)
+{
+	initNetHeader(packet.header, PACKET_SNAPSHOT);
+	packet.match = match;
+	packet.tick = state.tick;
+	packet.hash = state.hash;
+	packet.paddles[0] = state.paddles[0];
+	packet.paddles[1] = state.paddles[1];
+	packet.score[0] = state.score[0];
+	packet.score[1] = state.score[1];
+	packet.noBalls = state.noBalls;
+	packet.reserved = 0;
+	memcpy(packet.balls, state.balls, state.noBalls * sizeof(Ball));
+}
+
+//Header then the Bit-Packed Fields into out, which Holds SNAPSHOT_WIRE_BUFFER Bytes; Returns the Bytes to Send
+inline size_t encodeSnapshot(const SnapshotPacket& packet, uint8_t* out)
+{
+	memcpy(out, &packet.header, sizeof(NetHeader));
+	return sizeof(NetHeader) + encodeSchema<SnapshotSchema>(packet, out + sizeof(NetHeader));
+}
+
+//Unpack a Received Snapshot, False if it is Cut Short; data is Readable for SNAPSHOT_WIRE_BUFFER Bytes, as Receive Buffers of NET_MAX_PACKET are
+inline bool readSnapshot(const void* data, size_t size, SnapshotPacket& packet)
+{
+	if (size < sizeof(NetHeader)) {
+		return false;
+	}
+	memcpy(&packet.header, data, sizeof(NetHeader));
+	packet.reserved = 0;
+	return decodeSchema<SnapshotSchema>((const uint8_t*)data + sizeof(NetHeader), size - sizeof(NetHeader), packet);
+}
+
+//Fill the Parts of a State a Snapshot Carries, for Drawing or Bots
+inline void unpackSnapshot(const SnapshotPacket& packet, SimState& state)
+{
+	state.tick = packet.tick;
+	state.hash = packet.hash;
+	state.paddles[0] = packet.paddles[0];
+	state.paddles[1] = packet.paddles[1];
+	state.score[0] = packet.score[0];
+	state.score[1] = packet.score[1];
+	state.noBalls = packet.noBalls;
+	memcpy(state.balls, packet.balls, packet.noBalls * sizeof(Ball));
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+/*
+	NUMA placement for the batch tools, without libnuma. The topology comes
+	from /sys/devices/system/node, limited to the CPUs this process may run
+	on. Memory is placed by first touch: pages land on the node of the
+	thread that first writes them, so a pinned thread allocating and filling
+	its own buffers keeps them local. Large buffers can ask for transparent
+	huge pages to cut TLB misses. Elsewhere than Linux everything is one
+	node and pinning does nothing.
+*/
+
+/* - Topology - */
+
+struct NumaNode {
+	uint32_t id;
+	std::vector<uint32_t> cpus;
+};
+
+struct NumaTopology {
+	std::vector<NumaNode> nodes;
+};
+
+//Where a Worker Thread Runs
+struct ThreadPlace {
+	uint32_t node;	//Index into NumaTopology::nodes
+	uint32_t cpu;
+};
+
+//Parse a Kernel CPU or Node List such as "0-3,8,10-11"
+inline void parseCpuList(const char* text, std::vector<uint32_t>& cpus)
+{
+	while (*text) {
+		char* end;
+		unsigned long first = strtoul(text, &end, 10);
+		if (end == text) {
+			break;
+		}
+		unsigned long last = first;
+		if (*end == '-') {
+			last = strtoul(end + 1, &end, 10);
+		}
+		for (unsigned long cpu = first; cpu <= last; cpu++) {
+			cpus.push_back((uint32_t)cpu);
+		}
+		text = *end == ',' ? end + 1 : end;
+	}
+}
+
+//Nodes with at least One CPU we may Run on; a Single Node of every CPU when there is no NUMA Information
+inline void detectTopology(NumaTopology& topology)
+{
+	topology.nodes.clear();
+#ifdef __linux__
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+
+	std::vector<uint32_t> ids;
+	char text[4096] = {};
+	FILE* online = fopen("/sys/devices/system/node/online", "r");
+	if (online) {
+		text[fread(text, 1, sizeof(text) - 1, online)] = 0;
+		fclose(online);
+		parseCpuList(text, ids);
+	}
+
+	for (uint32_t id : ids) {
+		std::string path = "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist";
+		FILE* file = fopen(path.c_str(), "r");
+		if (!file) {
+			continue;
+		}
+		text[fread(text, 1, sizeof(text) - 1, file)] = 0;
+		fclose(file);
+
+		NumaNode node;
+		node.id = id;
+		std::vector<uint32_t> cpus;
+		parseCpuList(text, cpus);
+		for (uint32_t cpu : cpus) {
+			if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+				node.cpus.push_back(cpu);
+			}
+		}
+		if (!node.cpus.empty()) {
+			topology.nodes.push_back(node);
+		}
+	}
+	if (!topology.nodes.empty()) {
+		return;
+	}
+
+	NumaNode node;
+	node.id = 0;
+	for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &allowed)) {
+			node.cpus.push_back(cpu);
+		}
+	}
+	topology.nodes.push_back(node);
+#else
+	NumaNode node;
+	node.id = 0;
+	for (uint32_t cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++) {
+		node.cpus.push_back(cpu);
+	}
+	topology.nodes.push_back(node);
+#endif
+}
+
+//Spread noThreads across Nodes in Turn, so every Socket's Cores and Memory Controllers Share the Work
+inline void placeThreads(const NumaTopology& topology, uint32_t noThreads, std::vector<ThreadPlace>& places)
+{
+	places.clear();
+	uint32_t noNodes = (uint32_t)topology.nodes.size();
+	for (uint32_t t = 0; t < noThreads; t++) {
+		uint32_t node = t % noNodes;
+		const std::vector<uint32_t>& cpus = topology.nodes[node].cpus;
+		places.push_back({ node, cpus[(t / noNodes) % cpus.size()] });
+	}
+}
+
+//Pin the Calling Thread to a CPU; False where Unsupported or Refused
+inline bool pinThread(uint32_t cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+/* - Pages - */
+
+const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+//Fresh Untouched Pages, so the First Thread to Write them Decides their Node; Huge Pages are a Hint the Kernel may Ignore
+inline void* allocPages(size_t size, bool hugePages)
+{
+#ifdef __linux__
+	if (!hugePages) {
+		void* pages = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return pages == MAP_FAILED ? NULL : pages;
+	}
+
+	//Transparent Huge Pages Need 2 MB Aligned Ranges, so Map Extra and Trim both Ends
+	size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+	void* mapping = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		return NULL;
+	}
+	uintptr_t start = ((uintptr_t)mapping + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+	size_t head = start - (uintptr_t)mapping;
+	if (head > 0) {
+		munmap(mapping, head);
+	}
+	munmap((void*)(start + size), HUGE_PAGE_SIZE - head);
+	madvise((void*)start, size, MADV_HUGEPAGE);
+	return (void*)start;
+#else
+	(void)hugePages;
+	return malloc(size);
+#endif
+}
+
+//size and hugePages as Allocated
+inline void freePages(void* pages, size_t size, bool hugePages)
+{
+#ifdef __linux__
+	if (hugePages) {
+		size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+	}
+	munmap(pages, size);
+#else
+	(void)size;
+	(void)hugePages;
+	free(pages);
+#endif
+}
+
+//Containers on allocPages, for Buffers a Pinned Thread Allocates and Fills Itself
+template<typename T>
+struct PageAllocator {
+	typedef T value_type;
+	bool hugePages = false;
+
+	PageAllocator() {}
+	explicit PageAllocator(bool huge) : hugePages(huge) {}
+	template<typename U>
+	PageAllocator(const PageAllocator<U>& other) : hugePages(other.hugePages) {}
+
+	T* allocate(size_t n)
+	{
+		void* pages = allocPages(n * sizeof(T), hugePages);
+		if (!pages) {
+			throw std::bad_alloc();
+		}
+		return (T*)pages;
+	}
+
+	void deallocate(T* pages, size_t n)
+	{
+		freePages(pages, n * sizeof(T), hugePages);
+	}
+};
+
+template<typename T, typename U>
+inline bool operator==(const PageAllocator<T>& a, const PageAllocator<U>& b)
+{
+	return a.hugePages == b.hugePages;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const PageAllocator<T>& a, const PageAllocator<U>& b)
+{
+	return !(a == b);
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHILOX_SSE2
+#endif
+
+/*
+	Philox4x32-10 counter-based random numbers (Salmon et al., "Parallel
+	Random Numbers: As Easy as 1, 2, 3"). The output is a pure function of
+	a 128-bit counter and a 64-bit key, so there is no generator state to
+	carry around or share between threads: the simulation names each
+	number it needs by (seed, match, tick, purpose) and gets the same value
+	on every run, machine and thread schedule.
+*/
+
+/* - Philox4x32-10 - */
+
+struct PhiloxKey {
+	uint32_t k[2];
+};
+
+struct PhiloxBlock {
+	uint32_t v[4];
+};
+
+const uint32_t PHILOX_M0 = 0xD2511F53;
+const uint32_t PHILOX_M1 = 0xCD9E8D57;
+const uint32_t PHILOX_W0 = 0x9E3779B9;
+const uint32_t PHILOX_W1 = 0xBB67AE85;
+const uint32_t PHILOX_ROUNDS = 10;
+
+inline PhiloxKey philoxKey(uint64_t seed)
+{
+	return { { (uint32_t)seed, (uint32_t)(seed >> 32) } };
+}
+
+inline PhiloxBlock philox(PhiloxBlock ctr, PhiloxKey key)
+{
+	for (uint32_t r = 0; r < PHILOX_ROUNDS; r++) {
+		uint64_t p0 = (uint64_t)PHILOX_M0 * ctr.v[0];
+		uint64_t p1 = (uint64_t)PHILOX_M1 * ctr.v[2];
+		ctr = { { (uint32_t)(p1 >> 32) ^ ctr.v[1] ^ key.k[0], (uint32_t)p1,
+			(uint32_t)(p0 >> 32) ^ ctr.v[3] ^ key.k[1], (uint32_t)p0 } };
+		key.k[0] += PHILOX_W0;
+		key.k[1] += PHILOX_W1;
+	}
+	return ctr;
+}
+
+//Top 24 Bits as a Float in [0, 1)
+inline float philoxUniform(uint32_t word)
+{
+	return (word >> 8) * (1.0f / 16777216.0f);
+}
+
+/* - Batch Generation - */
+
+//Blocks for Counters ctr, ctr + 1, ... (Incrementing Word 0) into out, n * 4 Words
+inline void philoxBatch(PhiloxBlock ctr, PhiloxKey key, uint32_t n, uint32_t* out)
+{
+	uint32_t i = 0;
+#ifdef PHILOX_SSE2
+	//Four Blocks at a Time, Lane j of Register w Holding Word w of Block i + j
+	const __m128i m0 = _mm_set1_epi32((int)PHILOX_M0);
+	const __m128i m1 = _mm_set1_epi32((int)PHILOX_M1);
+	const __m128i lowMask = _mm_set1_epi64x(0xFFFFFFFF);
+	for (; i + 4 <= n; i += 4) {
+		__m128i c0 = _mm_add_epi32(_mm_set1_epi32((int)(ctr.v[0] + i)), _mm_setr_epi32(0, 1, 2, 3));
+		__m128i c1 = _mm_set1_epi32((int)ctr.v[1]);
+		__m128i c2 = _mm_set1_epi32((int)ctr.v[2]);
+		__m128i c3 = _mm_set1_epi32((int)ctr.v[3]);
+		uint32_t k0 = key.k[0];
+		uint32_t k1 = key.k[1];
+
+		for (uint32_t r = 0; r < PHILOX_ROUNDS; r++) {
+			//_mm_mul_epu32 Multiplies the Even Lanes, so Odd Lanes are Shifted Down for a Second Multiply
+			__m128i p0Even = _mm_mul_epu32(c0, m0);
+			__m128i p0Odd = _mm_mul_epu32(_mm_srli_epi64(c0, 32), m0);
+			__m128i p1Even = _mm_mul_epu32(c2, m1);
+			__m128i p1Odd = _mm_mul_epu32(_mm_srli_epi64(c2, 32), m1);
+
+			__m128i lo0 = _mm_or_si128(_mm_and_si128(p0Even, lowMask), _mm_slli_epi64(p0Odd, 32));
+			__m128i hi0 = _mm_or_si128(_mm_srli_epi64(p0Even, 32), _mm_andnot_si128(lowMask, p0Odd));
+			__m128i lo1 = _mm_or_si128(_mm_and_si128(p1Even, lowMask), _mm_slli_epi64(p1Odd, 32));
+			__m128i hi1 = _mm_or_si128(_mm_srli_epi64(p1Even, 32), _mm_andnot_si128(lowMask, p1Odd));
+
+			__m128i n0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32((int)k0));
+			__m128i n2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32((int)k1));
+			c0 = n0;
+			c1 = lo1;
+			c2 = n2;
+			c3 = lo0;
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
+		}
+
+		//Transpose back to Whole Blocks
+		__m128i t0 = _mm_unpacklo_epi32(c0, c1);
+		__m128i t1 = _mm_unpacklo_epi32(c2, c3);
+		__m128i t2 = _mm_unpackhi_epi32(c0, c1);
+		__m128i t3 = _mm_unpackhi_epi32(c2, c3);
+		_mm_storeu_si128((__m128i*)(out + i * 4 + 0), _mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128((__m128i*)(out + i * 4 + 4), _mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128((__m128i*)(out + i * 4 + 8), _mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128((__m128i*)(out + i * 4 + 12), _mm_unpackhi_epi64(t2, t3));
+	}
+#endif
+	for (; i < n; i++) {
+		PhiloxBlock c = ctr;
+		c.v[0] += i;
+		PhiloxBlock b = philox(c, key);
+		for (int j = 0; j < 4; j++) {
+			out[i * 4 + j] = b.v[j];
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef RALLY_H
+#define RALLY_H
+
+#include "sim.h"
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/*
+	Per-rally statistics gathered from simulation events. A rally runs from
+	a ball's serve until it leaves the arena; every field is an unsigned
+	integer so rows go straight into the column store (columns.h).
+*/
+
+/* - Rally Rows - */
+
+struct RallyRow {
+	uint32_t match;
+	uint32_t length;		//Ticks from Serve to Point
+	uint32_t hits;			//Paddle Returns
+	uint32_t hitOffset;		//Mean Hit Position on the Paddle, 0 Bottom Edge to 254 Top Edge, 127 without Hits
+	uint32_t speed;			//Ball Speed when the Point was Won, Arena Units per Second
+	uint32_t winner;		//Player who Won the Point
+};
+
+//Column Names in RallyRow Order
+const char* const RALLY_COLUMNS[] = { "match", "length", "hits", "hitOffset", "speed", "winner" };
+const uint32_t NO_RALLY_COLUMNS = 6;
+
+static_assert(sizeof(RallyRow) == NO_RALLY_COLUMNS * sizeof(uint32_t), "RallyRow fields map one to one onto columns");
+
+//Field i of a Row, in Column Order
+inline uint32_t rallyField(const RallyRow& row, uint32_t column)
+{
+	uint32_t value;
+	memcpy(&value, (const char*)&row + column * sizeof(uint32_t), sizeof(uint32_t));
+	return value;
+}
+
+/* - Tracking - */
+
+//Rally in Progress for each Ball
+struct RallyTracker {
+	uint32_t match;
+	uint64_t start[MAX_BALLS];
+	uint32_t hits[MAX_BALLS];
+	float offsetSum[MAX_BALLS];
+};
+
+//Every Ball Starts a Rally at the Current Tick
+inline void initRallyTracker(RallyTracker& tracker, const SimState& state, uint32_t match)
+{
+	tracker.match = match;
+	for (uint32_t i = 0; i < MAX_BALLS; i++) {
+		tracker.start[i] = state.tick;
+		tracker.hits[i] = 0;
+		tracker.offsetSum[i] = 0.0f;
+	}
+}
+
+//Fold in a Tick's Events, Appending a Row for every Point Scored; Any Allocator, so Pinned Workers can Keep Rows in their Own Pages
+template<typename Alloc>
+inline void trackRallies(RallyTracker& tracker, const SimState& state, const SimEvents& events, std::vector<RallyRow, Alloc>& rows)
+{
+	for (const PaddleHit& hit : events.paddleHits) {
+		tracker.hits[hit.ball]++;
+		tracker.offsetSum[hit.ball] += hit.offset;
+	}
+
+	for (const BallScore& score : events.scores) {
+		uint32_t ball = score.ball;
+		float meanOffset = tracker.hits[ball] > 0 ? tracker.offsetSum[ball] / tracker.hits[ball] : 0.0f;
+		meanOffset = fmaxf(-1.0f, fminf(meanOffset, 1.0f));
+
+		RallyRow row;
+		row.match = tracker.match;
+		row.length = (uint32_t)(state.tick - tracker.start[ball]);
+		row.hits = tracker.hits[ball];
+		row.hitOffset = (uint32_t)lrintf(meanOffset * 127.0f + 127.0f);
+		row.speed = (uint32_t)lrintf(score.speed);
+		row.winner = score.scorer;
+		rows.push_back(row);
+
+		tracker.start[ball] = state.tick;
+		tracker.hits[ball] = 0;
+		tracker.offsetSum[ball] = 0.0f;
+	}
+}
+
+#endif
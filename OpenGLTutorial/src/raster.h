@@ -0,0 +1,106 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "vecmath.h"
+#include "instances.h"
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/*
+	Software rasterizer for headless rendering of the arena, so matches can
+	be drawn on machines without a GPU. Only what the game draws is
+	supported: solid axis aligned quads and solid circles. A pixel is
+	covered when its centre is inside the shape, like GL's rasterization
+	rules, so the output lines up with the windowed game.
+*/
+
+/* - Framebuffer - */
+
+//RGBA8 Pixels, Red in the Low Byte, Row 0 at the Top
+struct Framebuffer {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint32_t> pixels;
+};
+
+inline void initFramebuffer(Framebuffer& fb, uint32_t width, uint32_t height)
+{
+	fb.width = width;
+	fb.height = height;
+	fb.pixels.assign((size_t)width * height, 0);
+}
+
+inline uint32_t packColor(const vec4& color)
+{
+	return quantizeUnorm(color.x, 255.0f) | quantizeUnorm(color.y, 255.0f) << 8
+		| quantizeUnorm(color.z, 255.0f) << 16 | quantizeUnorm(color.w, 255.0f) << 24;
+}
+
+inline void clearFramebuffer(Framebuffer& fb, uint32_t color)
+{
+	std::fill(fb.pixels.begin(), fb.pixels.end(), color);
+}
+
+/* - Arena to Pixel Mapping - */
+
+//Arena Units (y up) to Pixels (y down), Scaled to Fill the Framebuffer as the Window's Projection Does
+struct RasterView {
+	float scaleX;
+	float scaleY;
+	float height;
+};
+
+inline RasterView rasterView(const Framebuffer& fb, float arenaWidth, float arenaHeight)
+{
+	return { fb.width / arenaWidth, fb.height / arenaHeight, (float)fb.height };
+}
+
+/* - Primitives - */
+
+//Pixels with Centres in [min, max), in Pixel Coordinates
+inline void fillRect(Framebuffer& fb, float minX, float minY, float maxX, float maxY, uint32_t color)
+{
+	int x0 = std::max(0, (int)ceilf(minX - 0.5f));
+	int y0 = std::max(0, (int)ceilf(minY - 0.5f));
+	int x1 = std::min((int)fb.width, (int)ceilf(maxX - 0.5f));
+	int y1 = std::min((int)fb.height, (int)ceilf(maxY - 0.5f));
+	for (int y = y0; y < y1; y++) {
+		uint32_t* row = &fb.pixels[(size_t)y * fb.width];
+		std::fill(row + x0, row + std::max(x0, x1), color);
+	}
+}
+
+//Ellipse so Circles Stay Round only when the Framebuffer Keeps the Arena's Aspect, like the Game
+inline void fillEllipse(Framebuffer& fb, float cx, float cy, float rx, float ry, uint32_t color)
+{
+	int y0 = std::max(0, (int)ceilf(cy - ry - 0.5f));
+	int y1 = std::min((int)fb.height, (int)ceilf(cy + ry - 0.5f));
+	for (int y = y0; y < y1; y++) {
+		float dy = (y + 0.5f - cy) / ry;
+		float halfSpan = rx * sqrtf(std::max(0.0f, 1.0f - dy * dy));
+		fillRect(fb, cx - halfSpan, (float)y, cx + halfSpan, y + 1.0f, color);
+	}
+}
+
+/* - Instances - */
+
+//Draw a Render Record the way pull.vs Places it
+inline void rasterInstance(Framebuffer& fb, const RasterView& view, const InstanceRecord& record, InstanceShape shape)
+{
+	float cx = record.offset.x * view.scaleX;
+	float cy = view.height - record.offset.y * view.scaleY;
+	float hx = record.size.x * view.scaleX / 2.0f;
+	float hy = record.size.y * view.scaleY / 2.0f;
+	uint32_t color = packColor(record.color);
+	if (shape == SHAPE_CIRCLE) {
+		fillEllipse(fb, cx, cy, hx, hy, color);
+	}
+	else {
+		fillRect(fb, cx - hx, cy - hy, cx + hx, cy + hy, color);
+	}
+}
+
+#endif
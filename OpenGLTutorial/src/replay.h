@@ -0,0 +1,362 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "sim.h"
+#include "level_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+	Recorded matches. The simulation is deterministic, so a replay is only
+	the parameters, the level and the buttons held on every tick; playing
+	it back means stepping the same simulation with the same input.
+	Inputs are stored on disk as runs, since buttons are held for hundreds
+	of ticks at a time.
+
+	For seeking, the recorder also keeps a keyframe of the small part of the
+	state every REPLAY_KEYFRAME_INTERVAL ticks and a log of obstacle hits.
+	Obstacle hit points only ever go down, so a keyframe just remembers how
+	much of the log had happened; seeking replays that much of the log onto
+	the level's starting hit points, then simulates the ticks remaining
+	after the keyframe.
+
+	The low 32 bits of the rolling state hash (see hashTick) are logged
+	at the end of every hash window of HASH_WINDOW ticks, so a replay
+	played back on another build or machine can name the first window
+	where it desynced, and desync can step through that window for the
+	tick.
+
+	Replays come from other machines, so reading one checks every count
+	against the file's size and every index against what it indexes
+	before anything is allocated or seeked.
+*/
+
+/* - Format - */
+
+const char REPLAY_MAGIC[4] = { 'P', 'R', 'P', 'L' };
+const uint32_t REPLAY_VERSION = 8;
+
+//Ticks between Keyframes, the most a Seek has to Simulate
+const uint32_t REPLAY_KEYFRAME_INTERVAL = 250;
+
+//Largest Level a Replay may Generate, Well Past any Playable Level, so a Corrupt Header cannot Allocate Gigabytes
+const uint32_t REPLAY_MAX_OBSTACLES = 1 << 24;
+
+static_assert(std::is_trivially_copyable<SimParams>::value, "SimParams is written to replays as raw bytes");
+
+struct ReplayHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t noBalls;
+	uint32_t noObstacles;		//Obstacles in the Level, Generated to this Size when levelPathLength is 0
+	uint32_t levelPathLength;	//Bytes of Level File Path Following the Header
+	uint32_t noRuns;
+	uint64_t noTicks;
+	uint32_t keyframeInterval;
+	uint32_t noKeyframes;
+	uint64_t noHits;
+	uint64_t seed;
+	uint32_t match;
+	uint32_t reserved;
+	SimParams params;
+};
+
+//Input Held for count Consecutive Ticks
+struct ReplayRun {
+	uint32_t input;
+	uint32_t count;
+};
+
+//State at the Start of Tick keyframeInterval * k, Everything but Obstacle Hit Points
+struct ReplayKeyframe {
+	uint64_t tick;
+	vec2 paddles[2];
+	Ball balls[MAX_BALLS];
+	uint32_t noBalls;
+	uint32_t score[2];
+	uint32_t reserved;
+	uint64_t noHits;	//Entries of the Hit Log before this Tick
+	uint64_t hash;		//Rolling State Hash before this Tick
+	FixedMotion motion;	//Paddles and Balls in Fixed Point Mode
+};
+
+struct Replay {
+	SimParams params;
+	uint32_t noBalls = 1;
+	uint32_t noObstacles = 0;
+	uint64_t seed = 0;
+	uint32_t match = 0;
+	std::string levelPath;
+
+	//Buttons per Tick
+	std::vector<uint8_t> inputs;
+
+	//Seek Index, Keyframe k at Tick keyframeInterval * k
+	uint32_t keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+	std::vector<ReplayKeyframe> keyframes;
+
+	//Obstacle Index per Hit Point Lost, in Simulation Order
+	std::vector<uint32_t> hits;
+
+	//Low Bits of the Rolling State Hash after each Whole Hash Window, Entry w after Tick (w + 1) * HASH_WINDOW - 1
+	std::vector<uint32_t> hashes;
+};
+
+/* - Writing - */
+
+inline bool writeReplay(const char* path, const Replay& replay)
+{
+	if (replay.hashes.size() != replay.inputs.size() / HASH_WINDOW) {
+		std::cout << "Replay for " << path << " has " << replay.hashes.size() << " window hashes for " << replay.inputs.size() << " ticks" << std::endl;
+		return false;
+	}
+
+	std::vector<ReplayRun> runs;
+	for (uint8_t input : replay.inputs) {
+		if (!runs.empty() && runs.back().input == input) {
+			runs.back().count++;
+		}
+		else {
+			runs.push_back({ input, 1 });
+		}
+	}
+
+	ReplayHeader header = {};
+	memcpy(header.magic, REPLAY_MAGIC, 4);
+	header.version = REPLAY_VERSION;
+	header.noBalls = replay.noBalls;
+	header.noObstacles = replay.noObstacles;
+	header.levelPathLength = (uint32_t)replay.levelPath.size();
+	header.noRuns = (uint32_t)runs.size();
+	header.noTicks = replay.inputs.size();
+	header.keyframeInterval = replay.keyframeInterval;
+	header.noKeyframes = (uint32_t)replay.keyframes.size();
+	header.noHits = replay.hits.size();
+	header.seed = replay.seed;
+	header.match = replay.match;
+	header.params = replay.params;
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write(replay.levelPath.data(), replay.levelPath.size());
+	file.write((const char*)runs.data(), runs.size() * sizeof(ReplayRun));
+	file.write((const char*)replay.keyframes.data(), replay.keyframes.size() * sizeof(ReplayKeyframe));
+	file.write((const char*)replay.hits.data(), replay.hits.size() * sizeof(uint32_t));
+	file.write((const char*)replay.hashes.data(), replay.hashes.size() * sizeof(uint32_t));
+	return file.good();
+}
+
+/* - Reading - */
+
+inline bool readReplay(const char* path, Replay& replay)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	ReplayHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, REPLAY_MAGIC, 4) != 0) {
+		std::cout << path << " is not a replay" << std::endl;
+		return false;
+	}
+	if (header.version != REPLAY_VERSION) {
+		std::cout << path << " is replay format version " << header.version << ", expected " << REPLAY_VERSION << std::endl;
+		return false;
+	}
+
+	//Sections must Add up to the File, Counts Checked One at a Time so the Sum cannot Overflow
+	file.seekg(0, std::ios::end);
+	uint64_t left = (uint64_t)file.tellg() - sizeof(header);
+	file.seekg(sizeof(header));
+	auto takeSection = [&](uint64_t count, uint64_t size) {
+		if (count > left / size) {
+			return false;
+		}
+		left -= count * size;
+		return true;
+	};
+	if (!takeSection(header.levelPathLength, 1) || !takeSection(header.noRuns, sizeof(ReplayRun))
+		|| !takeSection(header.noKeyframes, sizeof(ReplayKeyframe)) || !takeSection(header.noHits, sizeof(uint32_t))
+		|| !takeSection(header.noTicks / HASH_WINDOW, sizeof(uint32_t)) || left != 0) {
+		std::cout << path << " is truncated or corrupt" << std::endl;
+		return false;
+	}
+	if (header.noBalls == 0 || header.noBalls > MAX_BALLS || header.noObstacles > REPLAY_MAX_OBSTACLES || header.keyframeInterval == 0
+		|| header.noKeyframes > header.noTicks / header.keyframeInterval + 1) {
+		std::cout << path << " has a corrupt header" << std::endl;
+		return false;
+	}
+
+	replay.params = header.params;
+	replay.noBalls = header.noBalls;
+	replay.noObstacles = header.noObstacles;
+	replay.seed = header.seed;
+	replay.match = header.match;
+	replay.levelPath.resize(header.levelPathLength);
+	std::vector<ReplayRun> runs(header.noRuns);
+	replay.keyframeInterval = header.keyframeInterval;
+	replay.keyframes.resize(header.noKeyframes);
+	replay.hits.resize(header.noHits);
+	replay.hashes.resize(header.noTicks / HASH_WINDOW);
+	file.read(&replay.levelPath[0], header.levelPathLength);
+	file.read((char*)runs.data(), runs.size() * sizeof(ReplayRun));
+	file.read((char*)replay.keyframes.data(), replay.keyframes.size() * sizeof(ReplayKeyframe));
+	file.read((char*)replay.hits.data(), replay.hits.size() * sizeof(uint32_t));
+	file.read((char*)replay.hashes.data(), replay.hashes.size() * sizeof(uint32_t));
+	if (!file) {
+		std::cout << path << " is truncated" << std::endl;
+		return false;
+	}
+
+	//Runs must Cover Exactly the Ticks, Summed before Expanding so a Corrupt Count cannot Allocate
+	uint64_t noRunTicks = 0;
+	for (const ReplayRun& run : runs) {
+		noRunTicks += run.count;
+	}
+	if (noRunTicks != header.noTicks) {
+		std::cout << path << " has " << noRunTicks << " ticks of input, expected " << header.noTicks << std::endl;
+		return false;
+	}
+	replay.inputs.clear();
+	replay.inputs.reserve(header.noTicks);
+	for (const ReplayRun& run : runs) {
+		replay.inputs.insert(replay.inputs.end(), run.count, (uint8_t)run.input);
+	}
+
+	//Seeking Indexes Hit Points by the Hit Log and Balls by the Keyframes' Counts, which a Match Never Changes
+	for (uint32_t obstacle : replay.hits) {
+		if (obstacle >= replay.noObstacles) {
+			std::cout << path << " hits obstacle " << obstacle << " of " << replay.noObstacles << std::endl;
+			return false;
+		}
+	}
+	for (uint32_t k = 0; k < header.noKeyframes; k++) {
+		const ReplayKeyframe& keyframe = replay.keyframes[k];
+		if (keyframe.tick != (uint64_t)k * replay.keyframeInterval || keyframe.noBalls != replay.noBalls
+			|| keyframe.noHits > replay.hits.size() || (k > 0 && keyframe.noHits < replay.keyframes[k - 1].noHits)) {
+			std::cout << path << " has a corrupt keyframe " << k << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/* - Recording - */
+
+//Step the Simulation, Recording the Tick's Input and Hits, the Hash when it Ends a Window, and a Keyframe before it when one is Due
+inline void stepRecorded(Replay& replay, SimState& state, const Level& level, uint8_t input, const SimParams& params, SimEvents& events)
+{
+	if (state.tick % replay.keyframeInterval == 0 && state.tick / replay.keyframeInterval == replay.keyframes.size()) {
+		ReplayKeyframe keyframe = {};
+		keyframe.tick = state.tick;
+		keyframe.paddles[0] = state.paddles[0];
+		keyframe.paddles[1] = state.paddles[1];
+		memcpy(keyframe.balls, state.balls, sizeof(state.balls));
+		keyframe.noBalls = state.noBalls;
+		keyframe.score[0] = state.score[0];
+		keyframe.score[1] = state.score[1];
+		keyframe.noHits = replay.hits.size();
+		keyframe.hash = state.hash;
+		keyframe.motion = state.motion;
+		replay.keyframes.push_back(keyframe);
+	}
+
+	stepSim(state, level, input, params, &events);
+	replay.inputs.push_back(input);
+	replay.hits.insert(replay.hits.end(), events.damaged.begin(), events.damaged.end());
+	if (state.tick % HASH_WINDOW == 0) {
+		replay.hashes.push_back((uint32_t)state.hash);
+	}
+}
+
+/* - Playback - */
+
+//Whether a Replay's Hit Log Indexes level's Obstacles and Never Hits one More than its Hit Points,
+//which Seeking would Wrap to OBSTACLE_STATIC; a Level File can Change after Recording
+inline bool replayFitsLevel(const Replay& replay, const Level& level)
+{
+	if (level.noObstacles != replay.noObstacles) {
+		std::cout << "Replay expects " << replay.noObstacles << " obstacles, its level has " << level.noObstacles << std::endl;
+		return false;
+	}
+	std::vector<uint32_t> noHits(level.noObstacles, 0);
+	for (uint32_t obstacle : replay.hits) {
+		uint32_t hp = level.obstacles[obstacle].hp;
+		if (hp == OBSTACLE_STATIC || ++noHits[obstacle] > hp) {
+			std::cout << "Replay hits obstacle " << obstacle << " more than its " << (hp == OBSTACLE_STATIC ? 0 : hp) << " hit points" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//Load or Generate the Replay's Level; levelFile Holds the Mapping for Loaded Levels
+inline bool loadReplayLevel(const Replay& replay, Level& level, LevelFile& levelFile)
+{
+	if (!replay.levelPath.empty()) {
+		if (!loadLevelFile(levelFile, level, replay.levelPath.c_str())) {
+			return false;
+		}
+	}
+	else {
+		genBrickLevel(level, replay.noObstacles, replay.params.arenaWidth, replay.params.arenaHeight);
+	}
+	return replayFitsLevel(replay, level);
+}
+
+//Put state at the Start of tick (0 to the Replay's Length), from the Nearest Keyframe at or before it;
+//False, Leaving state Alone, for Ticks Past the End or a Replay that does not Fit level
+inline bool seekReplay(const Replay& replay, const Level& level, SimState& state, uint64_t tick)
+{
+	if (tick > replay.inputs.size() || level.noObstacles != replay.noObstacles) {
+		return false;
+	}
+
+	//Keyframes are Evenly Spaced, so the Index is a Division
+	uint64_t k = tick / replay.keyframeInterval;
+	if (replay.keyframes.empty()) {
+		initSim(state, level, replay.noBalls, replay.params, replay.seed, replay.match);
+	}
+	else {
+		const ReplayKeyframe& keyframe = replay.keyframes[k < replay.keyframes.size() ? k : replay.keyframes.size() - 1];
+		state.seed = replay.seed;
+		state.match = replay.match;
+		state.tick = keyframe.tick;
+		state.paddles[0] = keyframe.paddles[0];
+		state.paddles[1] = keyframe.paddles[1];
+		memcpy(state.balls, keyframe.balls, sizeof(state.balls));
+		state.noBalls = keyframe.noBalls;
+		state.score[0] = keyframe.score[0];
+		state.score[1] = keyframe.score[1];
+		state.motion = keyframe.motion;
+
+		state.obstacleHp.resize(level.noObstacles);
+		for (uint32_t i = 0; i < level.noObstacles; i++) {
+			state.obstacleHp[i] = level.obstacles[i].hp;
+		}
+		for (uint64_t i = 0; i < keyframe.noHits; i++) {
+			state.obstacleHp[replay.hits[i]]--;
+		}
+		resetHitPointHash(state);
+		state.hash = keyframe.hash;
+	}
+
+	while (state.tick < tick) {
+		stepSim(state, level, replay.inputs[state.tick], replay.params);
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "sim.h"
+
+#include <cstdint>
+
+/*
+	Game modes as compile time rule sets for the simulation kernels.
+	stepSim checks every mode's features at run time each tick: fixed point
+	or float, how many balls, whether to walk the obstacle BVH, whether to
+	record events. A RuleSet answers those with constants, so
+	stepSimRules<RuleSet<...>> is a kernel for that mode alone, with the
+	ball loop unrolled for a single ball, the BVH walk gone for empty
+	levels, and the event recording gone when nobody reads it. The
+	dispatch tables pick the kernel for a batch's params once, up front.
+
+	A rule set must agree with what it runs on: single-ball kernels need
+	state.noBalls == 1 and obstacle-free ones an empty level. ruleSetIndex
+	derives the table index from exactly those properties, so a kernel
+	picked through it fits; nothing checks a kernel called directly. Within
+	those bounds every kernel steps bit for bit as stepSim does, state
+	hashes included.
+*/
+
+/* - Rule Sets - */
+
+//Balls 0 for the State's Count
+template<uint32_t Balls, bool Obstacles, bool FixedPoint, bool Events>
+struct RuleSet {
+	static bool fixedPoint(const SimParams&)
+	{
+		return FixedPoint;
+	}
+
+	static uint32_t noBalls(const SimState& state)
+	{
+		return Balls > 0 ? Balls : state.noBalls;
+	}
+
+	static bool obstacles(const Level&)
+	{
+		return Obstacles;
+	}
+
+	static bool events(const SimEvents*)
+	{
+		return Events;
+	}
+};
+
+//The Modes by Name, with Events as the Batch Tools Record them
+typedef RuleSet<1, false, false, true> ClassicRules;
+typedef RuleSet<0, false, false, true> MultiBallRules;
+typedef RuleSet<1, true, false, true> ObstacleRules;
+typedef RuleSet<0, true, false, true> MultiBallObstacleRules;
+
+/* - Dispatch - */
+
+const uint32_t NO_RULE_SETS = 8;
+
+//Which Rule Set Fits: Bit 0 Multi-Ball, Bit 1 Obstacles, Bit 2 Fixed Point
+inline uint32_t ruleSetIndex(const SimParams& params, const Level& level, uint32_t noBalls)
+{
+	return (noBalls != 1 ? 1 : 0) | (level.noObstacles > 0 ? 2 : 0) | (params.fixedPoint ? 4 : 0);
+}
+
+typedef void (*StepKernel)(SimState&, const Level&, uint8_t, const SimParams&, SimEvents*);
+
+template<bool Events>
+inline StepKernel selectStepKernel(uint32_t index)
+{
+	static const StepKernel kernels[NO_RULE_SETS] = {
+		stepSimRules<RuleSet<1, false, false, Events>>,
+		stepSimRules<RuleSet<0, false, false, Events>>,
+		stepSimRules<RuleSet<1, true, false, Events>>,
+		stepSimRules<RuleSet<0, true, false, Events>>,
+		stepSimRules<RuleSet<1, false, true, Events>>,
+		stepSimRules<RuleSet<0, false, true, Events>>,
+		stepSimRules<RuleSet<1, true, true, Events>>,
+		stepSimRules<RuleSet<0, true, true, Events>>
+	};
+	return kernels[index];
+}
+
+//The Kernel for Matches of noBalls Balls on level; events Says whether Callers will Pass a SimEvents
+inline StepKernel selectStepKernel(const SimParams& params, const Level& level, uint32_t noBalls, bool events)
+{
+	uint32_t index = ruleSetIndex(params, level, noBalls < MAX_BALLS ? noBalls : MAX_BALLS);
+	return events ? selectStepKernel<true>(index) : selectStepKernel<false>(index);
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+	Bit-packed serialization from schemas declared once at compile time.
+	A schema lists a struct's fields with a codec for each: integers take
+	the bits they are given, and floats are quantized to a range and step,
+	taking just enough bits for that many steps. Encoding and decoding
+	unroll into straight-line code with every bit count and offset known
+	to the compiler. Writing shifts each field into a 64-bit register and
+	stores the whole word, reading is one unaligned load, shift and mask,
+	with no branch on the data either way (counted arrays loop over their
+	count). Bits are packed little-endian, as every struct this repo writes
+	raw is.
+
+	Buffers must have SCHEMA_SLACK bytes past the largest encoding, since
+	every write and read touches a whole 64-bit word; when decoding, that
+	is the buffer received into, not just the bytes received.
+*/
+
+/* - Bit Streams - */
+
+const size_t SCHEMA_SLACK = 8;
+
+struct BitWriter {
+	uint8_t* data;
+	size_t byte;		//Bytes Finished
+	uint64_t pending;	//Bits not yet Finished, Low First
+	uint32_t noPending;
+};
+
+struct BitReader {
+	const uint8_t* data;
+	size_t bit;
+};
+
+//Append up to 56 Bits; value must Fit in bits. Whole Bytes are Stored and Dropped from the Register
+inline void writeBits(BitWriter& writer, uint64_t value, uint32_t bits)
+{
+	writer.pending |= value << writer.noPending;
+	writer.noPending += bits;
+	memcpy(writer.data + writer.byte, &writer.pending, 8);
+	uint32_t done = writer.noPending >> 3;
+	writer.byte += done;
+	writer.pending >>= done * 8;
+	writer.noPending &= 7;
+}
+
+inline uint64_t readBits(BitReader& reader, uint32_t bits)
+{
+	uint64_t word;
+	memcpy(&word, reader.data + (reader.bit >> 3), 8);
+	uint64_t value = (word >> (reader.bit & 7)) & ((uint64_t)-1 >> (64 - bits));
+	reader.bit += bits;
+	return value;
+}
+
+//Bits to Count from 0 to maxValue
+constexpr uint32_t bitsFor(uint64_t maxValue)
+{
+	return maxValue == 0 ? 0 : 1 + bitsFor(maxValue >> 1);
+}
+
+/* - Codecs - */
+
+//Unsigned Integer in Bits Bits, Split in Two above 32 so each Write Fits a Word
+template<uint32_t Bits>
+struct UIntCodec {
+	static_assert(Bits >= 1 && Bits <= 64, "Integers take 1 to 64 bits");
+	static const uint32_t bits = Bits;
+	static const uint32_t loBits = Bits > 32 ? 32 : Bits;
+	static const uint32_t hiBits = Bits > 32 ? Bits - 32 : 1;
+
+	template<typename T>
+	static void write(BitWriter& writer, const T& value)
+	{
+		writeBits(writer, (uint64_t)value & ((uint64_t)-1 >> (64 - loBits)), loBits);
+		if (Bits > 32) {
+			writeBits(writer, (uint64_t)value >> 32 & ((uint64_t)-1 >> (64 - hiBits)), hiBits);
+		}
+	}
+
+	template<typename T>
+	static void read(BitReader& reader, T& value)
+	{
+		uint64_t v = readBits(reader, loBits);
+		if (Bits > 32) {
+			v |= readBits(reader, hiBits) << 32;
+		}
+		value = (T)v;
+	}
+};
+
+//Float in [Lo, Hi] to the Nearest 1 / Scale, Clamped, in the Fewest Bits that Count the Steps
+template<int32_t Lo, int32_t Hi, uint32_t Scale>
+struct QuantizedCodec {
+	static_assert(Hi > Lo && Scale > 0, "Empty quantization range");
+	static const uint32_t steps = (uint32_t)(Hi - Lo) * Scale;
+	static const uint32_t bits = bitsFor(steps);
+
+	static void write(BitWriter& writer, float value)
+	{
+		float q = (value - (float)Lo) * (float)Scale + 0.5f;
+		q = std::min(std::max(q, 0.0f), (float)steps);
+		writeBits(writer, (uint32_t)q, bits);
+	}
+
+	static void read(BitReader& reader, float& value)
+	{
+		value = (float)readBits(reader, bits) * (1.0f / Scale) + (float)Lo;
+	}
+};
+
+//N Elements, each through Codec
+template<typename Codec, uint32_t N>
+struct ArrayCodec {
+	static const uint32_t bits = Codec::bits * N;
+
+	template<typename T>
+	static void write(BitWriter& writer, const T (&values)[N])
+	{
+		for (uint32_t i = 0; i < N; i++) {
+			Codec::write(writer, values[i]);
+		}
+	}
+
+	template<typename T>
+	static void read(BitReader& reader, T (&values)[N])
+	{
+		for (uint32_t i = 0; i < N; i++) {
+			Codec::read(reader, values[i]);
+		}
+	}
+};
+
+/* - Schemas - */
+
+//A Member of Owner and the Codec it goes through
+template<typename Owner, typename T, T Owner::*Member, typename Codec>
+struct Field {
+	static const uint32_t bits = Codec::bits;
+
+	static void write(BitWriter& writer, const Owner& owner)
+	{
+		Codec::write(writer, owner.*Member);
+	}
+
+	static void read(BitReader& reader, Owner& owner)
+	{
+		Codec::read(reader, owner.*Member);
+	}
+};
+
+//The First Count of N Elements, Count Written First; bits is the Most it can Take
+template<typename Owner, uint32_t Owner::*Count, typename T, uint32_t N, T (Owner::*Items)[N], typename Codec>
+struct CountedField {
+	static const uint32_t countBits = bitsFor(N);
+	static const uint32_t bits = countBits + Codec::bits * N;
+
+	static void write(BitWriter& writer, const Owner& owner)
+	{
+		uint32_t count = std::min(owner.*Count, N);
+		writeBits(writer, count, countBits);
+		for (uint32_t i = 0; i < count; i++) {
+			Codec::write(writer, (owner.*Items)[i]);
+		}
+	}
+
+	static void read(BitReader& reader, Owner& owner)
+	{
+		uint32_t count = std::min((uint32_t)readBits(reader, countBits), N);
+		owner.*Count = count;
+		for (uint32_t i = 0; i < count; i++) {
+			Codec::read(reader, (owner.*Items)[i]);
+		}
+	}
+};
+
+template<typename... Fields>
+struct SumBits;
+
+template<>
+struct SumBits<> {
+	static const uint32_t value = 0;
+};
+
+template<typename First, typename... Rest>
+struct SumBits<First, Rest...> {
+	static const uint32_t value = First::bits + SumBits<Rest...>::value;
+};
+
+//Fields in Order; a Schema is also the Codec for its Owner, so Structs Nest
+template<typename... Fields>
+struct Schema {
+	static const uint32_t bits = SumBits<Fields...>::value;
+	static const size_t maxBytes = (bits + 7) / 8;
+
+	template<typename Owner>
+	static void write(BitWriter& writer, const Owner& owner)
+	{
+		int expand[] = { 0, (Fields::write(writer, owner), 0)... };
+		(void)expand;
+	}
+
+	template<typename Owner>
+	static void read(BitReader& reader, Owner& owner)
+	{
+		int expand[] = { 0, (Fields::read(reader, owner), 0)... };
+		(void)expand;
+	}
+};
+
+/* - Encoding - */
+
+//Pack into out, which Holds S::maxBytes + SCHEMA_SLACK; Returns the Bytes Used
+template<typename S, typename Owner>
+inline size_t encodeSchema(const Owner& owner, uint8_t* out)
+{
+	BitWriter writer = { out, 0, 0, 0 };
+	S::write(writer, owner);
+	return writer.byte + (writer.noPending + 7) / 8;
+}
+
+//Unpack size Bytes from data, Readable for S::maxBytes + SCHEMA_SLACK; False if they End before the Schema does,
+//in which case Fields Read from Past the End Hold Garbage
+template<typename S, typename Owner>
+inline bool decodeSchema(const uint8_t* data, size_t size, Owner& owner)
+{
+	BitReader reader = { data, 0 };
+	S::read(reader, owner);
+	return (reader.bit + 7) / 8 <= size;
+}
+
+#endif
@@ -0,0 +1,760 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "vecmath.h"
+#include "level.h"
+#include "philox.h"
+#include "fixed.h"
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/*
+	Fixed tick simulation of paddles, balls and obstacles. Nothing in here
+	touches GL or GLFW, so it runs the same in the game and in headless tools.
+
+	With fixedPoint set, paddles and balls move in Q16.16 instead (see
+	fixed.h), and the float paddles and balls are only a view of that for
+	drawing and bots. Integer stepping gives the same bits on every build,
+	which lockstep netplay and checking replays on other machines rely on.
+*/
+
+/* - Parameters - */
+
+struct SimParams {
+	float arenaWidth = 800.0f;
+	float arenaHeight = 600.0f;
+
+	float paddleSpeed = 175.0f;
+	float paddleHeight = 100.0f;
+	float paddleWidth = 10.0f;
+	float paddleInset = 35.0f;
+
+	float ballDiameter = 16.0f;
+	float ballSpeed = 300.0f;
+	float ballSpeedUp = 1.05f;		//Speed multiplier per paddle hit
+	float ballMaxSpeed = 900.0f;
+	float maxBounceAngle = 1.0472f;	//60 degrees at the paddle's edge
+
+	uint32_t tickRate = 1000;
+	uint32_t fixedPoint = 0;		//Step in Q16.16 for Bit-Identical Results on every Build
+};
+
+/* - State - */
+
+//Buttons Held during a Tick
+enum InputButtons {
+	INPUT_P0_UP = 1 << 0,
+	INPUT_P0_DOWN = 1 << 1,
+	INPUT_P1_UP = 1 << 2,
+	INPUT_P1_DOWN = 1 << 3
+};
+
+const uint32_t MAX_BALLS = 16;
+
+struct Ball {
+	vec2 pos;
+	vec2 vel;
+};
+
+//Q16.16 Paddles and Balls, Velocities in Arena Units per Tick; Balls are Split by Field for the SIMD Kernel
+struct FixedMotion {
+	fixed paddleY[2];
+	fixed ballX[MAX_BALLS];
+	fixed ballY[MAX_BALLS];
+	fixed ballVX[MAX_BALLS];
+	fixed ballVY[MAX_BALLS];
+};
+
+struct SimState {
+	uint64_t seed;		//Key for every Random Number, so Matches with the Same Input can still Differ
+	uint32_t match;		//Match Number within a Batch, Part of every Random Number's Counter
+	uint64_t tick;
+	vec2 paddles[2];
+	Ball balls[MAX_BALLS];
+	uint32_t noBalls;
+	uint32_t score[2];
+
+	//Authoritative Paddles and Balls in Fixed Point Mode, Unused Otherwise
+	FixedMotion motion;
+
+	//Remaining Hit Points per Level Obstacle, 0 once Destroyed
+	std::vector<uint32_t> obstacleHp;
+
+	//Checksums, see hashTick
+	uint64_t hash;		//Rolling Hash of every Tick so far
+	uint64_t hpHash;	//Sum of hashHitPoints over the Obstacles, Kept Current as they Lose Hit Points
+};
+
+//Ball Returned by a Paddle
+struct PaddleHit {
+	uint32_t ball;
+	uint32_t side;
+	float offset;	//Where on the Paddle, -1 Bottom Edge to 1 Top Edge
+	float speed;	//Ball Speed after the Hit
+};
+
+//Point Won when a Ball Left the Arena
+struct BallScore {
+	uint32_t ball;
+	uint32_t scorer;
+	float speed;
+};
+
+//What Happened during a Tick, for Renderers and Loggers
+struct SimEvents {
+	std::vector<uint32_t> damaged;		//Every Hit that Cost an Obstacle a Hit Point
+	std::vector<uint32_t> destroyed;
+	std::vector<PaddleHit> paddleHits;
+	std::vector<BallScore> scores;
+	int scoredBy = -1;
+
+	void clear()
+	{
+		damaged.clear();
+		destroyed.clear();
+		paddleHits.clear();
+		scores.clear();
+		scoredBy = -1;
+	}
+};
+
+/* - Randomness - */
+
+//What a Random Number is for, so Streams Never Overlap
+enum RandomPurpose {
+	RANDOM_SERVE = 0,
+	RANDOM_BOT = 1
+};
+
+//Random Block Named by (seed, match, tick, purpose, idx), the Same on every Run and Thread
+inline PhiloxBlock simRandom(const SimState& state, uint64_t tick, RandomPurpose purpose, uint32_t idx)
+{
+	PhiloxBlock ctr = { { (uint32_t)tick, (uint32_t)(tick >> 32), state.match, (uint32_t)purpose << 24 | idx } };
+	return philox(ctr, philoxKey(state.seed));
+}
+
+/* - Checksums - */
+
+/*
+	Every tick folds a hash of the moving state into state.hash, so two
+	runs agree on the hash at a tick only if they agreed on every tick
+	before it, and the first differing tick can be found by bisecting.
+	Obstacles are too many to hash each tick; their hit points are
+	summed into hpHash once and updated on each hit instead.
+*/
+
+inline uint64_t hashMix(uint64_t h)
+{
+	h = (h ^ (h >> 32)) * 0xD6E8FEB86659FD93ull;
+	h = (h ^ (h >> 32)) * 0xD6E8FEB86659FD93ull;
+	return h ^ (h >> 32);
+}
+
+inline uint64_t hashHitPoints(uint32_t obstacle, uint32_t hp)
+{
+	return hashMix((uint64_t)obstacle << 32 | hp);
+}
+
+inline void resetHitPointHash(SimState& state)
+{
+	state.hpHash = 0;
+	for (uint32_t i = 0; i < state.obstacleHp.size(); i++) {
+		state.hpHash += hashHitPoints(i, state.obstacleHp[i]);
+	}
+}
+
+inline uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+//Keys Step by this per Word, so every Position in a Tick's Hash has its Own
+const uint32_t HASH_KEY_STEP = 0x9E3779B9;
+
+//One Multiply per Pair of Words (NH, as in UMAC); Pairs are Independent, so they Overlap in the Pipeline
+inline uint64_t hashPair(uint32_t a, uint32_t b, uint32_t keyA, uint32_t keyB)
+{
+	return (uint64_t)(a + keyA) * (b + keyB);
+}
+
+//hashPair over Words (0, 1), (2, 3), ... Keyed key, key + HASH_KEY_STEP, ...; n a Multiple of 4
+inline uint64_t hashWordPairs(const void* words, uint32_t n, uint32_t key)
+{
+	uint64_t sum = 0;
+	uint32_t i = 0;
+#ifdef MATH_SSE2
+	//_mm_mul_epu32 Multiplies Lanes 0 and 2, so Shifting Lanes 1 and 3 Down Pairs them Up
+	__m128i acc = _mm_setzero_si128();
+	__m128i keys = _mm_setr_epi32((int)key, (int)(key + HASH_KEY_STEP), (int)(key + 2 * HASH_KEY_STEP), (int)(key + 3 * HASH_KEY_STEP));
+	const __m128i step = _mm_set1_epi32((int)(4 * HASH_KEY_STEP));
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_add_epi32(_mm_loadu_si128((const __m128i*)((const uint32_t*)words + i)), keys);
+		acc = _mm_add_epi64(acc, _mm_mul_epu32(v, _mm_srli_epi64(v, 32)));
+		keys = _mm_add_epi32(keys, step);
+	}
+	uint64_t lanes[2];
+	_mm_storeu_si128((__m128i*)lanes, acc);
+	sum = lanes[0] + lanes[1];
+#endif
+	for (; i < n; i += 2) {
+		uint32_t pair[2];
+		memcpy(pair, (const uint32_t*)words + i, sizeof(pair));
+		sum += hashPair(pair[0], pair[1], key + i * HASH_KEY_STEP, key + (i + 1) * HASH_KEY_STEP);
+	}
+	return sum;
+}
+
+//hashPair over (a[0], b[0]), (a[1], b[1]), ... Keyed by Index; n a Multiple of 4
+inline uint64_t hashArrayPairs(const int32_t* a, const int32_t* b, uint32_t n, uint32_t keyA, uint32_t keyB)
+{
+	uint64_t sum = 0;
+	uint32_t i = 0;
+#ifdef MATH_SSE2
+	__m128i acc = _mm_setzero_si128();
+	const __m128i lanes = _mm_setr_epi32(0, (int)HASH_KEY_STEP, (int)(2 * HASH_KEY_STEP), (int)(3 * HASH_KEY_STEP));
+	__m128i keysA = _mm_add_epi32(_mm_set1_epi32((int)keyA), lanes);
+	__m128i keysB = _mm_add_epi32(_mm_set1_epi32((int)keyB), lanes);
+	const __m128i step = _mm_set1_epi32((int)(4 * HASH_KEY_STEP));
+	for (; i + 4 <= n; i += 4) {
+		__m128i va = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(a + i)), keysA);
+		__m128i vb = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(b + i)), keysB);
+		acc = _mm_add_epi64(acc, _mm_mul_epu32(va, vb));
+		acc = _mm_add_epi64(acc, _mm_mul_epu32(_mm_srli_epi64(va, 32), _mm_srli_epi64(vb, 32)));
+		keysA = _mm_add_epi32(keysA, step);
+		keysB = _mm_add_epi32(keysB, step);
+	}
+	uint64_t sums[2];
+	_mm_storeu_si128((__m128i*)sums, acc);
+	sum = sums[0] + sums[1];
+#endif
+	for (; i < n; i++) {
+		sum += hashPair((uint32_t)a[i], (uint32_t)b[i], keyA + i * HASH_KEY_STEP, keyB + i * HASH_KEY_STEP);
+	}
+	return sum;
+}
+
+//Ticks per Hash Window: the State is Folded into the Rolling Hash after every HASH_WINDOW-th Tick only, which Keeps Hashing
+//under 1% of even the Cheapest Tick (bench hash); desync Finds the Tick inside a Window by Stepping both Runs through it
+const uint32_t HASH_WINDOW = 64;
+
+//Hash of the State a Tick Leaves: Paddles, Balls (the Fixed Point Ones when Authoritative), Score, Tick and Hit Points
+//Hit Points Come in through the Incrementally Kept hpHash; Balls Move every Tick so are Rehashed Whole, which is most of the Cost
+inline uint64_t hashTick(const SimState& state, bool fixedPoint)
+{
+	uint64_t sum = hashPair(state.score[0] ^ (uint32_t)state.tick, state.score[1], 0x7F4A7C15, 0xF39CC060)
+		+ hashPair((uint32_t)state.hpHash, (uint32_t)(state.hpHash >> 32), 0x1CE4E5B9, 0x94D049BB);
+
+	if (fixedPoint) {
+		//Spare Lanes up to the Next Multiple of 4 are Zero, so Hashing them Changes Nothing between Runs
+		const FixedMotion& m = state.motion;
+		uint32_t n = (state.noBalls + 3) & ~3u;
+		sum += hashPair((uint32_t)m.paddleY[0], (uint32_t)m.paddleY[1], 0x133111EB, 0xBF58476D)
+			+ hashArrayPairs(m.ballX, m.ballY, n, 0x2545F491, 0x4F6CDD1D)
+			+ hashArrayPairs(m.ballVX, m.ballVY, n, 0x5851F42D, 0x14057B7E);
+	}
+	else {
+		sum += hashPair(floatBits(state.paddles[0].y), floatBits(state.paddles[1].y), 0x133111EB, 0xBF58476D)
+			+ hashWordPairs(state.balls, 4 * state.noBalls, 0x2545F491);
+	}
+	return sum;
+}
+
+//Fold a Tick into the Rolling Hash; a Rotate keeps it to a Cycle or Two, and the Tick's Own Hash is Strong Enough
+inline uint64_t foldHash(uint64_t hash, uint64_t tickHash)
+{
+	return (hash << 1 | hash >> 63) ^ tickHash;
+}
+
+//Hash the Chain Starts from, before Tick 0; the Seed and Match Stand in for the Rest of the Random Counter
+inline uint64_t initialHash(const SimState& state)
+{
+	return hashMix(state.seed ^ hashMix(state.match));
+}
+
+/* - Helpers - */
+
+inline float halfPaddleHeight(const SimParams& params)
+{
+	return params.paddleHeight / 2.0f;
+}
+
+inline float ballRadius(const SimParams& params)
+{
+	return params.ballDiameter / 2.0f;
+}
+
+//Highest the Paddle Centre may get from either Wall
+inline float paddleOffsetBounds(const SimParams& params)
+{
+	return halfPaddleHeight(params) + ballRadius(params);
+}
+
+/* - Fixed Point - */
+
+//SimParams in Q16.16, Speeds Converted to Arena Units per Tick
+struct FixedParams {
+	fixed arenaWidth;
+	fixed arenaHeight;
+	fixed paddleStep;
+	fixed paddleX[2];
+	fixed halfPaddleWidth;
+	fixed halfPaddleHeight;
+	fixed ballRadius;
+	fixed ballSpeed;
+	fixed ballSpeedUp;
+	fixed ballMaxSpeed;
+	fixed maxBounceAngle;
+};
+
+//Converted in Double, where every Step is Exactly Rounded, so every Build Gets the Same Values
+inline FixedParams toFixedParams(const SimParams& params)
+{
+	double tick = 1.0 / params.tickRate;
+	FixedParams fp;
+	fp.arenaWidth = toFixed(params.arenaWidth);
+	fp.arenaHeight = toFixed(params.arenaHeight);
+	fp.paddleStep = toFixed(params.paddleSpeed * tick);
+	fp.paddleX[0] = toFixed(params.paddleInset);
+	fp.paddleX[1] = toFixed((double)params.arenaWidth - params.paddleInset);
+	fp.halfPaddleWidth = toFixed(params.paddleWidth / 2.0);
+	fp.halfPaddleHeight = toFixed(params.paddleHeight / 2.0);
+	fp.ballRadius = toFixed(params.ballDiameter / 2.0);
+	fp.ballSpeed = toFixed(params.ballSpeed * tick);
+	fp.ballSpeedUp = toFixed(params.ballSpeedUp);
+	fp.ballMaxSpeed = toFixed(params.ballMaxSpeed * tick);
+	fp.maxBounceAngle = toFixed(params.maxBounceAngle);
+	return fp;
+}
+
+//Refresh the Float View of a Fixed Point Ball
+inline void viewFixedBall(SimState& state, uint32_t idx, const SimParams& params)
+{
+	const FixedMotion& m = state.motion;
+	state.balls[idx].pos = { fromFixed(m.ballX[idx]), fromFixed(m.ballY[idx]) };
+	state.balls[idx].vel = { fromFixed(m.ballVX[idx]) * params.tickRate, fromFixed(m.ballVY[idx]) * params.tickRate };
+}
+
+//Fixed Point serveBall, the Angle Taken from the Top 16 Bits of the Same Random Word
+inline void serveBallFixed(SimState& state, uint32_t idx, int dir, const FixedParams& fp)
+{
+	fixed u = (fixed)(simRandom(state, state.tick, RANDOM_SERVE, idx).v[0] >> 16);
+	fixed angle = fixedMul(u - FIXED_HALF, fp.maxBounceAngle);
+	fixed sign = dir == 0 ? -1 : 1;
+
+	FixedMotion& m = state.motion;
+	m.ballX[idx] = fp.arenaWidth / 2;
+	m.ballY[idx] = fp.arenaHeight / 2;
+	m.ballVX[idx] = sign * fixedMul(fp.ballSpeed, fixedCos(angle));
+	m.ballVY[idx] = fixedMul(fp.ballSpeed, fixedSin(angle));
+}
+
+//Move n Balls a Tick and Bounce them off Walls at lo and hi, Four Lanes at a Time (see vecmath.h)
+inline void moveFixedBalls(fixed* x, fixed* y, const fixed* vx, fixed* vy, uint32_t n, fixed lo, fixed hi)
+{
+	fixedAddArray(x, vx, n);
+	fixedAddReflectArray(y, vy, n, lo, hi);
+}
+
+//Send Ball from the Centre towards Player dir (0 left, 1 right) at a Random Angle
+inline void serveBall(SimState& state, uint32_t idx, int dir, const SimParams& params)
+{
+	if (params.fixedPoint) {
+		serveBallFixed(state, idx, dir, toFixedParams(params));
+		viewFixedBall(state, idx, params);
+		return;
+	}
+
+	float angle = (philoxUniform(simRandom(state, state.tick, RANDOM_SERVE, idx).v[0]) - 0.5f) * params.maxBounceAngle;
+	float sign = dir == 0 ? -1.0f : 1.0f;
+
+	Ball& ball = state.balls[idx];
+	ball.pos = { params.arenaWidth / 2.0f, params.arenaHeight / 2.0f };
+	ball.vel = { sign * params.ballSpeed * cosf(angle), params.ballSpeed * sinf(angle) };
+}
+
+//Reset Paddles, Score and Obstacles, and Serve every Ball
+inline void initSim(SimState& state, const Level& level, uint32_t noBalls, const SimParams& params, uint64_t seed = 0, uint32_t match = 0)
+{
+	state.seed = seed;
+	state.match = match;
+	state.tick = 0;
+	state.paddles[0] = { params.paddleInset, params.arenaHeight / 2.0f };
+	state.paddles[1] = { params.arenaWidth - params.paddleInset, params.arenaHeight / 2.0f };
+	state.noBalls = noBalls < MAX_BALLS ? noBalls : MAX_BALLS;
+	state.score[0] = state.score[1] = 0;
+
+	memset(&state.motion, 0, sizeof(state.motion));
+	state.motion.paddleY[0] = state.motion.paddleY[1] = toFixed(params.arenaHeight / 2.0);
+
+	state.obstacleHp.resize(level.noObstacles);
+	for (uint32_t i = 0; i < level.noObstacles; i++) {
+		state.obstacleHp[i] = level.obstacles[i].hp;
+	}
+	resetHitPointHash(state);
+	state.hash = initialHash(state);
+
+	for (uint32_t i = 0; i < state.noBalls; i++) {
+		serveBall(state, i, i % 2, params);
+	}
+}
+
+/* - Stepping - */
+
+//Take a Hit Point off a Destructible Obstacle
+inline void damageObstacle(SimState& state, uint32_t idx, SimEvents* events)
+{
+	uint32_t& hp = state.obstacleHp[idx];
+	if (hp == OBSTACLE_STATIC) {
+		return;
+	}
+
+	state.hpHash += hashHitPoints(idx, hp - 1) - hashHitPoints(idx, hp);
+	hp--;
+	if (events) {
+		events->damaged.push_back(idx);
+		if (hp == 0) {
+			events->destroyed.push_back(idx);
+		}
+	}
+}
+
+//Move Paddle by its Buttons and Clamp to the Arena
+inline void stepPaddle(vec2& paddle, bool up, bool down, float dt, const SimParams& params)
+{
+	float bounds = paddleOffsetBounds(params);
+	if (up && paddle.y < params.arenaHeight - bounds) {
+		paddle.y += dt * params.paddleSpeed;
+	}
+	if (down && paddle.y > bounds) {
+		paddle.y -= dt * params.paddleSpeed;
+	}
+}
+
+//Bounce off a Paddle, Angle Set by where it Hit; Returns whether it Hit
+inline bool collidePaddle(Ball& ball, const vec2& paddle, int side, const SimParams& params, float* hitOffset = NULL)
+{
+	float r = ballRadius(params);
+	float halfW = params.paddleWidth / 2.0f;
+	float halfH = halfPaddleHeight(params);
+
+	if (fabsf(ball.pos.x - paddle.x) > halfW + r || fabsf(ball.pos.y - paddle.y) > halfH + r) {
+		return false;
+	}
+
+	//Only while Heading Towards the Paddle's Player
+	if ((side == 0 && ball.vel.x >= 0.0f) || (side == 1 && ball.vel.x <= 0.0f)) {
+		return false;
+	}
+
+	float hit = (ball.pos.y - paddle.y) / (halfH + r);
+	float angle = hit * params.maxBounceAngle;
+	float speed = length(ball.vel) * params.ballSpeedUp;
+	if (speed > params.ballMaxSpeed) {
+		speed = params.ballMaxSpeed;
+	}
+
+	float sign = side == 0 ? 1.0f : -1.0f;
+	ball.vel = { sign * speed * cosf(angle), speed * sinf(angle) };
+	ball.pos.x = paddle.x + sign * (halfW + r);
+	if (hitOffset) {
+		*hitOffset = hit;
+	}
+	return true;
+}
+
+//Bounce off Obstacles Overlapping the Ball, Damaging Destructible Ones
+inline void collideObstacles(SimState& state, Ball& ball, const Level& level, const SimParams& params, SimEvents* events)
+{
+	float r = ballRadius(params);
+	AABB ballBox = boxAround(ball.pos, r);
+
+	queryBVH(level, ballBox, [&](uint32_t idx) {
+		if (state.obstacleHp[idx] == 0) {
+			return;
+		}
+
+		//Closest Point on the Box to the Ball Centre
+		const AABB& box = level.obstacles[idx].box;
+		float cx = fmaxf(box.min.x, fminf(ball.pos.x, box.max.x));
+		float cy = fmaxf(box.min.y, fminf(ball.pos.y, box.max.y));
+		float dx = ball.pos.x - cx;
+		float dy = ball.pos.y - cy;
+		float distSq = dx * dx + dy * dy;
+		if (distSq > r * r) {
+			return;
+		}
+
+		//Contact Normal, Falling Back to the Shallowest Axis when the Centre is Inside
+		float nx, ny;
+		if (distSq > 0.0f) {
+			float dist = sqrtf(distSq);
+			nx = dx / dist;
+			ny = dy / dist;
+		}
+		else {
+			float penX = fminf(ball.pos.x - box.min.x, box.max.x - ball.pos.x);
+			float penY = fminf(ball.pos.y - box.min.y, box.max.y - ball.pos.y);
+			nx = penX < penY ? (ball.pos.x - box.min.x < box.max.x - ball.pos.x ? -1.0f : 1.0f) : 0.0f;
+			ny = penX < penY ? 0.0f : (ball.pos.y - box.min.y < box.max.y - ball.pos.y ? -1.0f : 1.0f);
+		}
+
+		//Reflect if Moving Into the Obstacle, then Push Out
+		float vn = ball.vel.x * nx + ball.vel.y * ny;
+		if (vn < 0.0f) {
+			ball.vel.x -= 2.0f * vn * nx;
+			ball.vel.y -= 2.0f * vn * ny;
+		}
+		ball.pos.x = cx + nx * r;
+		ball.pos.y = cy + ny * r;
+
+		damageObstacle(state, idx, events);
+	});
+}
+
+/* - Rule Sets - */
+
+//Every Mode's Features, Checked at Run Time each Tick. Other Rule Sets (see rules.h) Answer the Same Questions with
+//Constants, so a Kernel Instantiated for them Drops whatever its Mode Never Uses
+struct GenericRules {
+	static bool fixedPoint(const SimParams& params)
+	{
+		return params.fixedPoint != 0;
+	}
+
+	static uint32_t noBalls(const SimState& state)
+	{
+		return state.noBalls;
+	}
+
+	static bool obstacles(const Level&)
+	{
+		return true;
+	}
+
+	static bool events(const SimEvents* events)
+	{
+		return events != NULL;
+	}
+};
+
+/* - Fixed Point Stepping - */
+
+inline void stepPaddleFixed(fixed& paddleY, bool up, bool down, const FixedParams& fp)
+{
+	fixed bounds = fp.halfPaddleHeight + fp.ballRadius;
+	if (up && paddleY < fp.arenaHeight - bounds) {
+		paddleY += fp.paddleStep;
+	}
+	if (down && paddleY > bounds) {
+		paddleY -= fp.paddleStep;
+	}
+}
+
+//Fixed Point collidePaddle for Ball idx
+inline bool collidePaddleFixed(FixedMotion& m, uint32_t idx, uint32_t side, const FixedParams& fp, fixed* hitOffset)
+{
+	fixed r = fp.ballRadius;
+	fixed px = fp.paddleX[side];
+	fixed py = m.paddleY[side];
+	if (fixedAbs(m.ballX[idx] - px) > fp.halfPaddleWidth + r || fixedAbs(m.ballY[idx] - py) > fp.halfPaddleHeight + r) {
+		return false;
+	}
+	if ((side == 0 && m.ballVX[idx] >= 0) || (side == 1 && m.ballVX[idx] <= 0)) {
+		return false;
+	}
+
+	fixed hit = fixedDiv(m.ballY[idx] - py, fp.halfPaddleHeight + r);
+	fixed angle = fixedMul(hit, fp.maxBounceAngle);
+	fixed speed = fixedMul(fixedLength(m.ballVX[idx], m.ballVY[idx]), fp.ballSpeedUp);
+	if (speed > fp.ballMaxSpeed) {
+		speed = fp.ballMaxSpeed;
+	}
+
+	fixed sign = side == 0 ? 1 : -1;
+	m.ballVX[idx] = sign * fixedMul(speed, fixedCos(angle));
+	m.ballVY[idx] = fixedMul(speed, fixedSin(angle));
+	m.ballX[idx] = px + sign * (fp.halfPaddleWidth + r);
+	*hitOffset = hit;
+	return true;
+}
+
+//Fixed Point collideObstacles for Ball idx; the Broad Phase still Walks the Float BVH
+inline void collideObstaclesFixed(SimState& state, uint32_t idx, const Level& level, const FixedParams& fp, SimEvents* events)
+{
+	FixedMotion& m = state.motion;
+	fixed r = fp.ballRadius;
+
+	//Widened so Rounding to Float can only Add Candidates, which the Exact Test below then Drops
+	const float margin = 1.0f / 256.0f;
+	AABB ballBox = { { fromFixed(m.ballX[idx] - r) - margin, fromFixed(m.ballY[idx] - r) - margin },
+		{ fromFixed(m.ballX[idx] + r) + margin, fromFixed(m.ballY[idx] + r) + margin } };
+
+	queryBVH(level, ballBox, [&](uint32_t obstacle) {
+		if (state.obstacleHp[obstacle] == 0) {
+			return;
+		}
+
+		fixed& x = m.ballX[idx];
+		fixed& y = m.ballY[idx];
+		const AABB& box = level.obstacles[obstacle].box;
+		fixed2 boxMin = toFixed2(box.min);
+		fixed2 boxMax = toFixed2(box.max);
+		fixed minX = boxMin.x;
+		fixed minY = boxMin.y;
+		fixed maxX = boxMax.x;
+		fixed maxY = boxMax.y;
+		fixed cx = x < minX ? minX : (x > maxX ? maxX : x);
+		fixed cy = y < minY ? minY : (y > maxY ? maxY : y);
+		fixed dx = x - cx;
+		fixed dy = y - cy;
+		int64_t distSq = (int64_t)dx * dx + (int64_t)dy * dy;
+		if (distSq > (int64_t)r * r) {
+			return;
+		}
+
+		fixed nx, ny;
+		if (distSq > 0) {
+			fixed dist = (fixed)isqrt64((uint64_t)distSq);
+			nx = fixedDiv(dx, dist);
+			ny = fixedDiv(dy, dist);
+		}
+		else {
+			fixed penX = x - minX < maxX - x ? x - minX : maxX - x;
+			fixed penY = y - minY < maxY - y ? y - minY : maxY - y;
+			nx = penX < penY ? (x - minX < maxX - x ? -FIXED_ONE : FIXED_ONE) : 0;
+			ny = penX < penY ? 0 : (y - minY < maxY - y ? -FIXED_ONE : FIXED_ONE);
+		}
+
+		fixed vn = fixedMul(m.ballVX[idx], nx) + fixedMul(m.ballVY[idx], ny);
+		if (vn < 0) {
+			m.ballVX[idx] -= 2 * fixedMul(vn, nx);
+			m.ballVY[idx] -= 2 * fixedMul(vn, ny);
+		}
+		x = cx + fixedMul(nx, r);
+		y = cy + fixedMul(ny, r);
+
+		damageObstacle(state, obstacle, events);
+	});
+}
+
+//Fixed Point stepSim, in the Same Order
+template<typename Rules = GenericRules>
+inline void stepSimFixed(SimState& state, const Level& level, uint8_t input, const SimParams& params, SimEvents* events)
+{
+	FixedParams fp = toFixedParams(params);
+	FixedMotion& m = state.motion;
+	fixed r = fp.ballRadius;
+	uint32_t noBalls = Rules::noBalls(state);
+	events = Rules::events(events) ? events : NULL;
+
+	stepPaddleFixed(m.paddleY[0], (input & INPUT_P0_UP) != 0, (input & INPUT_P0_DOWN) != 0, fp);
+	stepPaddleFixed(m.paddleY[1], (input & INPUT_P1_UP) != 0, (input & INPUT_P1_DOWN) != 0, fp);
+	state.paddles[0].y = fromFixed(m.paddleY[0]);
+	state.paddles[1].y = fromFixed(m.paddleY[1]);
+
+	//Balls Never Touch each Other, so all can Move before any Collides; Spare Lanes are Zero and Stay Put
+	moveFixedBalls(m.ballX, m.ballY, m.ballVX, m.ballVY, (noBalls + 3) & ~3u, r, fp.arenaHeight - r);
+
+	for (uint32_t i = 0; i < noBalls; i++) {
+		for (uint32_t side = 0; side < 2; side++) {
+			fixed offset;
+			if (collidePaddleFixed(m, i, side, fp, &offset) && events) {
+				fixed speed = fixedLength(m.ballVX[i], m.ballVY[i]);
+				events->paddleHits.push_back({ i, side, fromFixed(offset), fromFixed(speed) * params.tickRate });
+			}
+		}
+		if (Rules::obstacles(level)) {
+			collideObstaclesFixed(state, i, level, fp, events);
+		}
+
+		int scorer = m.ballX[i] < -r ? 1 : (m.ballX[i] > fp.arenaWidth + r ? 0 : -1);
+		if (scorer >= 0) {
+			state.score[scorer]++;
+			if (events) {
+				events->scoredBy = scorer;
+				events->scores.push_back({ i, (uint32_t)scorer, fromFixed(fixedLength(m.ballVX[i], m.ballVY[i])) * params.tickRate });
+			}
+			serveBallFixed(state, i, 1 - scorer, fp);
+		}
+		viewFixedBall(state, i, params);
+	}
+
+	state.tick++;
+	if (state.tick % HASH_WINDOW == 0) {
+		state.hash = foldHash(state.hash, hashTick(state, true));
+	}
+}
+
+/* - Advancing - */
+
+//Advance One Tick under Rules, which must Agree with the State, Level and Params
+template<typename Rules>
+inline void stepSimRules(SimState& state, const Level& level, uint8_t input, const SimParams& params, SimEvents* events)
+{
+	if (Rules::fixedPoint(params)) {
+		stepSimFixed<Rules>(state, level, input, params, events);
+		return;
+	}
+
+	float dt = 1.0f / params.tickRate;
+	float r = ballRadius(params);
+	uint32_t noBalls = Rules::noBalls(state);
+	events = Rules::events(events) ? events : NULL;
+
+	stepPaddle(state.paddles[0], (input & INPUT_P0_UP) != 0, (input & INPUT_P0_DOWN) != 0, dt, params);
+	stepPaddle(state.paddles[1], (input & INPUT_P1_UP) != 0, (input & INPUT_P1_DOWN) != 0, dt, params);
+
+	for (uint32_t i = 0; i < noBalls; i++) {
+		Ball& ball = state.balls[i];
+		ball.pos = ball.pos + ball.vel * dt;
+
+		//Top and Bottom Walls
+		if (ball.pos.y < r && ball.vel.y < 0.0f) {
+			ball.pos.y = r;
+			ball.vel.y = -ball.vel.y;
+		}
+		else if (ball.pos.y > params.arenaHeight - r && ball.vel.y > 0.0f) {
+			ball.pos.y = params.arenaHeight - r;
+			ball.vel.y = -ball.vel.y;
+		}
+
+		for (uint32_t side = 0; side < 2; side++) {
+			float offset;
+			if (collidePaddle(ball, state.paddles[side], side, params, &offset) && events) {
+				events->paddleHits.push_back({ i, side, offset, length(ball.vel) });
+			}
+		}
+		if (Rules::obstacles(level)) {
+			collideObstacles(state, ball, level, params, events);
+		}
+
+		//Point Scored once the Ball Leaves the Arena, Serve towards the Player who Conceded
+		int scorer = ball.pos.x < -r ? 1 : (ball.pos.x > params.arenaWidth + r ? 0 : -1);
+		if (scorer >= 0) {
+			state.score[scorer]++;
+			if (events) {
+				events->scoredBy = scorer;
+				events->scores.push_back({ i, (uint32_t)scorer, length(ball.vel) });
+			}
+			serveBall(state, i, 1 - scorer, params);
+		}
+	}
+
+	state.tick++;
+	if (state.tick % HASH_WINDOW == 0) {
+		state.hash = foldHash(state.hash, hashTick(state, false));
+	}
+}
+
+//Advance One Tick
+inline void stepSim(SimState& state, const Level& level, uint8_t input, const SimParams& params, SimEvents* events = NULL)
+{
+	stepSimRules<GenericRules>(state, level, input, params, events);
+}
+
+#endif
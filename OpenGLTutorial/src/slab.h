@@ -0,0 +1,85 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/*
+	Fixed size object pool. Objects live in pages that are only freed with
+	the whole slab, so a handle (slot index) or pointer stays valid for the
+	object's lifetime and nothing is moved when the pool grows. Pages are
+	cache line aligned, and freed slots are handed out again newest first,
+	while they are still warm.
+*/
+
+/* - Slab - */
+
+const uint32_t SLAB_PAGE_OBJECTS = 256;
+const size_t SLAB_ALIGNMENT = 64;
+
+template<typename T>
+struct Slab {
+	std::vector<void*> allocations;	//As Returned by malloc, for Freeing
+	std::vector<T*> pages;			//Aligned Starts of the Same Allocations
+	std::vector<uint32_t> freeSlots;
+	uint32_t noLive = 0;
+};
+
+template<typename T>
+inline T& slabGet(Slab<T>& slab, uint32_t slot)
+{
+	return slab.pages[slot / SLAB_PAGE_OBJECTS][slot % SLAB_PAGE_OBJECTS];
+}
+
+//Default Construct an Object, Adding a Page when Full; Returns its Slot
+template<typename T>
+inline uint32_t slabAlloc(Slab<T>& slab)
+{
+	static_assert(SLAB_ALIGNMENT % alignof(T) == 0, "Slab pages are not aligned enough for T");
+	if (slab.freeSlots.empty()) {
+		void* allocation = malloc(SLAB_PAGE_OBJECTS * sizeof(T) + SLAB_ALIGNMENT);
+		if (!allocation) {
+			throw std::bad_alloc();
+		}
+		uintptr_t start = ((uintptr_t)allocation + SLAB_ALIGNMENT - 1) & ~(uintptr_t)(SLAB_ALIGNMENT - 1);
+		slab.allocations.push_back(allocation);
+		slab.pages.push_back((T*)start);
+
+		//Pushed Backwards so the Page's First Slot comes Out First
+		uint32_t first = (uint32_t)(slab.pages.size() - 1) * SLAB_PAGE_OBJECTS;
+		for (uint32_t i = SLAB_PAGE_OBJECTS; i > 0; i--) {
+			slab.freeSlots.push_back(first + i - 1);
+		}
+	}
+
+	uint32_t slot = slab.freeSlots.back();
+	slab.freeSlots.pop_back();
+	new (&slabGet(slab, slot)) T();
+	slab.noLive++;
+	return slot;
+}
+
+template<typename T>
+inline void slabFree(Slab<T>& slab, uint32_t slot)
+{
+	slabGet(slab, slot).~T();
+	slab.freeSlots.push_back(slot);
+	slab.noLive--;
+}
+
+//Free every Page; Objects Still Live must be Freed First
+template<typename T>
+inline void destroySlab(Slab<T>& slab)
+{
+	for (void* allocation : slab.allocations) {
+		free(allocation);
+	}
+	slab.allocations.clear();
+	slab.pages.clear();
+	slab.freeSlots.clear();
+	slab.noLive = 0;
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/*
+	Non-blocking IPv4 UDP socket for the game client, on Winsock or BSD
+	sockets. Only what the client needs: send to one address and drain
+	whatever has arrived once a frame.
+*/
+
+/* - UDP Socket - */
+
+struct UdpSocket {
+#ifdef _WIN32
+	SOCKET handle = INVALID_SOCKET;
+#else
+	int handle = -1;
+#endif
+	sockaddr_in peer = {};
+};
+
+//Open a Socket Sending to host[:port], False with a Message if the Host is not Found
+inline bool openUdp(UdpSocket& sock, const char* address, uint16_t defaultPort)
+{
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+		std::cout << "Could not start Winsock" << std::endl;
+		return false;
+	}
+#endif
+	std::string host = address;
+	uint16_t port = defaultPort;
+	size_t colon = host.rfind(':');
+	if (colon != std::string::npos) {
+		port = (uint16_t)atoi(host.c_str() + colon + 1);
+		host.resize(colon);
+	}
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* found = NULL;
+	if (getaddrinfo(host.c_str(), NULL, &hints, &found) != 0 || !found) {
+		std::cout << "Could not resolve " << host << std::endl;
+		return false;
+	}
+	memcpy(&sock.peer, found->ai_addr, sizeof(sockaddr_in));
+	sock.peer.sin_port = htons(port);
+	freeaddrinfo(found);
+
+	sock.handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	if (sock.handle == INVALID_SOCKET || ioctlsocket(sock.handle, FIONBIO, &nonBlocking) != 0) {
+#else
+	if (sock.handle < 0 || fcntl(sock.handle, F_SETFL, O_NONBLOCK) != 0) {
+#endif
+		std::cout << "Could not open a UDP socket" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+inline void sendUdp(const UdpSocket& sock, const void* data, size_t size)
+{
+	sendto(sock.handle, (const char*)data, (int)size, 0, (const sockaddr*)&sock.peer, sizeof(sock.peer));
+}
+
+//Next Datagram from the Peer, or -1 when None is Waiting
+inline int receiveUdp(const UdpSocket& sock, void* data, size_t capacity)
+{
+	while (true) {
+		sockaddr_in from = {};
+		socklen_t fromSize = sizeof(from);
+		int size = (int)recvfrom(sock.handle, (char*)data, (int)capacity, 0, (sockaddr*)&from, &fromSize);
+		if (size < 0) {
+			return -1;
+		}
+		if (from.sin_addr.s_addr == sock.peer.sin_addr.s_addr && from.sin_port == sock.peer.sin_port) {
+			return size;
+		}
+	}
+}
+
+inline void closeUdp(UdpSocket& sock)
+{
+#ifdef _WIN32
+	closesocket(sock.handle);
+	WSACleanup();
+	sock.handle = INVALID_SOCKET;
+#else
+	close(sock.handle);
+	sock.handle = -1;
+#endif
+}
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef VECMATH_H
+#define VECMATH_H
+
+#include "fixed.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATH_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MATH_NEON
+#endif
+
+/*
+	Math for the simulation and renderer: vectors, a column-major 4x4
+	matrix, boxes and Q16.16 vectors (see fixed.h), plus batch operations
+	over arrays with SSE2 or NEON bodies and scalar tails.
+
+	The types are plain aggregates, so they brace initialize, copy with
+	memcpy and are constexpr constructible, and their layouts are pinned
+	below: vec2 and vec4 are what the vertex attributes and instance
+	records read, and arrays of them can be handed to the batch operations
+	as arrays of floats. Vector lanes do the same IEEE operations in the
+	same order as the scalar tails, so either path gives the same bits.
+*/
+
+/* - 2D Vector Structure - */
+struct vec2 {
+	float x;
+	float y;
+};
+
+/* - 4D Vector Structure - */
+struct vec4 {
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+/* - Fixed Point 2D Vector Structure - */
+struct fixed2 {
+	fixed x;
+	fixed y;
+};
+
+/* - 4x4 Matrix Structure, Column Major as GL Expects - */
+struct mat4 {
+	vec4 cols[4];
+};
+
+static_assert(sizeof(vec2) == 2 * sizeof(float) && offsetof(vec2, y) == sizeof(float), "vec2 must match a vec2 vertex attribute");
+static_assert(sizeof(vec4) == 4 * sizeof(float) && offsetof(vec4, w) == 3 * sizeof(float), "vec4 must match a vec4 vertex attribute");
+static_assert(sizeof(mat4) == 16 * sizeof(float), "mat4 must upload as 16 floats");
+static_assert(std::is_trivial<vec2>::value && std::is_trivial<vec4>::value && std::is_trivial<mat4>::value, "Math types stay plain data");
+
+/* - Vector Operations - */
+
+constexpr vec2 operator+(vec2 a, vec2 b)
+{
+	return { a.x + b.x, a.y + b.y };
+}
+
+constexpr vec2 operator-(vec2 a, vec2 b)
+{
+	return { a.x - b.x, a.y - b.y };
+}
+
+constexpr vec2 operator-(vec2 a)
+{
+	return { -a.x, -a.y };
+}
+
+constexpr vec2 operator*(vec2 a, float s)
+{
+	return { a.x * s, a.y * s };
+}
+
+constexpr vec2 operator*(float s, vec2 a)
+{
+	return { a.x * s, a.y * s };
+}
+
+constexpr bool operator==(vec2 a, vec2 b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+constexpr bool operator!=(vec2 a, vec2 b)
+{
+	return !(a == b);
+}
+
+constexpr float dot(vec2 a, vec2 b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+constexpr float lengthSq(vec2 a)
+{
+	return a.x * a.x + a.y * a.y;
+}
+
+inline float length(vec2 a)
+{
+	return sqrtf(a.x * a.x + a.y * a.y);
+}
+
+//a at t 0, b at t 1, as a + (b - a) t
+constexpr vec2 lerp(vec2 a, vec2 b, float t)
+{
+	return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t };
+}
+
+constexpr vec2 minVec(vec2 a, vec2 b)
+{
+	return { a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y };
+}
+
+constexpr vec2 maxVec(vec2 a, vec2 b)
+{
+	return { a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y };
+}
+
+constexpr vec4 operator+(const vec4& a, const vec4& b)
+{
+	return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+}
+
+constexpr vec4 operator-(const vec4& a, const vec4& b)
+{
+	return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w };
+}
+
+constexpr vec4 operator*(const vec4& a, float s)
+{
+	return { a.x * s, a.y * s, a.z * s, a.w * s };
+}
+
+constexpr float dot(const vec4& a, const vec4& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+/* - Fixed Point Vectors - */
+
+//Nearest Fixed Vector, Exact as toFixed is
+inline fixed2 toFixed2(vec2 a)
+{
+	return { toFixed(a.x), toFixed(a.y) };
+}
+
+inline vec2 fromFixed2(fixed2 a)
+{
+	return { fromFixed(a.x), fromFixed(a.y) };
+}
+
+/* - Matrices - */
+
+constexpr mat4 identityMat4()
+{
+	return { { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } };
+}
+
+//Same Mapping as glOrtho; not near and far, which Windows Headers Define Away
+constexpr mat4 orthographic(float left, float right, float bottom, float top, float zNear, float zFar)
+{
+	return { {
+		{ 2.0f / (right - left), 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 2.0f / (top - bottom), 0.0f, 0.0f },
+		{ 0.0f, 0.0f, -2.0f / (zFar - zNear), 0.0f },
+		{ -(right + left) / (right - left), -(top + bottom) / (top - bottom), -(zFar + zNear) / (zFar - zNear), 1.0f }
+	} };
+}
+
+constexpr vec4 operator*(const mat4& m, const vec4& v)
+{
+	return m.cols[0] * v.x + m.cols[1] * v.y + m.cols[2] * v.z + m.cols[3] * v.w;
+}
+
+constexpr mat4 operator*(const mat4& a, const mat4& b)
+{
+	return { { a * b.cols[0], a * b.cols[1], a * b.cols[2], a * b.cols[3] } };
+}
+
+//Point at z 0, Projected; Orthographic Matrices Leave w at 1
+constexpr vec2 transformPoint(const mat4& m, vec2 p)
+{
+	return { m.cols[0].x * p.x + m.cols[1].x * p.y + m.cols[3].x, m.cols[0].y * p.x + m.cols[1].y * p.y + m.cols[3].y };
+}
+
+//16 Floats, Column by Column, for glUniformMatrix4fv without Transposing
+inline const float* matrixData(const mat4& m)
+{
+	return &m.cols[0].x;
+}
+
+/* - Axis Aligned Bounding Box - */
+struct AABB {
+	vec2 min;
+	vec2 max;
+};
+
+//Check Boxes for Overlap (touching counts)
+constexpr bool overlaps(const AABB& a, const AABB& b)
+{
+	return a.min.x <= b.max.x && a.max.x >= b.min.x
+		&& a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+//Smallest Box Holding Both
+constexpr AABB merge(const AABB& a, const AABB& b)
+{
+	return { minVec(a.min, b.min), maxVec(a.max, b.max) };
+}
+
+//Box of Half Size r around centre
+constexpr AABB boxAround(vec2 centre, float r)
+{
+	return { { centre.x - r, centre.y - r }, { centre.x + r, centre.y + r } };
+}
+
+/* - Batch Operations - */
+
+//x[i] += v[i] s for n Floats
+inline void addScaledArray(float* x, const float* v, float s, uint32_t n)
+{
+	uint32_t i = 0;
+#if defined(MATH_SSE2)
+	const __m128 sv = _mm_set1_ps(s);
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(v + i), sv)));
+	}
+#elif defined(MATH_NEON)
+	//Separate Multiply and Add, not vmlaq's Fused Form, to Match the Scalar Tail
+	const float32x4_t sv = vdupq_n_f32(s);
+	for (; i + 4 <= n; i += 4) {
+		vst1q_f32(x + i, vaddq_f32(vld1q_f32(x + i), vmulq_f32(vld1q_f32(v + i), sv)));
+	}
+#endif
+	for (; i < n; i++) {
+		x[i] += v[i] * s;
+	}
+}
+
+//out[i] = a[i] + (b[i] - a[i]) t for n Floats
+inline void lerpArray(float* out, const float* a, const float* b, float t, uint32_t n)
+{
+	uint32_t i = 0;
+#if defined(MATH_SSE2)
+	const __m128 tv = _mm_set1_ps(t);
+	for (; i + 4 <= n; i += 4) {
+		__m128 av = _mm_loadu_ps(a + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(av, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + i), av), tv)));
+	}
+#elif defined(MATH_NEON)
+	const float32x4_t tv = vdupq_n_f32(t);
+	for (; i + 4 <= n; i += 4) {
+		float32x4_t av = vld1q_f32(a + i);
+		vst1q_f32(out + i, vaddq_f32(av, vmulq_f32(vsubq_f32(vld1q_f32(b + i), av), tv)));
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = a[i] + (b[i] - a[i]) * t;
+	}
+}
+
+//Points Packed as Floats, so Arrays of vec2 go through the Float Operations
+inline void lerpPoints(vec2* out, const vec2* a, const vec2* b, float t, uint32_t n)
+{
+	lerpArray(&out->x, &a->x, &b->x, t, n * 2);
+}
+
+//x[i] += v[i] for n Fixed Values
+inline void fixedAddArray(fixed* x, const fixed* v, uint32_t n)
+{
+	uint32_t i = 0;
+#if defined(MATH_SSE2)
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128((__m128i*)(x + i), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(x + i)), _mm_loadu_si128((const __m128i*)(v + i))));
+	}
+#elif defined(MATH_NEON)
+	for (; i + 4 <= n; i += 4) {
+		vst1q_s32(x + i, vaddq_s32(vld1q_s32(x + i), vld1q_s32(v + i)));
+	}
+#endif
+	for (; i < n; i++) {
+		x[i] += v[i];
+	}
+}
+
+//Advance x[i] by v[i], then Clamp Values Past lo or hi and still Heading Out to the Bound, Reversing their v
+inline void fixedAddReflectArray(fixed* x, fixed* v, uint32_t n, fixed lo, fixed hi)
+{
+	uint32_t i = 0;
+#if defined(MATH_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i loV = _mm_set1_epi32(lo);
+	const __m128i hiV = _mm_set1_epi32(hi);
+	for (; i + 4 <= n; i += 4) {
+		__m128i vel = _mm_loadu_si128((const __m128i*)(v + i));
+		__m128i pos = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(x + i)), vel);
+		__m128i under = _mm_and_si128(_mm_cmplt_epi32(pos, loV), _mm_cmplt_epi32(vel, zero));
+		__m128i over = _mm_and_si128(_mm_cmpgt_epi32(pos, hiV), _mm_cmpgt_epi32(vel, zero));
+		__m128i bounce = _mm_or_si128(under, over);
+		pos = _mm_or_si128(_mm_andnot_si128(bounce, pos), _mm_or_si128(_mm_and_si128(under, loV), _mm_and_si128(over, hiV)));
+		vel = _mm_or_si128(_mm_andnot_si128(bounce, vel), _mm_and_si128(bounce, _mm_sub_epi32(zero, vel)));
+		_mm_storeu_si128((__m128i*)(x + i), pos);
+		_mm_storeu_si128((__m128i*)(v + i), vel);
+	}
+#elif defined(MATH_NEON)
+	const int32x4_t zero = vdupq_n_s32(0);
+	const int32x4_t loV = vdupq_n_s32(lo);
+	const int32x4_t hiV = vdupq_n_s32(hi);
+	for (; i + 4 <= n; i += 4) {
+		int32x4_t vel = vld1q_s32(v + i);
+		int32x4_t pos = vaddq_s32(vld1q_s32(x + i), vel);
+		uint32x4_t under = vandq_u32(vcltq_s32(pos, loV), vcltq_s32(vel, zero));
+		uint32x4_t over = vandq_u32(vcgtq_s32(pos, hiV), vcgtq_s32(vel, zero));
+		pos = vbslq_s32(under, loV, vbslq_s32(over, hiV, pos));
+		vel = vbslq_s32(vorrq_u32(under, over), vnegq_s32(vel), vel);
+		vst1q_s32(x + i, pos);
+		vst1q_s32(v + i, vel);
+	}
+#endif
+	for (; i < n; i++) {
+		x[i] += v[i];
+		if (x[i] < lo && v[i] < 0) {
+			x[i] = lo;
+			v[i] = -v[i];
+		}
+		else if (x[i] > hi && v[i] > 0) {
+			x[i] = hi;
+			v[i] = -v[i];
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*
+	Headless batch runner: plays bot against bot matches on every core and
+	writes one row per rally to a column store (see columns.h) for rallyq.
+	No GL needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src batch.cpp -o batch
+
+	Usage: batch <output dir> [options]
+		--matches N		matches to play, 1000 by default
+		--seconds S		length of each match, 60 by default
+		--threads N		worker threads, one per core by default
+		--obstacles N	generated level size, 0 by default
+		--balls N		balls per match, 1 by default
+		--seed N		batch seed, match i draws its random numbers from (seed, i, tick)
+		--fixed-point	step the simulation in Q16.16, the same on every build
+		--bot-noise U	largest bot aim error in arena units, 0 by default
+		--pin			pin worker threads to cores spread across NUMA nodes, on by default with more than one node
+		--no-pin		leave threads to the scheduler
+		--huge-pages	keep each worker's row buffer in transparent huge pages
+
+	Pinned workers copy the level and allocate their row buffers
+	themselves, so first touch places both on the worker's own node, and
+	throughput is reported per node.
+*/
+
+#include "batch.h"
+#include "numa.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Workers - */
+
+//Rows Buffered per Worker before Taking the Store's Lock
+const size_t BATCH_FLUSH_ROWS = 1 << 16;
+
+typedef std::vector<RallyRow, PageAllocator<RallyRow>> RallyRows;
+
+struct WorkerStats {
+	uint32_t node = 0;
+	bool pinned = false;
+	uint32_t noMatches = 0;
+	double seconds = 0.0;
+};
+
+//place is NULL for Unpinned Workers
+void batchWorker(const BatchParams& batch, const Level& level, RallyStore& store, std::atomic<uint32_t>& nextMatch, uint32_t noMatches,
+	const ThreadPlace* place, bool hugePages, WorkerStats& stats)
+{
+	if (place) {
+		stats.node = place->node;
+		stats.pinned = pinThread(place->cpu);
+	}
+
+	//Own Copies, First Touched after Pinning: the Level is Read every Tick, and would Otherwise Sit on the Main Thread's Node
+	Level local = level;
+	bindLevelStorage(local);
+	RallyRows rows = RallyRows(PageAllocator<RallyRow>(hugePages));
+	rows.reserve(BATCH_FLUSH_ROWS * 2);
+
+	MatchKernel<PageAllocator<RallyRow>> kernel = selectMatchKernel<PageAllocator<RallyRow>>(batch, local);
+	double start = now();
+	uint32_t match;
+	while ((match = nextMatch++) < noMatches) {
+		kernel(batch, local, match, rows);
+		stats.noMatches++;
+		if (rows.size() >= BATCH_FLUSH_ROWS) {
+			appendRallies(store, rows);
+		}
+	}
+	appendRallies(store, rows);
+	stats.seconds = now() - start;
+}
+
+//Matches per Second on each Node, Summed over its Threads, to Check Scaling Holds Past a Socket
+void printNodeThroughput(const NumaTopology& topology, const std::vector<WorkerStats>& stats)
+{
+	for (uint32_t n = 0; n < topology.nodes.size(); n++) {
+		uint32_t noThreads = 0;
+		uint32_t noPinned = 0;
+		uint64_t noMatches = 0;
+		double rate = 0.0;
+		for (const WorkerStats& worker : stats) {
+			if (worker.node == n) {
+				noThreads++;
+				noPinned += worker.pinned;
+				noMatches += worker.noMatches;
+				rate += worker.seconds > 0.0 ? worker.noMatches / worker.seconds : 0.0;
+			}
+		}
+		if (noThreads > 0) {
+			std::cout << "node " << topology.nodes[n].id << ": " << noThreads << " threads (" << noPinned << " pinned), " << noMatches << " matches, "
+				<< rate << " matches/s, " << rate / noThreads << " per thread" << std::endl;
+		}
+	}
+}
+
+/* - Main - */
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cout << "Usage: batch <output dir> [--matches N] [--seconds S] [--threads N] [--obstacles N] [--balls N] [--seed N] [--bot-noise U] [--fixed-point] [--pin | --no-pin] [--huge-pages]" << std::endl;
+		return -1;
+	}
+
+	BatchParams batch;
+	uint32_t noMatches = 1000;
+	uint32_t noThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t noObstacles = 0;
+	int pin = -1;
+	bool hugePages = false;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+			noMatches = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			batch.noTicks = (uint64_t)(atof(argv[++i]) * batch.sim.tickRate);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+			noObstacles = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+			batch.noBalls = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			batch.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--fixed-point") == 0) {
+			batch.sim.fixedPoint = 1;
+		}
+		else if (strcmp(argv[i], "--bot-noise") == 0 && i + 1 < argc) {
+			batch.bot.aimNoise = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--pin") == 0) {
+			pin = 1;
+		}
+		else if (strcmp(argv[i], "--no-pin") == 0) {
+			pin = 0;
+		}
+		else if (strcmp(argv[i], "--huge-pages") == 0) {
+			hugePages = true;
+		}
+	}
+
+	Level level;
+	genBrickLevel(level, noObstacles, batch.sim.arenaWidth, batch.sim.arenaHeight);
+
+	RallyStore store;
+	if (!openRallyStore(store, argv[1])) {
+		return -1;
+	}
+
+	NumaTopology topology;
+	detectTopology(topology);
+	std::vector<ThreadPlace> places;
+	placeThreads(topology, noThreads, places);
+	bool pinned = pin == 1 || (pin == -1 && topology.nodes.size() > 1);
+
+	std::atomic<uint32_t> nextMatch(0);
+	std::vector<std::thread> workers;
+	std::vector<WorkerStats> stats(noThreads);
+	double start = now();
+	for (uint32_t i = 0; i < noThreads; i++) {
+		workers.push_back(std::thread(batchWorker, std::cref(batch), std::cref(level), std::ref(store), std::ref(nextMatch), noMatches,
+			pinned ? &places[i] : NULL, hugePages, std::ref(stats[i])));
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	double elapsed = now() - start;
+
+	if (!closeRallyStore(store)) {
+		std::cout << "Could not write the rally store in " << argv[1] << std::endl;
+		return -1;
+	}
+
+	double matchTime = (double)noMatches * batch.noTicks / batch.sim.tickRate;
+	std::cout << noMatches << " matches, " << store.noRows << " rallies in " << elapsed << " s on " << noThreads << " threads, "
+		<< matchTime / elapsed << "x real time" << std::endl;
+	if (pinned) {
+		printNodeThroughput(topology, stats);
+	}
+	return 0;
+}
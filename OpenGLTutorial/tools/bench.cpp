@@ -0,0 +1,631 @@
+/*
+	Headless benchmarks for the simulation and data paths. No GL needed:
+
+		g++ -std=c++14 -O2 -I../src bench.cpp -o bench
+
+	Usage: bench <name> [args...]
+		collision [obstacles] [balls] [seconds]
+		levelload [obstacles]
+		bricks [obstacles] [balls] [seconds]
+		seek [obstacles] [balls] [minutes]
+		rng [millions of blocks]
+		fixed [obstacles] [balls] [minutes]
+		hash [obstacles] [balls]
+		schema [balls]
+		rules [obstacles] [balls] [seconds]
+*/
+
+#include "sim.h"
+#include "rules.h"
+#include "bot.h"
+#include "level_file.h"
+#include "net.h"
+#include "replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Benchmarks - */
+
+//Frame Length the Upload Benchmarks Batch Ticks into
+const uint32_t BENCH_TICKS_PER_FRAME = 16;
+
+//Ticks per Second with Balls Bouncing through a Brick Level, Idle Paddles
+int benchCollision(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 50000;
+	uint32_t noBalls = argc > 1 ? atoi(argv[1]) : 8;
+	double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+
+	SimParams params;
+	Level level;
+
+	double start = now();
+	genBrickLevel(level, noObstacles, params.arenaWidth, params.arenaHeight);
+	double buildTime = now() - start;
+
+	SimState state;
+	SimEvents events;
+	initSim(state, level, noBalls, params);
+
+	uint64_t noTicks = 0;
+	uint64_t noDestroyed = 0;
+	start = now();
+	double elapsed = 0.0;
+	while (elapsed < seconds) {
+		for (int i = 0; i < 1000; i++) {
+			events.clear();
+			stepSim(state, level, 0, params, &events);
+			noDestroyed += events.destroyed.size();
+		}
+		noTicks += 1000;
+		elapsed = now() - start;
+	}
+
+	std::cout << noObstacles << " obstacles (" << level.noNodes << " BVH nodes, built in " << buildTime * 1000.0 << " ms), "
+		<< state.noBalls << " balls" << std::endl;
+	std::cout << noTicks / elapsed << " ticks/s, " << elapsed / noTicks * 1e6 << " us/tick, "
+		<< noDestroyed << " bricks destroyed" << std::endl;
+	return 0;
+}
+
+//Time to Map a Compiled Level, against Generating and Building the Same One
+int benchLevelLoad(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 50000;
+	const char* path = "bench_level.plvl";
+	const int noLoads = 100;
+
+	SimParams params;
+	Level built;
+	double start = now();
+	genBrickLevel(built, noObstacles, params.arenaWidth, params.arenaHeight);
+	double buildTime = now() - start;
+	if (!writeLevelFile(path, built, params.arenaWidth, params.arenaHeight)) {
+		return -1;
+	}
+
+	//Load and Walk the Tree once, so Page Faults for what the First Ticks Touch are Counted
+	double loadTime = 0.0;
+	for (int i = 0; i < noLoads; i++) {
+		LevelFile file;
+		Level level;
+		start = now();
+		if (!loadLevelFile(file, level, path)) {
+			return -1;
+		}
+		uint32_t noHits = 0;
+		queryBVH(level, { { 0.0f, 0.0f }, { params.arenaWidth, params.arenaHeight } }, [&](uint32_t) { noHits++; });
+		loadTime += now() - start;
+		unloadLevelFile(file);
+		if (noHits != built.noObstacles) {
+			std::cout << "Loaded level has " << noHits << " obstacles, expected " << built.noObstacles << std::endl;
+			return -1;
+		}
+	}
+	remove(path);
+
+	std::cout << noObstacles << " obstacles, generated and built in " << buildTime * 1000.0 << " ms, "
+		<< "mapped and walked in " << loadTime / noLoads * 1000.0 << " ms" << std::endl;
+	return 0;
+}
+
+//Upload Bytes per Destroyed Brick: Swap Remove Patches against Collapsing Records in Pages of 64
+int benchBricks(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 50000;
+	uint32_t noBalls = argc > 1 ? atoi(argv[1]) : 16;
+	double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+	const uint32_t pageSize = 64;
+
+	SimParams params;
+	Level level;
+	genBrickLevel(level, noObstacles, params.arenaWidth, params.arenaHeight);
+
+	SimState state;
+	SimEvents events;
+	initSim(state, level, noBalls, params);
+
+	DenseInstances dense;
+	initDenseInstances(dense, level.noObstacles);
+	std::vector<bool> dirtyPages((level.noObstacles + pageSize - 1) / pageSize, false);
+
+	uint64_t noDestroyed = 0;
+	uint64_t noFrames = 0;
+	uint64_t noRuns = 0;
+	uint64_t denseBytes = 0;
+	uint64_t pageBytes = 0;
+	double start = now();
+	while (now() - start < seconds) {
+		for (uint32_t i = 0; i < BENCH_TICKS_PER_FRAME; i++) {
+			events.clear();
+			stepSim(state, level, 0, params, &events);
+			for (uint32_t idx : events.destroyed) {
+				DenseMove move;
+				if (removeDense(dense, idx, move)) {
+					applyDenseMove(level.records, move);
+				}
+				dirtyPages[idx / pageSize] = true;
+				noDestroyed++;
+			}
+		}
+
+		flushDensePatches(dense, [&](uint32_t, uint32_t count) {
+			denseBytes += count * sizeof(InstanceRecord);
+			noRuns++;
+		});
+		for (size_t page = 0; page < dirtyPages.size(); page++) {
+			if (dirtyPages[page]) {
+				pageBytes += pageSize * sizeof(InstanceRecord);
+				dirtyPages[page] = false;
+			}
+		}
+		noFrames++;
+	}
+
+	std::cout << noObstacles << " obstacles, " << state.noBalls << " balls, " << noFrames << " frames of "
+		<< BENCH_TICKS_PER_FRAME << " ticks, " << noDestroyed << " bricks destroyed, " << dense.noLive << " live" << std::endl;
+	if (noDestroyed > 0) {
+		std::cout << "swap remove: " << (double)denseBytes / noDestroyed << " bytes/brick in " << noRuns << " uploads" << std::endl;
+		std::cout << "collapse in pages of " << pageSize << ": " << (double)pageBytes / noDestroyed << " bytes/brick" << std::endl;
+	}
+	return 0;
+}
+
+//Same Simulation State, Field by Field
+bool sameSimState(const SimState& a, const SimState& b)
+{
+	return a.seed == b.seed && a.match == b.match && a.tick == b.tick && a.noBalls == b.noBalls
+		&& memcmp(a.paddles, b.paddles, sizeof(a.paddles)) == 0
+		&& memcmp(a.balls, b.balls, a.noBalls * sizeof(Ball)) == 0
+		&& a.score[0] == b.score[0] && a.score[1] == b.score[1]
+		&& memcmp(&a.motion, &b.motion, sizeof(a.motion)) == 0
+		&& a.hash == b.hash && a.hpHash == b.hpHash
+		&& a.obstacleHp == b.obstacleHp;
+}
+
+//Seek Time into a Recorded Match with Random Paddle Input, Checked against Straight Playback
+int benchSeek(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 2000;
+	uint32_t noBalls = argc > 1 ? atoi(argv[1]) : 4;
+	double minutes = argc > 2 ? atof(argv[2]) : 60.0;
+	const uint32_t noSeeks = 200;
+
+	Replay replay;
+	replay.noBalls = noBalls;
+	replay.noObstacles = noObstacles;
+	Level level;
+	genBrickLevel(level, noObstacles, replay.params.arenaWidth, replay.params.arenaHeight);
+
+	//Record, Keeping States at Random Ticks to Check Seeks Against
+	uint64_t noTicks = (uint64_t)(minutes * 60.0 * replay.params.tickRate);
+	std::vector<uint64_t> seekTicks(noSeeks);
+	uint32_t rng = 12345;
+	for (uint64_t& tick : seekTicks) {
+		rng = rng * 1664525u + 1013904223u;
+		tick = ((uint64_t)rng << 16 ^ rng) % noTicks;
+	}
+	std::sort(seekTicks.begin(), seekTicks.end());
+	std::vector<SimState> expected;
+
+	SimState state;
+	SimEvents events;
+	initSim(state, level, noBalls, replay.params);
+	uint8_t input = 0;
+	size_t nextCheck = 0;
+	double start = now();
+	for (uint64_t t = 0; t < noTicks; t++) {
+		while (nextCheck < seekTicks.size() && seekTicks[nextCheck] == t) {
+			expected.push_back(state);
+			nextCheck++;
+		}
+		if (t % 250 == 0) {
+			rng = rng * 1664525u + 1013904223u;
+			input = (uint8_t)(rng >> 28);
+		}
+		events.clear();
+		stepRecorded(replay, state, level, input, replay.params, events);
+	}
+	double recordTime = now() - start;
+
+	const char* path = "bench_seek.rpl";
+	if (!writeReplay(path, replay) || !readReplay(path, replay)) {
+		return -1;
+	}
+	remove(path);
+
+	//Seek in Shuffled Order so no Seek Benefits from the Last
+	std::vector<uint32_t> order(noSeeks);
+	for (uint32_t i = 0; i < noSeeks; i++) {
+		order[i] = i;
+	}
+	for (uint32_t i = noSeeks - 1; i > 0; i--) {
+		rng = rng * 1664525u + 1013904223u;
+		std::swap(order[i], order[rng % (i + 1)]);
+	}
+
+	double total = 0.0;
+	double worst = 0.0;
+	uint32_t noMismatches = 0;
+	for (uint32_t i : order) {
+		SimState seeked;
+		start = now();
+		seekReplay(replay, level, seeked, seekTicks[i]);
+		double elapsed = now() - start;
+		total += elapsed;
+		worst = std::max(worst, elapsed);
+		if (!sameSimState(seeked, expected[i])) {
+			noMismatches++;
+		}
+	}
+
+	std::cout << minutes << " min match, " << noObstacles << " obstacles, " << noBalls << " balls: recorded in " << recordTime << " s, "
+		<< replay.keyframes.size() << " keyframes, " << replay.hits.size() << " hits" << std::endl;
+	std::cout << noSeeks << " seeks: " << total / noSeeks * 1000.0 << " ms mean, " << worst * 1000.0 << " ms worst, "
+		<< noMismatches << " mismatches" << std::endl;
+	return noMismatches == 0 ? 0 : -1;
+}
+
+//Philox Blocks per Second, One at a Time against the Batch Generator
+int benchRng(int argc, char** argv)
+{
+	uint32_t noBlocks = (uint32_t)((argc > 0 ? atof(argv[0]) : 16.0) * 1e6);
+	const uint32_t chunk = 4096;
+	std::vector<uint32_t> out(chunk * 4);
+	PhiloxKey key = philoxKey(12345);
+	uint32_t check = 0;
+
+	double start = now();
+	for (uint32_t i = 0; i < noBlocks; i += chunk) {
+		for (uint32_t j = 0; j < chunk; j++) {
+			PhiloxBlock block = philox({ { i + j, 0, 7, 0 } }, key);
+			memcpy(&out[j * 4], block.v, sizeof(block.v));
+		}
+		check ^= out[chunk * 4 - 1];
+	}
+	double scalarTime = now() - start;
+
+	start = now();
+	for (uint32_t i = 0; i < noBlocks; i += chunk) {
+		philoxBatch({ { i, 0, 7, 0 } }, key, chunk, out.data());
+		check ^= out[chunk * 4 - 1];
+	}
+	double batchTime = now() - start;
+
+	//Both Passes Produce the Same Last Words, so check Cancels to 0
+	std::cout << noBlocks / 1e6 << " M blocks: scalar " << noBlocks / scalarTime / 1e6 << " M blocks/s, batch "
+		<< noBlocks / batchTime / 1e6 << " M blocks/s" << (check == 0 ? "" : " (MISMATCH)") << std::endl;
+	return check == 0 ? 0 : -1;
+}
+
+//FNV-1a over Bytes, Continuing from hash
+uint32_t fnv1a(const void* data, size_t size, uint32_t hash = 2166136261u)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+//Float against Fixed Point Stepping of the Same Match, with a Checksum of the Fixed Point Run to Compare between Builds
+int benchFixed(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 2000;
+	uint32_t noBalls = argc > 1 ? atoi(argv[1]) : 8;
+	double minutes = argc > 2 ? atof(argv[2]) : 10.0;
+
+	SimParams params;
+	Level level;
+	genBrickLevel(level, noObstacles, params.arenaWidth, params.arenaHeight);
+	uint64_t noTicks = (uint64_t)(minutes * 60.0 * params.tickRate);
+
+	double times[2];
+	SimState state;
+	for (uint32_t mode = 0; mode < 2; mode++) {
+		params.fixedPoint = mode;
+		initSim(state, level, noBalls, params, 12345);
+		uint32_t rng = 12345;
+		uint8_t input = 0;
+		double start = now();
+		for (uint64_t t = 0; t < noTicks; t++) {
+			if (t % 250 == 0) {
+				rng = rng * 1664525u + 1013904223u;
+				input = (uint8_t)(rng >> 28);
+			}
+			stepSim(state, level, input, params);
+		}
+		times[mode] = now() - start;
+	}
+
+	uint32_t hash = fnv1a(&state.motion, sizeof(state.motion));
+	hash = fnv1a(state.score, sizeof(state.score), hash);
+	hash = fnv1a(state.obstacleHp.data(), state.obstacleHp.size() * sizeof(uint32_t), hash);
+
+	//The Ball Kernel Alone, over a Million Balls
+	const uint32_t noKernelBalls = 1 << 20;
+	const uint32_t noKernelTicks = 100;
+	FixedParams fp = toFixedParams(params);
+	std::vector<fixed> x(noKernelBalls), y(noKernelBalls), vx(noKernelBalls), vy(noKernelBalls);
+	std::vector<Ball> balls(noKernelBalls);
+	for (uint32_t i = 0; i < noKernelBalls; i++) {
+		x[i] = fp.arenaWidth / 2;
+		y[i] = (fixed)(i % 600) * FIXED_ONE;
+		vx[i] = fp.ballSpeed / 2;
+		vy[i] = (fixed)(i % 7) * fp.ballSpeed / 4 - fp.ballSpeed;
+		balls[i] = { { fromFixed(x[i]), fromFixed(y[i]) }, { fromFixed(vx[i]), fromFixed(vy[i]) } };
+	}
+	fixed lo = fp.ballRadius;
+	fixed hi = fp.arenaHeight - fp.ballRadius;
+	double start = now();
+	for (uint32_t t = 0; t < noKernelTicks; t++) {
+		moveFixedBalls(x.data(), y.data(), vx.data(), vy.data(), noKernelBalls, lo, hi);
+	}
+	double fixedKernelTime = now() - start;
+
+	float loF = fromFixed(lo);
+	float hiF = fromFixed(hi);
+	start = now();
+	for (uint32_t t = 0; t < noKernelTicks; t++) {
+		for (Ball& ball : balls) {
+			ball.pos.x += ball.vel.x;
+			ball.pos.y += ball.vel.y;
+			if (ball.pos.y < loF && ball.vel.y < 0.0f) {
+				ball.pos.y = loF;
+				ball.vel.y = -ball.vel.y;
+			}
+			else if (ball.pos.y > hiF && ball.vel.y > 0.0f) {
+				ball.pos.y = hiF;
+				ball.vel.y = -ball.vel.y;
+			}
+		}
+	}
+	double floatKernelTime = now() - start;
+	uint32_t kernelHash = fnv1a(y.data(), y.size() * sizeof(fixed), fnv1a(vy.data(), vy.size() * sizeof(fixed)));
+
+	std::cout << minutes << " min match, " << noObstacles << " obstacles, " << state.noBalls << " balls, score "
+		<< state.score[0] << "-" << state.score[1] << std::endl;
+	std::cout << "float " << noTicks / times[0] << " ticks/s, fixed point " << noTicks / times[1] << " ticks/s" << std::endl;
+	std::cout << "ball kernel: float " << (double)noKernelBalls * noKernelTicks / floatKernelTime / 1e6 << " M balls/s, fixed point "
+		<< (double)noKernelBalls * noKernelTicks / fixedKernelTime / 1e6 << " M balls/s" << std::endl;
+	std::cout << "fixed point checksum " << std::hex << hash << ", kernel checksum " << kernelHash << std::dec << std::endl;
+	return 0;
+}
+
+//Share of a Tick Hashing should Stay Under
+const double HASH_BUDGET = 0.01;
+
+//Cost of the Rolling State Hash against the Ticks it Covers, One hashTick per HASH_WINDOW Ticks
+int benchHash(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 2000;
+	uint32_t noBalls = argc > 1 ? atoi(argv[1]) : 1;
+	const uint32_t noTicks = 2000000;
+
+	Level level;
+	SimState state;
+	uint64_t sink = 0;
+	for (uint32_t mode = 0; mode < 2; mode++) {
+		SimParams params;
+		params.fixedPoint = mode;
+		genBrickLevel(level, noObstacles, params.arenaWidth, params.arenaHeight);
+		initSim(state, level, noBalls, params, 12345);
+
+		double start = now();
+		for (uint32_t t = 0; t < noTicks; t++) {
+			stepSim(state, level, (uint8_t)(t >> 8 & 0xF), params);
+		}
+		double tickTime = (now() - start) / noTicks;
+
+		//The Hash Alone, Chained so the Compiler cannot Drop or Overlap Calls the Way a Tick does not Let it
+		start = now();
+		for (uint32_t t = 0; t < noTicks; t++) {
+			state.tick++;
+			sink = foldHash(sink, hashTick(state, mode != 0));
+		}
+		double hashTime = (now() - start) / noTicks;
+
+		//Spread over the Window it Ends, against the 1% of a Tick Budget
+		double share = hashTime / HASH_WINDOW / tickTime;
+		std::cout << (mode ? "fixed point: " : "float: ") << tickTime * 1e9 << " ns/tick, hash " << hashTime * 1e9 << " ns every "
+			<< HASH_WINDOW << " ticks (" << share * 100.0 << "% of a tick, " << (share <= HASH_BUDGET ? "within" : "over") << " the "
+			<< HASH_BUDGET * 100.0 << "% budget by " << std::abs(share - HASH_BUDGET) * tickTime * 1e9 << " ns)" << std::endl;
+	}
+	std::cout << noObstacles << " obstacles, " << state.noBalls << " balls (" << (sink & 1) << ")" << std::endl;
+	return 0;
+}
+
+//Snapshot Encode and Decode Speed and Size against Copying the Raw Struct, Over States from a Real Match
+int benchSchema(int argc, char** argv)
+{
+	uint32_t noBalls = argc > 0 ? atoi(argv[0]) : 1;
+	const uint32_t noStates = 4096;
+	const uint32_t noPasses = 500;
+
+	SimParams params;
+	Level level;
+	genBrickLevel(level, 0, params.arenaWidth, params.arenaHeight);
+	SimState state;
+	initSim(state, level, noBalls, params, 12345);
+	std::vector<SnapshotPacket> states(noStates);
+	for (uint32_t i = 0; i < noStates; i++) {
+		for (uint32_t t = 0; t < 16; t++) {
+			stepSim(state, level, (uint8_t)(state.tick >> 9 & 0xF), params);
+		}
+		packSnapshot(states[i], MatchHandle{ i, 1 }, state);
+	}
+
+	//Encoded Back to Back, as into an Outbox
+	std::vector<uint8_t> wire(noStates * SNAPSHOT_WIRE_BUFFER);
+	std::vector<size_t> sizes(noStates);
+	size_t noBytes = 0;
+	double start = now();
+	for (uint32_t pass = 0; pass < noPasses; pass++) {
+		noBytes = 0;
+		for (uint32_t i = 0; i < noStates; i++) {
+			sizes[i] = encodeSnapshot(states[i], &wire[i * SNAPSHOT_WIRE_BUFFER]);
+			noBytes += sizes[i];
+		}
+	}
+	double encodeTime = now() - start;
+
+	std::vector<SnapshotPacket> decoded(noStates);
+	uint32_t noBad = 0;
+	start = now();
+	for (uint32_t pass = 0; pass < noPasses; pass++) {
+		for (uint32_t i = 0; i < noStates; i++) {
+			noBad += readSnapshot(&wire[i * SNAPSHOT_WIRE_BUFFER], sizes[i], decoded[i]) ? 0 : 1;
+		}
+	}
+	double decodeTime = now() - start;
+
+	//Raw Structs Cut after the Balls in Play, as Protocol Version 1 Sent them
+	size_t rawSize = offsetof(SnapshotPacket, balls) + state.noBalls * sizeof(Ball);
+	std::vector<uint8_t> raw(noStates * sizeof(SnapshotPacket));
+	start = now();
+	for (uint32_t pass = 0; pass < noPasses; pass++) {
+		for (uint32_t i = 0; i < noStates; i++) {
+			memcpy(&raw[i * sizeof(SnapshotPacket)], &states[i], rawSize);
+		}
+	}
+	double copyTime = now() - start;
+
+	//Quantization Error, and Integers must Survive Exactly
+	float posError = 0.0f;
+	float velError = 0.0f;
+	for (uint32_t i = 0; i < noStates; i++) {
+		const SnapshotPacket& a = states[i];
+		const SnapshotPacket& b = decoded[i];
+		noBad += a.tick != b.tick || a.hash != b.hash || a.match.slot != b.match.slot || a.noBalls != b.noBalls || a.score[1] != b.score[1] ? 1 : 0;
+		for (uint32_t j = 0; j < a.noBalls; j++) {
+			posError = std::max(posError, std::max(fabsf(a.balls[j].pos.x - b.balls[j].pos.x), fabsf(a.balls[j].pos.y - b.balls[j].pos.y)));
+			velError = std::max(velError, std::max(fabsf(a.balls[j].vel.x - b.balls[j].vel.x), fabsf(a.balls[j].vel.y - b.balls[j].vel.y)));
+		}
+	}
+
+	double noEncoded = (double)noStates * noPasses;
+	std::cout << state.noBalls << " balls: " << (double)noBytes / noStates << " bytes/state packed (" << SnapshotSchema::bits << " bits most), "
+		<< rawSize << " raw" << std::endl;
+	std::cout << "encode " << noEncoded / encodeTime / 1e6 << " M states/s, decode " << noEncoded / decodeTime / 1e6 << " M states/s, raw copy "
+		<< noEncoded / copyTime / 1e6 << " M states/s (" << (uint32_t)raw[noStates] << ")" << std::endl;
+	std::cout << "largest error: position " << posError << ", velocity " << velError << ", " << noBad << " states with wrong integers" << std::endl;
+	return noBad == 0 ? 0 : 1;
+}
+
+//Generic stepSim against each Mode's Rule Set Kernel, Stepping Bot Matches with Events as the Batch Tools do;
+//Best of Three Alternating Runs, and the Final State Hashes must Agree
+int benchRules(int argc, char** argv)
+{
+	uint32_t noObstacles = argc > 0 ? atoi(argv[0]) : 500;
+	uint32_t noBalls = argc > 1 ? atoi(argv[1]) : 4;
+	double seconds = argc > 2 ? atof(argv[2]) : 60.0;
+
+	struct Mode {
+		const char* name;
+		uint32_t noBalls;
+		uint32_t noObstacles;
+		uint32_t fixedPoint;
+	};
+	const Mode modes[] = {
+		{ "classic", 1, 0, 0 },
+		{ "multi-ball", noBalls, 0, 0 },
+		{ "obstacles", 1, noObstacles, 0 },
+		{ "classic fixed", 1, 0, 1 },
+		{ "multi-ball fixed", noBalls, 0, 1 },
+		{ "obstacles fixed", 1, noObstacles, 1 }
+	};
+
+	uint32_t noBad = 0;
+	for (const Mode& mode : modes) {
+		SimParams params;
+		params.fixedPoint = mode.fixedPoint;
+		BotParams bot;
+		Level level;
+		genBrickLevel(level, mode.noObstacles, params.arenaWidth, params.arenaHeight);
+		uint64_t noTicks = (uint64_t)(seconds * params.tickRate);
+
+		StepKernel kernels[2] = { stepSim, selectStepKernel(params, level, mode.noBalls, true) };
+		double best[2] = { 1e30, 1e30 };
+		uint64_t hashes[2] = {};
+		for (uint32_t run = 0; run < 6; run++) {
+			uint32_t k = run % 2;
+			SimState state;
+			SimEvents events;
+			initSim(state, level, mode.noBalls, params, 12345);
+			double start = now();
+			for (uint64_t t = 0; t < noTicks; t++) {
+				events.clear();
+				kernels[k](state, level, botMatchInput(state, params, bot, bot), params, &events);
+			}
+			best[k] = std::min(best[k], now() - start);
+			hashes[k] = state.hash;
+		}
+
+		bool same = hashes[0] == hashes[1];
+		noBad += !same;
+		std::cout << mode.name << " (" << mode.noBalls << " balls, " << mode.noObstacles << " obstacles): generic " << noTicks / best[0] / 1e6
+			<< " M ticks/s, specialized " << noTicks / best[1] / 1e6 << " M ticks/s, " << best[0] / best[1] << "x, "
+			<< (same ? "same hash" : "HASH DIFFERS") << std::endl;
+	}
+	return noBad == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cout << "Usage: bench collision [obstacles] [balls] [seconds]" << std::endl;
+		std::cout << "       bench levelload [obstacles]" << std::endl;
+		std::cout << "       bench bricks [obstacles] [balls] [seconds]" << std::endl;
+		std::cout << "       bench seek [obstacles] [balls] [minutes]" << std::endl;
+		std::cout << "       bench rng [millions of blocks]" << std::endl;
+		std::cout << "       bench fixed [obstacles] [balls] [minutes]" << std::endl;
+		std::cout << "       bench hash [obstacles] [balls]" << std::endl;
+		std::cout << "       bench schema [balls]" << std::endl;
+		std::cout << "       bench rules [obstacles] [balls] [seconds]" << std::endl;
+		return -1;
+	}
+
+	if (strcmp(argv[1], "collision") == 0) {
+		return benchCollision(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "levelload") == 0) {
+		return benchLevelLoad(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "bricks") == 0) {
+		return benchBricks(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "seek") == 0) {
+		return benchSeek(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "rng") == 0) {
+		return benchRng(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "fixed") == 0) {
+		return benchFixed(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "hash") == 0) {
+		return benchHash(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "schema") == 0) {
+		return benchSchema(argc - 2, argv + 2);
+	}
+	if (strcmp(argv[1], "rules") == 0) {
+		return benchRules(argc - 2, argv + 2);
+	}
+
+	std::cout << "Unknown benchmark " << argv[1] << std::endl;
+	return -1;
+}
@@ -0,0 +1,264 @@
+/*
+	Desync finder for replays, using the rolling state hash logged at the
+	end of every hash window of HASH_WINDOW ticks (see hashTick in sim.h).
+	No GL needed:
+
+		g++ -std=c++14 -O2 -I../src desync.cpp -o desync
+
+	Usage: desync <replay>
+			play the replay on this build and stop at the first window
+			whose hash differs from the one logged when it was recorded
+		desync <replay a> <replay b>
+			bisect two peers' recordings of one match to the first window
+			their logged hashes differ, then step both through it for the
+			first tick their states differ
+
+	Both states are dumped, with differing fields marked. States come from
+	stepping on this build, from tick 0 or from each recording's own
+	nearest keyframe. A recording only keeps its own state at keyframes,
+	so played against this build alone a desync is placed to its window;
+	ticks after the last whole window are not checked.
+*/
+
+#include "replay.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/* - Dumping - */
+
+template<typename T>
+void dumpField(const char* name, const T& a, const T& b)
+{
+	std::ostringstream left;
+	left << a;
+	std::ostringstream right;
+	right << b;
+	std::cout << (left.str() == right.str() ? "  " : "* ") << std::left << std::setw(16) << name
+		<< std::setw(28) << left.str() << right.str() << std::endl;
+}
+
+std::string hex(uint64_t value)
+{
+	std::ostringstream out;
+	out << std::hex << std::setw(16) << std::setfill('0') << value;
+	return out.str();
+}
+
+std::string vec(const vec2& v)
+{
+	std::ostringstream out;
+	out << std::setprecision(9) << v.x << ", " << v.y;
+	return out.str();
+}
+
+std::string fixedPair(fixed x, fixed y)
+{
+	std::ostringstream out;
+	out << x << ", " << y;
+	return out.str();
+}
+
+//Side by Side, Fixed Point Motion Included when it is Authoritative
+void dumpStates(const char* nameA, const SimState& a, const char* nameB, const SimState& b, bool fixedPoint)
+{
+	std::cout << "  " << std::left << std::setw(16) << "" << std::setw(28) << nameA << nameB << std::endl;
+	dumpField("tick", a.tick, b.tick);
+	dumpField("hash", hex(a.hash), hex(b.hash));
+	dumpField("hp hash", hex(a.hpHash), hex(b.hpHash));
+	dumpField("score", std::to_string(a.score[0]) + "-" + std::to_string(a.score[1]), std::to_string(b.score[0]) + "-" + std::to_string(b.score[1]));
+	for (uint32_t side = 0; side < 2; side++) {
+		std::string name = "paddle " + std::to_string(side);
+		dumpField(name.c_str(), vec(a.paddles[side]), vec(b.paddles[side]));
+		if (fixedPoint) {
+			name += " q16";
+			dumpField(name.c_str(), a.motion.paddleY[side], b.motion.paddleY[side]);
+		}
+	}
+	uint32_t noBalls = std::max(a.noBalls, b.noBalls);
+	for (uint32_t i = 0; i < noBalls && i < MAX_BALLS; i++) {
+		std::string name = "ball " + std::to_string(i);
+		dumpField((name + " pos").c_str(), vec(a.balls[i].pos), vec(b.balls[i].pos));
+		dumpField((name + " vel").c_str(), vec(a.balls[i].vel), vec(b.balls[i].vel));
+		if (fixedPoint) {
+			const FixedMotion& ma = a.motion;
+			const FixedMotion& mb = b.motion;
+			dumpField((name + " pos q16").c_str(), fixedPair(ma.ballX[i], ma.ballY[i]), fixedPair(mb.ballX[i], mb.ballY[i]));
+			dumpField((name + " vel q16").c_str(), fixedPair(ma.ballVX[i], ma.ballVY[i]), fixedPair(mb.ballVX[i], mb.ballVY[i]));
+		}
+	}
+
+	uint32_t noDiffering = 0;
+	std::ostringstream first;
+	for (size_t i = 0; i < a.obstacleHp.size() && i < b.obstacleHp.size(); i++) {
+		if (a.obstacleHp[i] != b.obstacleHp[i] && noDiffering++ < 8) {
+			first << " " << i << " (" << a.obstacleHp[i] << " vs " << b.obstacleHp[i] << ")";
+		}
+	}
+	std::cout << (noDiffering ? "* " : "  ") << noDiffering << " obstacles with different hit points" << first.str() << std::endl;
+}
+
+/* - Checking - */
+
+bool sameMatch(const Replay& a, const Replay& b)
+{
+	return memcmp(&a.params, &b.params, sizeof(SimParams)) == 0 && a.noBalls == b.noBalls && a.noObstacles == b.noObstacles
+		&& a.seed == b.seed && a.match == b.match && a.levelPath == b.levelPath;
+}
+
+//Step the Replay on this Build from Tick 0 against its Logged Hashes
+int checkReplay(const char* path, const Replay& replay, const Level& level)
+{
+	SimState state;
+	initSim(state, level, replay.noBalls, replay.params, replay.seed, replay.match);
+	SimState windowStart = state;
+	for (uint64_t t = 0; t < replay.hashes.size() * HASH_WINDOW; t++) {
+		stepSim(state, level, replay.inputs[t], replay.params);
+		if (state.tick % HASH_WINDOW != 0) {
+			continue;
+		}
+		uint64_t w = state.tick / HASH_WINDOW - 1;
+		if ((uint32_t)state.hash == replay.hashes[w]) {
+			windowStart = state;
+			continue;
+		}
+
+		std::cout << path << " desyncs in ticks " << windowStart.tick << " to " << state.tick - 1 << ": this build hashes "
+			<< std::hex << (uint32_t)state.hash << ", the recording logged " << replay.hashes[w] << std::dec << std::endl;
+
+		//The Recording's Own State is only Kept at Keyframes, so Show the Last One against this Build at the Same Tick
+		uint64_t k = (state.tick - 1) / replay.keyframeInterval;
+		if (k < replay.keyframes.size()) {
+			SimState recorded;
+			if (!seekReplay(replay, level, recorded, replay.keyframes[k].tick)) {
+				return 1;
+			}
+			SimState local;
+			initSim(local, level, replay.noBalls, replay.params, replay.seed, replay.match);
+			while (local.tick < recorded.tick) {
+				stepSim(local, level, replay.inputs[local.tick], replay.params);
+			}
+			std::cout << std::endl << "Last keyframe before the window's end:" << std::endl;
+			dumpStates("recorded", recorded, "this build", local, replay.params.fixedPoint != 0);
+		}
+		std::cout << std::endl << "This build across the window:" << std::endl;
+		dumpStates("start", windowStart, "end", state, replay.params.fixedPoint != 0);
+		return 1;
+	}
+
+	std::cout << path << ": all " << replay.hashes.size() << " windows (" << replay.hashes.size() * HASH_WINDOW << " of "
+		<< replay.inputs.size() << " ticks) match on this build" << std::endl;
+	return 0;
+}
+
+//Print the First Tick before noTicks the two Recordings' Inputs Differ, if any
+void printInputDiff(const Replay& a, const Replay& b, uint64_t noTicks)
+{
+	for (uint64_t i = 0; i < noTicks; i++) {
+		if (a.inputs[i] != b.inputs[i]) {
+			std::cout << "Inputs first differ on tick " << i << ": " << (int)a.inputs[i] << " against " << (int)b.inputs[i] << std::endl;
+			return;
+		}
+	}
+}
+
+//Binary Search for the First Window the Recordings' Hashes Differ, the Hash is Rolling so they Differ in every Window after it too;
+//then Step Both through it Comparing each Tick's State Hash
+int bisectReplays(const char* pathA, const Replay& a, const char* pathB, const Replay& b, const Level& level)
+{
+	uint64_t noWindows = std::min(a.hashes.size(), b.hashes.size());
+	uint64_t lo = 0;
+	uint64_t hi = noWindows;
+	uint32_t noProbes = 0;
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		noProbes++;
+		if (a.hashes[mid] == b.hashes[mid]) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	if (lo == noWindows) {
+		std::cout << "The recordings agree on all " << noWindows << " windows (" << noWindows * HASH_WINDOW << " ticks) they share" << std::endl;
+		//Only Window Ends are Hashed, so Input that Diverged the States for a While and Settled back before one Shows here Alone
+		printInputDiff(a, b, noWindows * HASH_WINDOW);
+		return 0;
+	}
+	uint64_t w = lo;
+	uint64_t start = w * HASH_WINDOW;
+	uint64_t end = start + HASH_WINDOW;
+	std::cout << "First differing window, ticks " << start << " to " << end - 1 << " (" << noProbes << " probes): " << pathA << " logged "
+		<< std::hex << a.hashes[w] << ", " << pathB << " logged " << b.hashes[w] << std::dec << std::endl;
+
+	//Different Input is the Usual Cause, Checked before Blaming the Simulation
+	printInputDiff(a, b, end);
+
+	SimState stateA;
+	SimState stateB;
+	if (!seekReplay(a, level, stateA, start) || !seekReplay(b, level, stateB, start)) {
+		std::cout << "Could not seek to tick " << start << std::endl;
+		return -1;
+	}
+	bool fixedPoint = a.params.fixedPoint != 0;
+	while (stateA.tick < end && hashTick(stateA, fixedPoint) == hashTick(stateB, fixedPoint)) {
+		stepSim(stateA, level, a.inputs[stateA.tick], a.params);
+		stepSim(stateB, level, b.inputs[stateB.tick], b.params);
+	}
+	if (hashTick(stateA, fixedPoint) != hashTick(stateB, fixedPoint)) {
+		std::cout << "Stepped on this build, the states first differ after tick " << stateA.tick - 1 << std::endl;
+	}
+	else {
+		std::cout << "Stepped on this build, both recordings play the same through the window" << std::endl;
+	}
+	for (int side = 0; side < 2; side++) {
+		const SimState& state = side == 0 ? stateA : stateB;
+		const Replay& replay = side == 0 ? a : b;
+		if (state.tick == end && (uint32_t)state.hash != replay.hashes[w]) {
+			std::cout << (side == 0 ? pathA : pathB) << " does not replay the same on this build, its state below is this build's" << std::endl;
+		}
+	}
+	std::cout << std::endl;
+	dumpStates(pathA, stateA, pathB, stateB, fixedPoint);
+	return 1;
+}
+
+/* - Main - */
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cout << "Usage: desync <replay> [other peer's replay]" << std::endl;
+		return -1;
+	}
+
+	Replay a;
+	Level level;
+	LevelFile levelFile;
+	if (!readReplay(argv[1], a) || !loadReplayLevel(a, level, levelFile)) {
+		return -1;
+	}
+	if (argc < 3) {
+		return checkReplay(argv[1], a, level);
+	}
+
+	//The Peer's File is Untrusted too: readReplay Checks it Against Itself, replayFitsLevel Against the Level it will be Seeked on
+	Replay b;
+	if (!readReplay(argv[2], b)) {
+		return -1;
+	}
+	if (!sameMatch(a, b)) {
+		std::cout << argv[1] << " and " << argv[2] << " are not recordings of the same match" << std::endl;
+		return -1;
+	}
+	if (!replayFitsLevel(b, level)) {
+		return -1;
+	}
+	return bisectReplays(argv[1], a, argv[2], b, level);
+}
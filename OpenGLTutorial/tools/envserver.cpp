@@ -0,0 +1,223 @@
+/*
+	Pong environments for an external trainer, shared through POSIX shared
+	memory (see env_shm.h for the layout and handshake, trainer.c for a
+	client). The trainer writes actions straight into the region and the
+	server writes observations, rewards and dones straight back, so a step
+	costs two cache line handoffs and no copies or system calls while both
+	sides are spinning. Linux only, no GL needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src envserver.cpp -o envserver
+
+	Usage: envserver [options]
+		--name N			shared memory name, /pong-env by default
+		--envs N			environments, 1024 by default
+		--threads N			stepping threads, one per core by default
+		--balls N			balls per environment, 1 by default
+		--ticks-per-step N	simulation ticks each action is held for, 16 by default, 0 to time the handshake alone
+		--points N			points to win an episode, 5 by default
+		--max-steps N		steps before an episode is cut short, 10000 by default
+		--spin N			polls before sleeping on the futex, 100000 by default, 0 on a single core
+		--seed N			environment i's episodes are matches i, i + envs, ... of this seed
+		--fixed-point		step in Q16.16
+
+	Runs until the trainer sets stop, or until interrupted.
+*/
+
+#include "env.h"
+#include "env_shm.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* - Shared Region - */
+
+//Create the Region, Replacing a Stale One of the Same Name; NULL with a Message on Failure
+EnvShmHeader* createRegion(const char* name, uint32_t noEnvs, uint32_t noBalls, uint32_t ticksPerStep)
+{
+	EnvShmHeader layout;
+	envShmLayout(&layout, noEnvs, noBalls, ticksPerStep);
+
+	shm_unlink(name);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0 || ftruncate(fd, layout.totalSize) != 0) {
+		std::cout << "Could not create shared memory " << name << ": " << strerror(errno) << std::endl;
+		return NULL;
+	}
+	void* region = mmap(NULL, layout.totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (region == MAP_FAILED) {
+		std::cout << "Could not map shared memory " << name << ": " << strerror(errno) << std::endl;
+		return NULL;
+	}
+
+	//Fresh Pages are Zero, so the Handshake Words Start at Step 0; the Magic Goes in Last for Trainers Polling for it
+	EnvShmHeader* header = (EnvShmHeader*)region;
+	memcpy(header, &layout, sizeof(EnvShmHeader));
+	header->magic = 0;
+	return header;
+}
+
+/* - Stepping - */
+
+struct EnvServer {
+	EnvParams params;
+	Level level;
+	std::vector<Env> envs;
+	EnvShmHeader* header = NULL;
+	uint32_t noThreads = 1;
+	uint32_t spins = 100000;
+	std::atomic<uint32_t> noFinished;	//Threads Done with the Current Step
+};
+
+void stepSlice(EnvServer& server, uint32_t first, uint32_t last)
+{
+	EnvShmHeader* header = server.header;
+	const uint8_t* actions = envActions(header);
+	float* obs = envObservations(header);
+	float* rewards = envRewards(header);
+	uint8_t* dones = envDones(header);
+	for (uint32_t i = first; i < last; i++) {
+		dones[i] = stepEnv(server.envs[i], server.level, actions[i], server.params, rewards[i]);
+		observeEnv(server.envs[i], server.params, obs + (size_t)i * header->obsFloats);
+	}
+}
+
+//Every Thread Waits on the Request Word Itself and Steps its Own Slice; the Last to Finish Posts the Step
+void stepThread(EnvServer& server, uint32_t thread)
+{
+	EnvShmHeader* header = server.header;
+	uint32_t noEnvs = header->noEnvs;
+	uint32_t first = (uint32_t)((uint64_t)noEnvs * thread / server.noThreads);
+	uint32_t last = (uint32_t)((uint64_t)noEnvs * (thread + 1) / server.noThreads);
+	uint32_t step = 0;
+	while (true) {
+		step = envShmWait(&header->request, step, server.spins);
+		if (__atomic_load_n(&header->stop, __ATOMIC_ACQUIRE)) {
+			return;
+		}
+		if (header->ticksPerStep > 0) {
+			stepSlice(server, first, last);
+		}
+		if (server.noFinished.fetch_add(1) + 1 == server.noThreads) {
+			server.noFinished = 0;
+			envShmPost(&header->done, step);
+		}
+	}
+}
+
+/* - Main - */
+
+EnvShmHeader* stopHeader = NULL;
+
+//Interrupts Stop the Threads as a Trainer would
+void onInterrupt(int)
+{
+	if (stopHeader) {
+		__atomic_store_n(&stopHeader->stop, 1, __ATOMIC_RELEASE);
+		envShmPost(&stopHeader->request, stopHeader->request.value + 1);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	EnvServer server;
+	server.noFinished = 0;
+	EnvParams& params = server.params;
+	params.noEnvs = 1024;
+	const char* name = ENV_SHM_DEFAULT_NAME;
+	server.noThreads = std::max(1u, std::thread::hardware_concurrency());
+	bool spinGiven = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+			name = argv[++i];
+		}
+		else if (strcmp(argv[i], "--envs") == 0 && i + 1 < argc) {
+			params.noEnvs = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			server.noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+			params.noBalls = std::max(1, std::min((int)MAX_BALLS, atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "--ticks-per-step") == 0 && i + 1 < argc) {
+			params.ticksPerStep = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) {
+			params.pointsToWin = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc) {
+			params.maxSteps = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--spin") == 0 && i + 1 < argc) {
+			server.spins = atoi(argv[++i]);
+			spinGiven = true;
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			params.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--fixed-point") == 0) {
+			params.sim.fixedPoint = 1;
+		}
+	}
+	server.noThreads = std::min(server.noThreads, params.noEnvs);
+
+	//Spinning on One Core only Delays the Other Side until the Spin Runs Out
+	if (std::thread::hardware_concurrency() <= 1 && !spinGiven) {
+		server.spins = 0;
+	}
+
+	genBrickLevel(server.level, 0, params.sim.arenaWidth, params.sim.arenaHeight);
+	EnvShmHeader* header = createRegion(name, params.noEnvs, params.noBalls, params.ticksPerStep);
+	if (!header) {
+		return -1;
+	}
+	server.header = header;
+
+	//First Observations, so the Trainer can Act before its First Step
+	server.envs.resize(params.noEnvs);
+	for (uint32_t i = 0; i < params.noEnvs; i++) {
+		server.envs[i].index = i;
+		resetEnv(server.envs[i], server.level, params);
+		observeEnv(server.envs[i], params, envObservations(header) + (size_t)i * header->obsFloats);
+	}
+	__atomic_store_n(&header->magic, ENV_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	stopHeader = header;
+	struct sigaction action = {};
+	action.sa_handler = onInterrupt;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	std::cout << "Serving " << params.noEnvs << " environments in " << name << " (" << header->totalSize << " bytes) on "
+		<< server.noThreads << " threads, " << params.ticksPerStep << " ticks per step" << std::endl;
+
+	std::vector<std::thread> threads;
+	for (uint32_t t = 1; t < server.noThreads; t++) {
+		threads.push_back(std::thread(stepThread, std::ref(server), t));
+	}
+	stepThread(server, 0);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	uint64_t noEpisodes = 0;
+	for (const Env& env : server.envs) {
+		noEpisodes += env.episode;
+	}
+	std::cout << "Stopped after " << header->done.value << " steps, " << noEpisodes << " episodes finished" << std::endl;
+	stopHeader = NULL;
+	munmap(header, (size_t)header->totalSize);
+	shm_unlink(name);
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+	Level compiler: turns a text level description into the binary format
+	the game maps with --level. No GL needed:
+
+		g++ -std=c++14 -O2 -I../src levelc.cpp -o levelc
+
+	Usage: levelc <input.txt> <output.plvl>
+
+	One directive per line, # starts a comment:
+		arena W H				arena size, 800 600 by default
+		brick X Y W H [HP]		destructible box, lower left corner at X Y, 1 hit point by default
+		bumper X Y W H			box that cannot be destroyed
+		bricks N				generated grid of N bricks and bumpers, as --obstacles N
+*/
+
+#include "level_file.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/* - Parsing - */
+
+//Append a Box Obstacle, Rejecting Empty or Inverted Boxes
+bool addObstacle(Level& level, float x, float y, float w, float h, uint32_t hp)
+{
+	if (!(w > 0.0f) || !(h > 0.0f)) {
+		return false;
+	}
+
+	Obstacle obstacle;
+	obstacle.box = { { x, y }, { x + w, y + h } };
+	obstacle.hp = hp;
+	level.obstacleStore.push_back(obstacle);
+	return true;
+}
+
+//Read Directives from path into level.obstacleStore and the Arena Size
+bool parseLevel(const char* path, Level& level, float& arenaWidth, float& arenaHeight)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int lineNo = 0;
+	while (std::getline(file, line)) {
+		lineNo++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+
+		std::istringstream in(line);
+		std::string directive;
+		if (!(in >> directive)) {
+			continue;
+		}
+
+		bool ok = false;
+		if (directive == "arena") {
+			ok = (in >> arenaWidth >> arenaHeight) && arenaWidth > 0.0f && arenaHeight > 0.0f;
+		}
+		else if (directive == "brick") {
+			float x, y, w, h;
+			uint32_t hp = 1;
+			if (in >> x >> y >> w >> h) {
+				if (!(in >> hp)) {
+					hp = 1;
+				}
+				ok = hp > 0 && hp != OBSTACLE_STATIC && addObstacle(level, x, y, w, h, hp);
+			}
+		}
+		else if (directive == "bumper") {
+			float x, y, w, h;
+			ok = (in >> x >> y >> w >> h) && addObstacle(level, x, y, w, h, OBSTACLE_STATIC);
+		}
+		else if (directive == "bricks") {
+			uint32_t n;
+			if (in >> n) {
+				//Generated with the Arena Size Known so far, then Kept Alongside any Hand Placed Boxes
+				Level grid;
+				genBrickLevel(grid, n, arenaWidth, arenaHeight);
+				level.obstacleStore.insert(level.obstacleStore.end(), grid.obstacleStore.begin(), grid.obstacleStore.end());
+				ok = true;
+			}
+		}
+		else {
+			std::cout << path << ":" << lineNo << ": unknown directive " << directive << std::endl;
+			return false;
+		}
+
+		if (!ok) {
+			std::cout << path << ":" << lineNo << ": bad " << directive << " line" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		std::cout << "Usage: levelc <input.txt> <output.plvl>" << std::endl;
+		return -1;
+	}
+
+	Level level;
+	float arenaWidth = 800.0f;
+	float arenaHeight = 600.0f;
+	if (!parseLevel(argv[1], level, arenaWidth, arenaHeight)) {
+		return -1;
+	}
+
+	buildLevel(level);
+	if (!writeLevelFile(argv[2], level, arenaWidth, arenaHeight)) {
+		std::cout << "Could not write " << argv[2] << std::endl;
+		return -1;
+	}
+
+	std::cout << argv[2] << ": " << level.noObstacles << " obstacles, " << level.noNodes << " BVH nodes, "
+		<< arenaWidth << "x" << arenaHeight << " arena" << std::endl;
+	return 0;
+}
@@ -0,0 +1,337 @@
+/*
+	Load test for the dedicated server (see server.cpp): plays many bot
+	matches against it over UDP and reports how steadily snapshots arrive,
+	then asks the server how many matches per core it is managing and how
+	late its rounds start. Linux only, no GL needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src loadtest.cpp -o loadtest
+
+	Usage: loadtest [options]
+		--server A		server IPv4 address, 127.0.0.1 by default
+		--port N		server UDP port, 27015 by default
+		--matches N		matches to play, two bot players each, 100 by default
+		--seconds S		how long to play once every player has joined, 10 by default
+		--threads N		client threads, one socket each, 1 by default
+		--input-hz N	inputs per second from each player, 60 by default
+*/
+
+#include "bot.h"
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Players - */
+
+struct LoadOptions {
+	sockaddr_in server = {};
+	uint32_t noMatches = 100;
+	double seconds = 10.0;
+	uint32_t noThreads = 1;
+	uint32_t inputHz = 60;
+};
+
+struct Player {
+	uint32_t clientId = 0;
+	bool joined = false;
+	uint32_t side = 0;
+	MatchHandle match = {};
+	uint32_t nonce = 0;
+	SimParams params;
+	SimState view;				//What the Snapshots Carry, for the Bot
+	double lastJoin = -1.0;
+	double lastSnapshot = -1.0;
+	uint64_t noSnapshots = 0;
+	uint64_t tickStep = 0;		//Smallest Tick Gap Seen, Taken as the Server's Snapshot Period
+	std::vector<uint64_t> tickGaps;
+};
+
+//What a Thread Measured, Merged once all are Done
+struct LoadResults {
+	std::vector<float> arrivals;	//Seconds between Snapshots to the Same Player
+	uint64_t noSnapshots = 0;
+	uint64_t noLost = 0;
+	uint64_t noInputs = 0;
+	uint32_t noJoined = 0;
+};
+
+//Players Joined on every Thread, Watched by the Main Thread to Start the Clock
+std::atomic<uint32_t> noJoinedPlayers(0);
+
+uint64_t handleKey(MatchHandle handle)
+{
+	return (uint64_t)handle.slot << 32 | handle.generation;
+}
+
+void sendTo(int socket, const void* packet, size_t size, const sockaddr_in& to)
+{
+	sendto(socket, packet, size, 0, (const sockaddr*)&to, sizeof(to));
+}
+
+//Deliver a Snapshot; the Server Sends One per Side, so when Both Players Share this Socket each Copy Goes to a Player that has not had it
+void handleSnapshot(std::vector<Player>& players, const std::unordered_multimap<uint64_t, uint32_t>& byMatch, const SnapshotPacket& snapshot,
+	LoadResults& results, double time)
+{
+	auto range = byMatch.equal_range(handleKey(snapshot.match));
+	for (auto it = range.first; it != range.second; it++) {
+		Player& player = players[it->second];
+		if (player.noSnapshots > 0 && snapshot.tick <= player.view.tick) {
+			continue;
+		}
+		if (player.noSnapshots > 0) {
+			uint64_t gap = snapshot.tick - player.view.tick;
+			player.tickStep = player.tickStep == 0 ? gap : std::min(player.tickStep, gap);
+			player.tickGaps.push_back(gap);
+			results.arrivals.push_back((float)(time - player.lastSnapshot));
+		}
+		unpackSnapshot(snapshot, player.view);
+		player.lastSnapshot = time;
+		player.noSnapshots++;
+		results.noSnapshots++;
+		return;
+	}
+}
+
+void handleJoined(std::vector<Player>& players, std::unordered_multimap<uint64_t, uint32_t>& byMatch, uint32_t firstClient,
+	const JoinedPacket& joined, LoadResults& results)
+{
+	uint32_t index = joined.clientId - firstClient;
+	if (index >= players.size() || players[index].joined) {
+		return;
+	}
+	Player& player = players[index];
+	player.joined = true;
+	player.side = joined.side;
+	player.match = joined.match;
+	player.nonce = joined.nonce;
+	player.params = joined.params;
+	Level empty;
+	initSim(player.view, empty, joined.noBalls, joined.params, joined.seed);
+	byMatch.insert({ handleKey(joined.match), index });
+	results.noJoined++;
+	noJoinedPlayers++;
+}
+
+//Play a Share of the Players on One Socket until the Deadline
+void runPlayers(const LoadOptions& options, uint32_t firstClient, uint32_t noPlayers, const std::atomic<double>& deadline, LoadResults& results)
+{
+	int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	int bufferSize = 4 << 20;
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+	std::vector<Player> players(noPlayers);
+	for (uint32_t i = 0; i < noPlayers; i++) {
+		players[i].clientId = firstClient + i;
+	}
+	std::unordered_multimap<uint64_t, uint32_t> byMatch;
+	BotParams bot;
+	double inputPeriod = 1.0 / options.inputHz;
+	double nextInput = now();
+	char buffer[NET_MAX_PACKET];
+
+	while (now() < deadline.load()) {
+		double time = now();
+
+		//Joins are Resent until Answered, since Datagrams can be Lost
+		for (Player& player : players) {
+			if (!player.joined && time - player.lastJoin >= 0.5) {
+				JoinPacket join = {};
+				initNetHeader(join.header, PACKET_JOIN);
+				join.clientId = player.clientId;
+				sendTo(sock, &join, sizeof(join), options.server);
+				player.lastJoin = time;
+			}
+		}
+
+		//Inputs Start as soon as a Player Joins, as the Server Starts the Match only once Both have Echoed their Nonce
+		if (time >= nextInput) {
+			for (Player& player : players) {
+				if (!player.joined) {
+					continue;
+				}
+				InputPacket input = {};
+				initNetHeader(input.header, PACKET_INPUT);
+				input.match = player.match;
+				input.side = player.side;
+				input.buttons = botInput(player.view, player.side, player.params, bot);
+				input.tick = player.view.tick;
+				input.nonce = player.nonce;
+				sendTo(sock, &input, sizeof(input), options.server);
+				results.noInputs++;
+			}
+			nextInput = std::max(nextInput + inputPeriod, time);
+		}
+
+		pollfd fd = { sock, POLLIN, 0 };
+		int timeout = (int)std::max(0.0, (nextInput - now()) * 1000.0);
+		if (poll(&fd, 1, std::min(timeout, 10)) <= 0) {
+			continue;
+		}
+		ssize_t size;
+		while ((size = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+			time = now();
+			uint16_t type = packetType(buffer, size);
+			if (type == PACKET_SNAPSHOT) {
+				SnapshotPacket snapshot;
+				if (readSnapshot(buffer, size, snapshot)) {
+					handleSnapshot(players, byMatch, snapshot, results, time);
+				}
+			}
+			else if (type == PACKET_JOINED) {
+				JoinedPacket joined;
+				if (readPacket(buffer, size, joined)) {
+					handleJoined(players, byMatch, firstClient, joined, results);
+				}
+			}
+		}
+	}
+
+	//Snapshots the Server Sent but that Never Arrived
+	for (Player& player : players) {
+		for (uint64_t gap : player.tickGaps) {
+			results.noLost += gap / player.tickStep - 1;
+		}
+		if (player.joined) {
+			LeavePacket leave = {};
+			initNetHeader(leave.header, PACKET_LEAVE);
+			leave.match = player.match;
+			leave.side = player.side;
+			leave.nonce = player.nonce;
+			sendTo(sock, &leave, sizeof(leave), options.server);
+		}
+	}
+	close(sock);
+}
+
+/* - Main - */
+
+//Ask the Server for its Load, False if it does not Answer within a Second
+bool queryStats(const LoadOptions& options, StatsPacket& stats)
+{
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	StatsQueryPacket query = {};
+	initNetHeader(query.header, PACKET_STATS_QUERY);
+	bool answered = false;
+	for (int attempt = 0; attempt < 5 && !answered; attempt++) {
+		sendTo(sock, &query, sizeof(query), options.server);
+		pollfd fd = { sock, POLLIN, 0 };
+		char buffer[NET_MAX_PACKET];
+		while (!answered && poll(&fd, 1, 200) > 0) {
+			ssize_t size = recv(sock, buffer, sizeof(buffer), 0);
+			answered = size > 0 && packetType(buffer, size) == PACKET_STATS && readPacket(buffer, size, stats);
+		}
+	}
+	close(sock);
+	return answered;
+}
+
+int main(int argc, char** argv)
+{
+	LoadOptions options;
+	const char* address = "127.0.0.1";
+	uint16_t port = NET_DEFAULT_PORT;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+			address = argv[++i];
+		}
+		else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+			port = (uint16_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+			options.noMatches = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			options.seconds = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			options.noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--input-hz") == 0 && i + 1 < argc) {
+			options.inputHz = std::max(1, atoi(argv[++i]));
+		}
+	}
+	options.server.sin_family = AF_INET;
+	options.server.sin_port = htons(port);
+	if (inet_pton(AF_INET, address, &options.server.sin_addr) != 1) {
+		std::cout << "Not an IPv4 address: " << address << std::endl;
+		return -1;
+	}
+
+	//Players are Dealt Out in Order, so Most Matches have Both Players on One Thread
+	uint32_t noPlayers = options.noMatches * 2;
+	uint32_t noThreads = std::min(options.noThreads, noPlayers);
+	std::vector<LoadResults> results(noThreads);
+	std::vector<std::thread> threads;
+	std::atomic<double> deadline(now() + options.seconds + 2.0);
+	uint32_t first = 1;
+	for (uint32_t t = 0; t < noThreads; t++) {
+		uint32_t share = noPlayers / noThreads + (t < noPlayers % noThreads ? 1 : 0);
+		threads.push_back(std::thread(runPlayers, std::cref(options), first, share, std::cref(deadline), std::ref(results[t])));
+		first += share;
+	}
+
+	//The Measured Time Starts once Everyone has Joined, or after Two Seconds of Trying
+	double start = now();
+	while (now() - start < 2.0 && noJoinedPlayers < noPlayers) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	deadline = now() + options.seconds;
+
+	//Load at the End of the Run, while the Matches are Still Going
+	std::this_thread::sleep_for(std::chrono::milliseconds(std::max(0, (int)(options.seconds * 1000.0) - 200)));
+	StatsPacket stats;
+	bool haveStats = queryStats(options, stats);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	LoadResults total;
+	for (LoadResults& r : results) {
+		total.arrivals.insert(total.arrivals.end(), r.arrivals.begin(), r.arrivals.end());
+		total.noSnapshots += r.noSnapshots;
+		total.noLost += r.noLost;
+		total.noInputs += r.noInputs;
+		total.noJoined += r.noJoined;
+	}
+	std::cout << total.noJoined << " of " << noPlayers << " players joined, " << total.noSnapshots << " snapshots received, "
+		<< total.noLost << " lost, " << total.noInputs << " inputs sent" << std::endl;
+
+	if (!total.arrivals.empty()) {
+		std::vector<float>& a = total.arrivals;
+		double sum = 0.0;
+		for (float v : a) {
+			sum += v;
+		}
+		std::sort(a.begin(), a.end());
+		std::cout << "Snapshot spacing: mean " << sum / a.size() * 1e3 << " ms, median " << a[a.size() / 2] * 1e3 << " ms, p99 "
+			<< a[(size_t)(a.size() * 0.99)] * 1e3 << " ms, max " << a.back() * 1e3 << " ms" << std::endl;
+	}
+	if (!haveStats) {
+		std::cout << "The server did not answer the stats query" << std::endl;
+		return -1;
+	}
+	std::cout << "Server: " << stats.noMatches << " matches on " << stats.noThreads << " threads, " << stats.busyCores << " cores busy, "
+		<< stats.matchesPerCore << " matches/core, round jitter " << stats.tickJitterMean << " us mean " << stats.tickJitterMax
+		<< " us max, " << stats.noOverruns << " overruns" << std::endl;
+	return 0;
+}
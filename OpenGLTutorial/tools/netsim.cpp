@@ -0,0 +1,247 @@
+/*
+	Lossy link simulator for the snapshot jitter buffer (see interp.h).
+	Plays a bot match, sends its snapshots through a simulated link that
+	delays, jitters, reorders, duplicates and drops them, and draws frames
+	from the jitter buffer, all on a virtual clock so runs are repeatable
+	and take no real time. Each jitter buffer setting is scored on the
+	latency it adds and how smooth the drawing is. No GL needed:
+
+		g++ -std=c++14 -O2 -I../src netsim.cpp -o netsim
+
+	Usage: netsim [options]
+		--seconds S		match length, 60 by default
+		--snapshot-hz N	snapshots per second, 60 by default
+		--fps N			frames drawn per second, 144 by default
+		--latency S		one way base latency in seconds, 0.04 by default
+		--jitter S		mean extra queueing delay in seconds (exponential, heavy tailed in bursts), 0.01 by default
+		--loss P		share of snapshots dropped, 0.02 by default
+		--duplicate P	share of snapshots delivered twice, 0.01 by default
+		--balls N		balls in play, 1 by default
+		--seed N		link and match seed
+
+	For each setting of JitterParams::deviations the table shows the delay
+	the buffer settled on past the base latency, how many frames had to be
+	extrapolated, how many snapshots came too late to be used, and the
+	drawn ball's distance from where it really was at the drawn time. The
+	largest errors are serves, where the ball jumps back to the centre.
+*/
+
+#include "bot.h"
+#include "interp.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+/* - Link - */
+
+struct LinkParams {
+	double latency = 0.04;
+	double jitter = 0.01;
+	double loss = 0.02;
+	double duplicate = 0.01;
+};
+
+struct InFlight {
+	double arrival;
+	SnapshotPacket packet;
+};
+
+struct LaterArrival {
+	bool operator()(const InFlight& a, const InFlight& b) const
+	{
+		return a.arrival > b.arrival;
+	}
+};
+
+typedef std::priority_queue<InFlight, std::vector<InFlight>, LaterArrival> Link;
+
+//Queueing Delay is Exponential, with One Send in Fifty Caught Behind a Burst Ten Times as Long, as on a Busy Wi-Fi Link
+void sendOverLink(Link& link, const SnapshotPacket& packet, double time, const LinkParams& params, std::mt19937_64& random)
+{
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	if (uniform(random) < params.loss) {
+		return;
+	}
+	int copies = uniform(random) < params.duplicate ? 2 : 1;
+	for (int i = 0; i < copies; i++) {
+		double queueing = params.jitter > 0.0 ? std::exponential_distribution<double>(1.0 / params.jitter)(random) : 0.0;
+		if (uniform(random) < 0.02) {
+			queueing *= 10.0;
+		}
+		link.push({ time + params.latency + queueing, packet });
+	}
+}
+
+/* - Scoring - */
+
+struct TruthFrame {
+	vec2 paddles[2];
+	vec2 balls[MAX_BALLS];
+};
+
+struct RunResult {
+	double delay = 0.0;			//Mean Playout Delay past the Base Latency, Seconds
+	double extrapolated = 0.0;	//Share of Frames
+	double late = 0.0;			//Share of Snapshots Received
+	double errorMean = 0.0;		//Drawn Ball against the Truth at the Drawn Time, Arena Units
+	double errorP99 = 0.0;
+	double errorMax = 0.0;
+};
+
+//Play the Recorded Snapshots through One Link and Buffer Setting
+RunResult runLink(const std::vector<SnapshotPacket>& sent, const std::vector<TruthFrame>& truth, float tickRate, double seconds, uint32_t fps,
+	const LinkParams& linkParams, const JitterParams& jitterParams, uint64_t seed)
+{
+	std::mt19937_64 random(seed);
+	Link link;
+	JitterBuffer buffer;
+	initJitterBuffer(buffer, tickRate);
+
+	RunResult result;
+	std::vector<float> errors;
+	size_t next = 0;
+	double frameLength = 1.0 / fps;
+	double delaySum = 0.0;
+	for (double time = 0.0; time < seconds; time += frameLength) {
+		while (next < sent.size() && sent[next].tick / tickRate <= time) {
+			sendOverLink(link, sent[next], sent[next].tick / tickRate, linkParams, random);
+			next++;
+		}
+		while (!link.empty() && link.top().arrival <= time) {
+			pushSnapshot(buffer, link.top().packet, link.top().arrival, jitterParams);
+			link.pop();
+		}
+
+		vec2 paddles[2];
+		vec2 balls[MAX_BALLS];
+		uint32_t noBalls = sampleJitterBuffer(buffer, time, jitterParams, paddles, balls);
+		if (noBalls == 0) {
+			continue;
+		}
+
+		//Compared with the Truth at the Drawn Time, once the Delay has had a Second to Settle
+		double drawn = playoutTime(buffer, time) * tickRate;
+		if (time < 1.0 || drawn < 0.0 || drawn >= truth.size()) {
+			continue;
+		}
+		const TruthFrame& real = truth[std::min(truth.size() - 1, (size_t)(drawn + 0.5))];
+		for (uint32_t i = 0; i < noBalls; i++) {
+			float dx = balls[i].x - real.balls[i].x;
+			float dy = balls[i].y - real.balls[i].y;
+			errors.push_back(sqrtf(dx * dx + dy * dy));
+		}
+		delaySum += buffer.delay;
+	}
+
+	if (!errors.empty()) {
+		double sum = 0.0;
+		for (float e : errors) {
+			sum += e;
+		}
+		std::sort(errors.begin(), errors.end());
+		result.errorMean = sum / errors.size();
+		result.errorP99 = errors[(size_t)(errors.size() * 0.99)];
+		result.errorMax = errors.back();
+		result.delay = delaySum / (errors.size() / (double)sent[0].noBalls);
+	}
+	result.extrapolated = buffer.noFrames ? (double)buffer.noExtrapolated / buffer.noFrames : 0.0;
+	result.late = buffer.noReceived ? (double)buffer.noLate / buffer.noReceived : 0.0;
+	return result;
+}
+
+/* - Main - */
+
+int main(int argc, char** argv)
+{
+	double seconds = 60.0;
+	uint32_t snapshotHz = 60;
+	uint32_t fps = 144;
+	uint32_t noBalls = 1;
+	uint64_t seed = 1;
+	LinkParams linkParams;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--snapshot-hz") == 0 && i + 1 < argc) {
+			snapshotHz = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			fps = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+			linkParams.latency = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+			linkParams.jitter = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+			linkParams.loss = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--duplicate") == 0 && i + 1 < argc) {
+			linkParams.duplicate = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+			noBalls = std::max(1, std::min((int)MAX_BALLS, atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+	}
+
+	//The Match is Played Once, Keeping the Truth every Tick and the Snapshots the Server would Send
+	SimParams params;
+	Level level;
+	genBrickLevel(level, 0, params.arenaWidth, params.arenaHeight);
+	SimState state;
+	initSim(state, level, noBalls, params, seed);
+	BotParams bot;
+	uint32_t snapshotTicks = std::max(1u, params.tickRate / snapshotHz);
+	uint64_t noTicks = (uint64_t)(seconds * params.tickRate);
+	std::vector<TruthFrame> truth(noTicks + 1);
+	std::vector<SnapshotPacket> sent;
+	for (uint64_t t = 0; t <= noTicks; t++) {
+		TruthFrame& frame = truth[state.tick];
+		frame.paddles[0] = state.paddles[0];
+		frame.paddles[1] = state.paddles[1];
+		for (uint32_t i = 0; i < state.noBalls; i++) {
+			frame.balls[i] = state.balls[i].pos;
+		}
+		if (state.tick % snapshotTicks == 0) {
+			//Through the Wire Encoding, so Quantization Counts in the Error
+			SnapshotPacket snapshot;
+			packSnapshot(snapshot, MatchHandle{ 0, 0 }, state);
+			uint8_t wire[SNAPSHOT_WIRE_BUFFER];
+			size_t size = encodeSnapshot(snapshot, wire);
+			sent.emplace_back();
+			readSnapshot(wire, size, sent.back());
+		}
+		if (t < noTicks) {
+			stepSim(state, level, botMatchInput(state, params, bot, bot), params);
+		}
+	}
+
+	std::cout << sent.size() << " snapshots at " << snapshotHz << " Hz, drawn at " << fps << " fps over a link with " << linkParams.latency * 1e3
+		<< " ms latency, " << linkParams.jitter * 1e3 << " ms mean jitter, " << linkParams.loss * 100.0 << "% loss, "
+		<< linkParams.duplicate * 100.0 << "% duplicates" << std::endl << std::endl;
+	std::cout << std::left << std::setw(12) << "deviations" << std::setw(14) << "delay ms" << std::setw(16) << "extrapolated %"
+		<< std::setw(10) << "late %" << std::setw(14) << "error mean" << std::setw(12) << "error p99" << "error max" << std::endl;
+
+	//Every Setting Sees the Same Link, Drawn from the Same Seed
+	const float deviations[] = { 0.0f, 0.5f, 1.0f, 1.5f, 2.0f, 2.5f, 3.0f, 4.0f };
+	for (float d : deviations) {
+		JitterParams jitterParams;
+		jitterParams.deviations = d;
+		RunResult r = runLink(sent, truth, (float)params.tickRate, seconds, fps, linkParams, jitterParams, seed);
+		std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(12) << d << std::setw(14) << r.delay * 1e3
+			<< std::setw(16) << r.extrapolated * 100.0 << std::setw(10) << r.late * 100.0 << std::setw(14) << r.errorMean
+			<< std::setw(12) << r.errorP99 << r.errorMax << std::endl;
+	}
+	return 0;
+}
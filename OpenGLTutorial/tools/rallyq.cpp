@@ -0,0 +1,198 @@
+/*
+	Query tool for the rally column store written by batch. Scans the
+	mapped columns one block at a time, filtering and aggregating with the
+	SIMD kernels in columns.h. No GL needed:
+
+		g++ -std=c++14 -O2 -I../src rallyq.cpp -o rallyq
+
+	Usage: rallyq <store dir> <column> [options]
+		--where COL LO HI	keep rallies with LO <= COL <= HI, repeatable
+		--bins N			histogram bins, 20 by default, 0 for none
+		--pct P,P,...		percentiles, 50,90,99 by default
+
+	Columns: match, length, hits, hitOffset, speed, winner (see rally.h).
+*/
+
+#include "rally.h"
+#include "columns.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Query - */
+
+struct RangeFilter {
+	uint32_t column;
+	uint32_t lo;
+	uint32_t hi;
+};
+
+//Column Index by Name, -1 if Unknown
+int rallyColumn(const char* name)
+{
+	for (uint32_t i = 0; i < NO_RALLY_COLUMNS; i++) {
+		if (strcmp(name, RALLY_COLUMNS[i]) == 0) {
+			return i;
+		}
+	}
+	std::cout << "Unknown column " << name << std::endl;
+	return -1;
+}
+
+//Smallest Value with at least p Percent of the Counted Rows at or below it, Exact when Bins are One Value Wide
+uint32_t percentile(const std::vector<uint64_t>& bins, uint64_t total, uint32_t lo, uint32_t binWidth, double p)
+{
+	uint64_t rank = (uint64_t)(p / 100.0 * total + 0.5);
+	rank = rank < 1 ? 1 : rank;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < bins.size(); i++) {
+		seen += bins[i];
+		if (seen >= rank) {
+			return lo + (uint32_t)i * binWidth;
+		}
+	}
+	return lo + (uint32_t)(bins.size() - 1) * binWidth;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		std::cout << "Usage: rallyq <store dir> <column> [--where COL LO HI]... [--bins N] [--pct P,P,...]" << std::endl;
+		return -1;
+	}
+
+	std::string dir = argv[1];
+	int target = rallyColumn(argv[2]);
+	if (target < 0) {
+		return -1;
+	}
+
+	std::vector<RangeFilter> filters;
+	uint32_t noBins = 20;
+	std::vector<double> percentiles = { 50.0, 90.0, 99.0 };
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "--where") == 0 && i + 3 < argc) {
+			int column = rallyColumn(argv[i + 1]);
+			if (column < 0) {
+				return -1;
+			}
+			filters.push_back({ (uint32_t)column, (uint32_t)strtoul(argv[i + 2], NULL, 10), (uint32_t)strtoul(argv[i + 3], NULL, 10) });
+			i += 3;
+		}
+		else if (strcmp(argv[i], "--bins") == 0 && i + 1 < argc) {
+			noBins = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--pct") == 0 && i + 1 < argc) {
+			percentiles.clear();
+			std::stringstream list(argv[++i]);
+			std::string p;
+			while (std::getline(list, p, ',')) {
+				percentiles.push_back(atof(p.c_str()));
+			}
+		}
+	}
+
+	//Only Map the Columns the Query Touches
+	ColumnFile columns[NO_RALLY_COLUMNS];
+	bool used[NO_RALLY_COLUMNS] = {};
+	used[target] = true;
+	for (const RangeFilter& filter : filters) {
+		used[filter.column] = true;
+	}
+	for (uint32_t i = 0; i < NO_RALLY_COLUMNS; i++) {
+		if (used[i] && !openColumnFile(columns[i], dir + "/" + RALLY_COLUMNS[i] + ".col")) {
+			return -1;
+		}
+	}
+	const ColumnHeader& header = columns[target].header;
+	for (uint32_t i = 0; i < NO_RALLY_COLUMNS; i++) {
+		if (used[i] && columns[i].header.noValues != header.noValues) {
+			std::cout << RALLY_COLUMNS[i] << " has " << columns[i].header.noValues << " rows, " << RALLY_COLUMNS[target] << " has " << header.noValues << std::endl;
+			return -1;
+		}
+	}
+
+	//Percentiles Come from a Histogram of the Whole Range, with Bins of One Value when it is Small Enough to be Exact
+	const uint32_t exactRange = 1 << 20;
+	uint32_t lo = header.minValue;
+	uint64_t range = (uint64_t)header.maxValue - lo + 1;
+	uint32_t fineWidth = range <= exactRange ? 1 : (uint32_t)((range + exactRange - 1) / exactRange);
+	std::vector<uint64_t> fine((size_t)((range + fineWidth - 1) / fineWidth), 0);
+
+	std::vector<uint32_t> values(COLUMN_BLOCK_SIZE);
+	std::vector<uint32_t> filterValues(COLUMN_BLOCK_SIZE);
+	std::vector<uint32_t> mask(COLUMN_BLOCK_SIZE);
+	ColumnStats stats;
+	double start = now();
+	for (uint64_t b = 0; b < header.noBlocks; b++) {
+		uint32_t count = decodeColumnBlock(columns[target], b, values.data());
+		resetMask(mask.data(), count);
+		for (const RangeFilter& filter : filters) {
+			if (filter.column == (uint32_t)target) {
+				filterRange(values.data(), count, filter.lo, filter.hi, mask.data());
+			}
+			else {
+				decodeColumnBlock(columns[filter.column], b, filterValues.data());
+				filterRange(filterValues.data(), count, filter.lo, filter.hi, mask.data());
+			}
+		}
+		accumulateStats(values.data(), mask.data(), count, stats);
+		accumulateHistogram(values.data(), mask.data(), count, lo, fineWidth, fine);
+	}
+	double elapsed = now() - start;
+
+	std::cout << RALLY_COLUMNS[target] << ": " << stats.count << " of " << header.noValues << " rallies";
+	if (stats.count > 0) {
+		std::cout << ", mean " << (double)stats.sum / stats.count << ", min " << stats.min << ", max " << stats.max;
+	}
+	std::cout << std::endl;
+	if (stats.count == 0) {
+		return 0;
+	}
+
+	for (double p : percentiles) {
+		std::cout << "p" << p << ": " << percentile(fine, stats.count, lo, fineWidth, p) << (fineWidth > 1 ? " (approximate)" : "") << std::endl;
+	}
+
+	//Display Histogram over the Passing Rows' Range, Merged from the Fine Bins
+	if (noBins > 0) {
+		uint32_t first = (stats.min - lo) / fineWidth;
+		uint32_t last = (stats.max - lo) / fineWidth;
+		uint32_t perBin = (last - first) / noBins + 1;
+		uint64_t peak = 0;
+		std::vector<uint64_t> bins((last - first) / perBin + 1, 0);
+		for (uint32_t i = first; i <= last; i++) {
+			bins[(i - first) / perBin] += fine[i];
+		}
+		for (uint64_t count : bins) {
+			peak = count > peak ? count : peak;
+		}
+		for (size_t i = 0; i < bins.size(); i++) {
+			uint64_t binLo = lo + (uint64_t)(first + i * perBin) * fineWidth;
+			uint64_t binHi = binLo + (uint64_t)perBin * fineWidth - 1;
+			std::cout << binLo << "-" << binHi << "\t" << bins[i] << "\t" << std::string((size_t)(bins[i] * 50 / peak), '#') << std::endl;
+		}
+	}
+
+	std::cout << "scanned " << header.noValues << " rows in " << elapsed * 1000.0 << " ms, "
+		<< header.noValues / elapsed / 1e6 << " M rows/s" << std::endl;
+
+	for (uint32_t i = 0; i < NO_RALLY_COLUMNS; i++) {
+		if (used[i]) {
+			closeColumnFile(columns[i]);
+		}
+	}
+	return 0;
+}
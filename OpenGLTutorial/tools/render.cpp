@@ -0,0 +1,349 @@
+/*
+	Offline replay renderer: steps a recorded match and draws it with the
+	software rasterizer as fast as the machine allows, no GPU or window
+	needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src render.cpp -o render
+
+	Usage: render <replay> <output> [options]
+		output		frame file pattern with one integer conversion such as frames/%06d.ppm,
+					or - for raw RGB24 on stdout
+		--size WxH	frame size, 800x600 by default
+		--fps N		frames per second of match time, 60 by default
+		--threads N	encoding threads, one per core by default
+		--ring N	frames in flight between the simulation and the encoders, 2 per thread by default
+		--from S	start S seconds into the match, seeking from the nearest keyframe
+		--to S		stop S seconds into the match
+
+	Raw output goes straight into an encoder, e.g.
+		render match.rpl - | ffmpeg -f rawvideo -pix_fmt rgb24 -s 800x600 -r 60 -i - match.mp4
+
+	Progress goes to stderr so stdout can carry video.
+*/
+
+#include "replay.h"
+#include "raster.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Frame Ring - */
+
+enum SlotState {
+	SLOT_FREE,
+	SLOT_QUEUED,
+	SLOT_ENCODED
+};
+
+//A Frame on its Way from the Simulation to the Output
+struct FrameSlot {
+	Framebuffer frame;
+	std::vector<uint8_t> encoded;
+	uint64_t frameNo;
+	SlotState state = SLOT_FREE;
+};
+
+//Slots are Reused in Frame Order, so Waiting on the Oldest Keeps Ordered Output Simple
+struct FrameRing {
+	std::vector<FrameSlot> slots;
+	std::deque<FrameSlot*> queue;
+	std::mutex mutex;
+	std::condition_variable changed;
+	bool done = false;
+	bool failed = false;	//An Encoder could not Write its Frame
+};
+
+/* - Encoding - */
+
+//The Pattern is Handed to snprintf with the Frame Number as an int, so it must Take Exactly One Integer and Nothing Else
+bool validFramePattern(const char* pattern)
+{
+	uint32_t noConversions = 0;
+	for (const char* c = pattern; *c; c++) {
+		if (*c != '%') {
+			continue;
+		}
+		if (*++c == '%') {
+			continue;
+		}
+		while (*c && strchr("-+ #0", *c)) {
+			c++;
+		}
+		while (*c >= '0' && *c <= '9') {
+			c++;
+		}
+		if (!*c || !strchr("diu", *c)) {
+			return false;
+		}
+		noConversions++;
+	}
+	return noConversions == 1;
+}
+
+//Binary PPM: Header then Packed RGB Rows
+void encodePPM(const Framebuffer& frame, std::vector<uint8_t>& out)
+{
+	char header[32];
+	int headerSize = snprintf(header, sizeof(header), "P6\n%u %u\n255\n", frame.width, frame.height);
+
+	out.resize(headerSize + frame.pixels.size() * 3);
+	memcpy(out.data(), header, headerSize);
+	uint8_t* rgb = out.data() + headerSize;
+	for (uint32_t pixel : frame.pixels) {
+		rgb[0] = (uint8_t)pixel;
+		rgb[1] = (uint8_t)(pixel >> 8);
+		rgb[2] = (uint8_t)(pixel >> 16);
+		rgb += 3;
+	}
+}
+
+//Raw Output Skips the PPM Header
+size_t encodedHeaderSize(const std::vector<uint8_t>& encoded, const Framebuffer& frame)
+{
+	return encoded.size() - frame.pixels.size() * 3;
+}
+
+//Encode Queued Frames; File Output is Written Here, Raw Output by the Simulation Thread in Order
+void encodeWorker(FrameRing& ring, const char* pattern)
+{
+	std::unique_lock<std::mutex> lock(ring.mutex);
+	while (true) {
+		ring.changed.wait(lock, [&] { return !ring.queue.empty() || ring.done; });
+		if (ring.queue.empty()) {
+			return;
+		}
+		FrameSlot* slot = ring.queue.front();
+		ring.queue.pop_front();
+		lock.unlock();
+
+		encodePPM(slot->frame, slot->encoded);
+		bool ok = true;
+		if (pattern) {
+			char path[1024];
+			snprintf(path, sizeof(path), pattern, (int)slot->frameNo);
+			FILE* file = fopen(path, "wb");
+			ok = file && fwrite(slot->encoded.data(), 1, slot->encoded.size(), file) == slot->encoded.size();
+			if (file) {
+				fclose(file);
+			}
+			if (!ok) {
+				std::cerr << "Could not write " << path << std::endl;
+			}
+		}
+
+		lock.lock();
+		slot->state = pattern ? SLOT_FREE : SLOT_ENCODED;
+		ring.failed = ring.failed || !ok;
+		ring.changed.notify_all();
+	}
+}
+
+//Wait until slot can be Reused, Writing it to stdout First in Raw Mode; False once any Frame Failed to Write
+bool reclaimSlot(FrameRing& ring, FrameSlot& slot, bool raw)
+{
+	std::unique_lock<std::mutex> lock(ring.mutex);
+	ring.changed.wait(lock, [&] { return slot.state != SLOT_QUEUED; });
+	if (ring.failed) {
+		return false;
+	}
+	if (slot.state == SLOT_ENCODED) {
+		lock.unlock();
+		size_t skip = encodedHeaderSize(slot.encoded, slot.frame);
+		if (raw && fwrite(slot.encoded.data() + skip, 1, slot.encoded.size() - skip, stdout) != slot.encoded.size() - skip) {
+			std::cerr << "Could not write frame " << slot.frameNo << " to stdout" << std::endl;
+			return false;
+		}
+		lock.lock();
+		slot.state = SLOT_FREE;
+	}
+	return true;
+}
+
+/* - Scene - */
+
+//Obstacles Change Rarely, so they Live in a Background Layer that is Copied into every Frame
+void eraseObstacle(Framebuffer& background, const RasterView& view, const Level& level, const SimState& state, uint32_t idx, uint32_t clearColor)
+{
+	const AABB& box = level.obstacles[idx].box;
+	fillRect(background, box.min.x * view.scaleX, view.height - box.max.y * view.scaleY,
+		box.max.x * view.scaleX, view.height - box.min.y * view.scaleY, clearColor);
+
+	//Redraw Live Neighbours the Erased Box Cut Into
+	queryBVH(level, box, [&](uint32_t other) {
+		if (state.obstacleHp[other] != 0) {
+			rasterInstance(background, view, obstacleRecord(level.obstacles[other]), SHAPE_QUAD);
+		}
+	});
+}
+
+//Moving Pieces on Top of the Background
+void drawMovers(Framebuffer& frame, const RasterView& view, const SimState& state, const SimParams& params)
+{
+	vec4 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (int i = 0; i < 2; i++) {
+		rasterInstance(frame, view, { state.paddles[i], { params.paddleWidth, params.paddleHeight }, white }, SHAPE_QUAD);
+	}
+	for (uint32_t i = 0; i < state.noBalls; i++) {
+		rasterInstance(frame, view, { state.balls[i].pos, { params.ballDiameter, params.ballDiameter }, white }, SHAPE_CIRCLE);
+	}
+}
+
+/* - Main - */
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		std::cerr << "Usage: render <replay> <output> [--size WxH] [--fps N] [--threads N] [--ring N] [--from S] [--to S]" << std::endl;
+		return -1;
+	}
+
+	uint32_t width = 800;
+	uint32_t height = 600;
+	uint32_t fps = 60;
+	uint32_t noThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t ringSize = 0;
+	double from = 0.0;
+	double to = -1.0;
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+			sscanf(argv[++i], "%ux%u", &width, &height);
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			fps = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--ring") == 0 && i + 1 < argc) {
+			ringSize = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+			from = std::max(0.0, atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+			to = atof(argv[++i]);
+		}
+	}
+	if (ringSize == 0) {
+		ringSize = 2 * noThreads;
+	}
+
+	const char* output = argv[2];
+	bool raw = strcmp(output, "-") == 0;
+	const char* pattern = raw ? NULL : output;
+	if (pattern && !validFramePattern(pattern)) {
+		std::cerr << "Output pattern " << pattern << " must hold exactly one integer conversion such as %06d" << std::endl;
+		return -1;
+	}
+
+	Replay replay;
+	Level level;
+	LevelFile levelFile;
+	if (!readReplay(argv[1], replay) || !loadReplayLevel(replay, level, levelFile)) {
+		return -1;
+	}
+	const SimParams& params = replay.params;
+
+	//Frame f Shows the State after the Ticks up to f / fps Seconds of Match Time
+	uint64_t noTicks = replay.inputs.size();
+	uint64_t firstFrame = (uint64_t)(from * fps);
+	uint64_t noFrames = noTicks * fps / params.tickRate;
+	if (to >= 0.0) {
+		noFrames = std::min(noFrames, (uint64_t)(to * fps));
+	}
+	firstFrame = std::min(firstFrame, noFrames);
+
+	SimState state;
+	SimEvents events;
+	double start = now();
+	seekReplay(replay, level, state, firstFrame * params.tickRate / fps);
+	double seekTime = now() - start;
+
+	//Background Layer with every Obstacle Still Standing
+	const uint32_t clearColor = packColor({ 0.0f, 0.0f, 0.0f, 1.0f });
+	Framebuffer background;
+	initFramebuffer(background, width, height);
+	RasterView view = rasterView(background, params.arenaWidth, params.arenaHeight);
+	clearFramebuffer(background, clearColor);
+	for (uint32_t i = 0; i < level.noObstacles; i++) {
+		if (state.obstacleHp[i] == 0) {
+			continue;
+		}
+		rasterInstance(background, view, obstacleRecord(level.obstacles[i]), SHAPE_QUAD);
+	}
+
+	FrameRing ring;
+	ring.slots.resize(ringSize);
+	for (FrameSlot& slot : ring.slots) {
+		initFramebuffer(slot.frame, width, height);
+	}
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < noThreads; i++) {
+		workers.push_back(std::thread(encodeWorker, std::ref(ring), pattern));
+	}
+
+	bool ok = true;
+	start = now();
+	for (uint64_t f = firstFrame; f < noFrames; f++) {
+		uint64_t frameTick = f * params.tickRate / fps;
+		while (state.tick < frameTick) {
+			events.clear();
+			stepSim(state, level, replay.inputs[state.tick], params, &events);
+			for (uint32_t idx : events.destroyed) {
+				eraseObstacle(background, view, level, state, idx, clearColor);
+			}
+		}
+
+		FrameSlot& slot = ring.slots[f % ringSize];
+		if (!reclaimSlot(ring, slot, raw)) {
+			ok = false;
+			break;
+		}
+		memcpy(slot.frame.pixels.data(), background.pixels.data(), background.pixels.size() * sizeof(uint32_t));
+		drawMovers(slot.frame, view, state, params);
+		slot.frameNo = f;
+
+		std::lock_guard<std::mutex> lock(ring.mutex);
+		slot.state = SLOT_QUEUED;
+		ring.queue.push_back(&slot);
+		ring.changed.notify_one();
+	}
+
+	//Flush the Frames Still in the Ring in Order
+	for (uint64_t f = std::max(firstFrame, noFrames > ringSize ? noFrames - ringSize : 0); f < noFrames && ok; f++) {
+		ok = reclaimSlot(ring, ring.slots[f % ringSize], raw);
+	}
+	{
+		std::lock_guard<std::mutex> lock(ring.mutex);
+		ring.done = true;
+		ring.changed.notify_all();
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	ok = ok && !ring.failed;
+	fflush(stdout);
+	unloadLevelFile(levelFile);
+
+	double elapsed = now() - start;
+	double matchTime = (double)(noFrames - firstFrame) / fps;
+	std::cerr << "seeked to " << from << " s in " << seekTime * 1000.0 << " ms" << std::endl;
+	std::cerr << noFrames - firstFrame << " frames (" << width << "x" << height << ") in " << elapsed << " s, "
+		<< (noFrames - firstFrame) / elapsed << " fps, " << matchTime / elapsed << "x real time on " << noThreads << " threads" << std::endl;
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,739 @@
+/*
+	Dedicated headless server hosting many matches in one process. One
+	thread waits on epoll for datagrams and a round timer; each round, the
+	running matches are stepped in batches on a thread pool, and the
+	workers send the snapshots that fall due. Matches live in a slab (see
+	slab.h), so starting and ending them never moves the others. Linux only
+	(epoll, timerfd, recvmmsg, sendmmsg), no GL needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src server.cpp -o server
+
+	Usage: server [options]
+		--port N		UDP port, 27015 by default
+		--threads N		stepping threads including the network thread, one per core by default
+		--round-ticks N	simulation ticks per round, 1 by default
+		--snapshot-hz N	snapshots per second to each player, 60 by default
+		--obstacles N	generated level every match plays on, 0 by default
+		--balls N		balls per match, 1 by default
+		--seed N		seed of every match, matches are numbered in the order they start
+		--fixed-point	step matches in Q16.16
+		--timeout S		end matches with a player silent for S seconds, 5 by default
+		--seconds S		exit after S seconds, run until interrupted by default
+
+	Load is printed every second and sent to anyone asking with a stats
+	query (see loadtest.cpp).
+
+	A seat only counts once an input from its address has echoed the nonce
+	sent in JOINED, so a spoofed join never starts a match streaming
+	snapshots at someone else. Full matches wait as pending until then.
+*/
+
+#include "net.h"
+#include "rules.h"
+#include "slab.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Matches - */
+
+//Matches Stepped per Pool Job; Big Enough to Amortise Taking a Job, Small Enough to Balance Threads
+const uint32_t MATCH_BATCH = 32;
+
+struct Match {
+	SimState state;
+	MatchHandle handle;
+	bool running = false;
+	uint32_t input = 0;			//Buttons Held by Both Sides
+	uint32_t noPlayers = 0;
+	sockaddr_in players[2];
+	uint32_t clientIds[2];
+	uint32_t nonces[2];
+	bool verified[2];			//The Player has Echoed its Nonce from the Address it Joined from
+	double joinedAt[2];
+	double lastHeard[2];		//0 until Verified
+	bool pending = false;		//Full, Waiting for a Player to be Verified
+	uint32_t runningIndex = 0;	//Position in Server::running, or Server::pending while Pending
+};
+
+struct ServerOptions {
+	uint16_t port = NET_DEFAULT_PORT;
+	uint32_t noThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t roundTicks = 1;
+	uint32_t snapshotHz = 60;
+	uint32_t noObstacles = 0;
+	uint32_t noBalls = 1;
+	uint64_t seed = 0;
+	double timeout = 5.0;
+	double seconds = 0.0;
+	SimParams params;
+};
+
+//Snapshots a Thread has Encoded this Round, Sent in One sendmmsg; Both Players' Messages Point at One Encoding
+struct Outbox {
+	std::vector<uint8_t> bytes;			//SNAPSHOT_WIRE_BUFFER per Snapshot
+	std::vector<size_t> sizes;
+	std::vector<uint32_t> snapshots;	//Which Encoding each Message Sends
+	std::vector<sockaddr_in> addresses;
+	std::vector<iovec> iovecs;
+	std::vector<mmsghdr> messages;
+	double busy = 0.0;			//Seconds Spent Stepping and Sending, Reset every Stats Period
+	uint64_t noTicks = 0;
+	uint64_t noSent = 0;
+};
+
+struct Server {
+	ServerOptions options;
+	int socket = -1;
+	int epoll = -1;
+	int timer = -1;
+
+	Level level;
+	StepKernel step = stepSim;				//Every Match Plays the Same Mode, so its Kernel is Chosen Once
+	Slab<Match> matches;
+	std::vector<uint32_t> generations;		//Per Slot, Bumped as each Match Ends
+	std::vector<uint32_t> running;			//Slots of Running Matches, in no Order
+	int waiting = -1;						//Slot of the Match Waiting for its Second Player
+	std::vector<uint32_t> pending;			//Slots of Full Matches Waiting for their Players to be Verified
+	std::random_device nonceSource;
+	std::unordered_map<uint64_t, uint32_t> seats;	//(Address, Port, Client Id) to Slot, so Repeated Joins get the Same Seat
+	uint32_t noStarted = 0;
+	uint32_t snapshotTicks = 1;
+
+	//Stats
+	uint64_t noTicks = 0;
+	uint64_t noReceived = 0;
+	uint32_t noOverruns = 0;
+	double jitterSum = 0.0;
+	double jitterMax = 0.0;
+	uint32_t noRounds = 0;
+	StatsPacket stats;
+};
+
+uint64_t seatKey(const sockaddr_in& address, uint32_t clientId)
+{
+	return (uint64_t)address.sin_addr.s_addr << 32 ^ (uint64_t)address.sin_port << 16 ^ clientId;
+}
+
+bool sameAddress(const sockaddr_in& a, const sockaddr_in& b)
+{
+	return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+//Match a Packet Names, NULL if it has Ended or Never Existed
+Match* findMatch(Server& server, MatchHandle handle)
+{
+	if (handle.slot >= server.generations.size() || server.generations[handle.slot] != handle.generation) {
+		return NULL;
+	}
+	Match& match = slabGet(server.matches, handle.slot);
+	return match.noPlayers > 0 ? &match : NULL;
+}
+
+//Take slot out of list, which Tracks each Match's Position in runningIndex
+void removeMatch(Server& server, std::vector<uint32_t>& list, uint32_t slot)
+{
+	Match& match = slabGet(server.matches, slot);
+	uint32_t last = list.back();
+	list[match.runningIndex] = last;
+	slabGet(server.matches, last).runningIndex = match.runningIndex;
+	list.pop_back();
+}
+
+void endMatch(Server& server, uint32_t slot)
+{
+	Match& match = slabGet(server.matches, slot);
+	if (match.running) {
+		removeMatch(server, server.running, slot);
+	}
+	if (match.pending) {
+		removeMatch(server, server.pending, slot);
+	}
+	if (server.waiting == (int)slot) {
+		server.waiting = -1;
+	}
+	for (uint32_t side = 0; side < match.noPlayers; side++) {
+		server.seats.erase(seatKey(match.players[side], match.clientIds[side]));
+	}
+	server.generations[slot]++;
+	slabFree(server.matches, slot);
+}
+
+/* - Packets - */
+
+void sendPacket(Server& server, const void* packet, size_t size, const sockaddr_in& to)
+{
+	sendto(server.socket, packet, size, 0, (const sockaddr*)&to, sizeof(to));
+}
+
+void sendJoined(Server& server, const Match& match, uint32_t side)
+{
+	JoinedPacket joined = {};
+	initNetHeader(joined.header, PACKET_JOINED);
+	joined.clientId = match.clientIds[side];
+	joined.side = side;
+	joined.match = match.handle;
+	joined.seed = server.options.seed;
+	joined.noBalls = server.options.noBalls;
+	joined.nonce = match.nonces[side];
+	joined.params = server.options.params;
+	sendPacket(server, &joined, sizeof(joined), match.players[side]);
+}
+
+//Seat a Player in the Waiting Match, Starting it, or in a New One
+void handleJoin(Server& server, const JoinPacket& join, const sockaddr_in& from, double time)
+{
+	auto seat = server.seats.find(seatKey(from, join.clientId));
+	if (seat != server.seats.end()) {
+		Match& match = slabGet(server.matches, seat->second);
+		for (uint32_t side = 0; side < match.noPlayers; side++) {
+			if (sameAddress(match.players[side], from) && match.clientIds[side] == join.clientId) {
+				sendJoined(server, match, side);
+			}
+		}
+		return;
+	}
+
+	if (server.waiting < 0) {
+		uint32_t slot = slabAlloc(server.matches);
+		if (slot >= server.generations.size()) {
+			server.generations.resize(slot + 1, 0);
+		}
+		Match& match = slabGet(server.matches, slot);
+		match.handle = { slot, server.generations[slot] };
+		server.waiting = (int)slot;
+	}
+
+	uint32_t slot = (uint32_t)server.waiting;
+	Match& match = slabGet(server.matches, slot);
+	uint32_t side = match.noPlayers++;
+	match.players[side] = from;
+	match.clientIds[side] = join.clientId;
+	match.nonces[side] = server.nonceSource();
+	match.verified[side] = false;
+	match.joinedAt[side] = time;
+	match.lastHeard[side] = 0.0;
+	server.seats[seatKey(from, join.clientId)] = slot;
+	sendJoined(server, match, side);
+
+	//Full, but Neither Side Plays until Both have Answered from where they Joined
+	if (match.noPlayers == 2) {
+		match.pending = true;
+		match.runningIndex = (uint32_t)server.pending.size();
+		server.pending.push_back(slot);
+		server.waiting = -1;
+	}
+}
+
+//Move a Pending Match whose Players are Both Verified to Running
+void startMatch(Server& server, uint32_t slot)
+{
+	removeMatch(server, server.pending, slot);
+	Match& match = slabGet(server.matches, slot);
+	match.pending = false;
+	initSim(match.state, server.level, server.options.noBalls, server.options.params, server.options.seed, server.noStarted++);
+	match.running = true;
+	match.runningIndex = (uint32_t)server.running.size();
+	server.running.push_back(slot);
+}
+
+void handleInput(Server& server, const InputPacket& input, const sockaddr_in& from, double time)
+{
+	Match* match = findMatch(server, input.match);
+	if (!match || input.side >= match->noPlayers || !sameAddress(match->players[input.side], from) || input.nonce != match->nonces[input.side]) {
+		return;
+	}
+	uint32_t mask = input.side == 0 ? INPUT_P0_UP | INPUT_P0_DOWN : INPUT_P1_UP | INPUT_P1_DOWN;
+	match->input = (match->input & ~mask) | (input.buttons & mask);
+	match->lastHeard[input.side] = time;
+	if (!match->verified[input.side]) {
+		match->verified[input.side] = true;
+		if (match->pending && match->verified[0] && match->verified[1]) {
+			startMatch(server, input.match.slot);
+		}
+	}
+}
+
+void handleLeave(Server& server, const LeavePacket& leave, const sockaddr_in& from)
+{
+	Match* match = findMatch(server, leave.match);
+	if (match && leave.side < match->noPlayers && sameAddress(match->players[leave.side], from) && leave.nonce == match->nonces[leave.side]) {
+		endMatch(server, leave.match.slot);
+	}
+}
+
+void handleDatagram(Server& server, const char* data, size_t size, const sockaddr_in& from, double time)
+{
+	server.noReceived++;
+	switch (packetType(data, size)) {
+	case PACKET_JOIN: {
+		JoinPacket join;
+		if (readPacket(data, size, join)) {
+			handleJoin(server, join, from, time);
+		}
+		break;
+	}
+	case PACKET_INPUT: {
+		InputPacket input;
+		if (readPacket(data, size, input)) {
+			handleInput(server, input, from, time);
+		}
+		break;
+	}
+	case PACKET_LEAVE: {
+		LeavePacket leave;
+		if (readPacket(data, size, leave)) {
+			handleLeave(server, leave, from);
+		}
+		break;
+	}
+	case PACKET_STATS_QUERY: {
+		StatsQueryPacket query;
+		if (readPacket(data, size, query)) {
+			sendPacket(server, &server.stats, sizeof(server.stats), from);
+		}
+		break;
+	}
+	}
+}
+
+//Read every Queued Datagram, up to 64 per System Call
+void drainSocket(Server& server)
+{
+	const uint32_t noSlots = 64;
+	static char buffers[noSlots][NET_MAX_PACKET];
+	static sockaddr_in addresses[noSlots];
+	static iovec iovecs[noSlots];
+	static mmsghdr messages[noSlots];
+
+	while (true) {
+		for (uint32_t i = 0; i < noSlots; i++) {
+			iovecs[i] = { buffers[i], NET_MAX_PACKET };
+			memset(&messages[i], 0, sizeof(mmsghdr));
+			messages[i].msg_hdr.msg_iov = &iovecs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+			messages[i].msg_hdr.msg_name = &addresses[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		}
+		int noMessages = recvmmsg(server.socket, messages, noSlots, MSG_DONTWAIT, NULL);
+		if (noMessages <= 0) {
+			return;
+		}
+		double time = now();
+		for (int i = 0; i < noMessages; i++) {
+			handleDatagram(server, buffers[i], messages[i].msg_len, addresses[i], time);
+		}
+	}
+}
+
+/* - Stepping - */
+
+void flushOutbox(Server& server, Outbox& outbox)
+{
+	size_t noPackets = outbox.snapshots.size();
+	outbox.iovecs.resize(noPackets);
+	outbox.messages.resize(noPackets);
+	for (size_t i = 0; i < noPackets; i++) {
+		uint32_t snapshot = outbox.snapshots[i];
+		outbox.iovecs[i] = { &outbox.bytes[snapshot * SNAPSHOT_WIRE_BUFFER], outbox.sizes[snapshot] };
+		memset(&outbox.messages[i], 0, sizeof(mmsghdr));
+		outbox.messages[i].msg_hdr.msg_iov = &outbox.iovecs[i];
+		outbox.messages[i].msg_hdr.msg_iovlen = 1;
+		outbox.messages[i].msg_hdr.msg_name = &outbox.addresses[i];
+		outbox.messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	//A Full Send Buffer Drops the Rest, as the Network would; the Next Snapshot Supersedes them
+	size_t sent = 0;
+	while (sent < noPackets) {
+		int n = sendmmsg(server.socket, &outbox.messages[sent], (unsigned int)(noPackets - sent), 0);
+		if (n <= 0) {
+			break;
+		}
+		sent += n;
+	}
+	outbox.noSent += sent;
+	outbox.bytes.clear();
+	outbox.sizes.clear();
+	outbox.snapshots.clear();
+	outbox.addresses.clear();
+}
+
+//Encode a Match's Snapshot Once for Both Players
+void queueSnapshot(Outbox& outbox, const Match& match)
+{
+	SnapshotPacket snapshot;
+	packSnapshot(snapshot, match.handle, match.state);
+	uint32_t index = (uint32_t)outbox.sizes.size();
+	outbox.bytes.resize((index + 1) * SNAPSHOT_WIRE_BUFFER);
+	outbox.sizes.push_back(encodeSnapshot(snapshot, &outbox.bytes[index * SNAPSHOT_WIRE_BUFFER]));
+	for (uint32_t side = 0; side < 2; side++) {
+		outbox.snapshots.push_back(index);
+		outbox.addresses.push_back(match.players[side]);
+	}
+}
+
+//Step Running Matches [first, last) by noTicks, Queueing the Snapshots that Fall Due
+void stepBatch(Server& server, Outbox& outbox, uint32_t first, uint32_t last, uint32_t noTicks)
+{
+	double start = now();
+	const SimParams& params = server.options.params;
+	for (uint32_t i = first; i < last; i++) {
+		Match& match = slabGet(server.matches, server.running[i]);
+		for (uint32_t t = 0; t < noTicks; t++) {
+			server.step(match.state, server.level, (uint8_t)match.input, params, NULL);
+			if (match.state.tick % server.snapshotTicks == 0) {
+				queueSnapshot(outbox, match);
+			}
+		}
+	}
+	outbox.noTicks += (uint64_t)(last - first) * noTicks;
+	flushOutbox(server, outbox);
+	outbox.busy += now() - start;
+}
+
+//Worker Threads Wait for a Round, then Take Batches until None are Left; the Network Thread Joins in as Thread 0
+struct StepPool {
+	std::vector<std::thread> threads;
+	std::vector<Outbox> outboxes;
+	std::mutex mutex;
+	std::condition_variable started;
+	std::condition_variable finished;
+	uint64_t round = 0;
+	uint32_t noWorking = 0;
+	bool quit = false;
+
+	Server* server = NULL;
+	uint32_t noTicks = 0;
+	uint32_t noBatches = 0;
+	std::atomic<uint32_t> nextBatch;
+};
+
+void takeBatches(StepPool& pool, uint32_t thread)
+{
+	Server& server = *pool.server;
+	uint32_t noRunning = (uint32_t)server.running.size();
+	uint32_t batch;
+	while ((batch = pool.nextBatch++) < pool.noBatches) {
+		uint32_t first = batch * MATCH_BATCH;
+		stepBatch(server, pool.outboxes[thread], first, std::min(first + MATCH_BATCH, noRunning), pool.noTicks);
+	}
+}
+
+void poolWorker(StepPool& pool, uint32_t thread)
+{
+	uint64_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(pool.mutex);
+			pool.started.wait(lock, [&] { return pool.quit || pool.round != seen; });
+			if (pool.quit) {
+				return;
+			}
+			seen = pool.round;
+		}
+		takeBatches(pool, thread);
+		{
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			if (--pool.noWorking == 0) {
+				pool.finished.notify_one();
+			}
+		}
+	}
+}
+
+void startPool(StepPool& pool, Server& server, uint32_t noThreads)
+{
+	pool.server = &server;
+	pool.outboxes.resize(noThreads);
+	pool.nextBatch = 0;
+	for (uint32_t i = 1; i < noThreads; i++) {
+		pool.threads.push_back(std::thread(poolWorker, std::ref(pool), i));
+	}
+}
+
+void stopPool(StepPool& pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.quit = true;
+	}
+	pool.started.notify_all();
+	for (std::thread& thread : pool.threads) {
+		thread.join();
+	}
+}
+
+//Step every Running Match by noTicks, Returning once all are Done
+void runRound(StepPool& pool, uint32_t noTicks)
+{
+	Server& server = *pool.server;
+	uint32_t noBatches = ((uint32_t)server.running.size() + MATCH_BATCH - 1) / MATCH_BATCH;
+	if (noBatches == 0) {
+		return;
+	}
+	pool.noTicks = noTicks;
+	pool.noBatches = noBatches;
+	pool.nextBatch = 0;
+
+	//Small Rounds are Cheaper Stepped Here than Handed to Sleeping Threads
+	if (noBatches == 1 || pool.threads.empty()) {
+		takeBatches(pool, 0);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.noWorking = (uint32_t)pool.threads.size();
+		pool.round++;
+	}
+	pool.started.notify_all();
+	takeBatches(pool, 0);
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	pool.finished.wait(lock, [&] { return pool.noWorking == 0; });
+}
+
+/* - Housekeeping - */
+
+//Last Time a Seat was Heard from, Counting from the Join until it is Verified
+double seatHeard(const Match& match, uint32_t side)
+{
+	return match.verified[side] ? match.lastHeard[side] : match.joinedAt[side];
+}
+
+//End Matches where a Player has Gone Quiet or Never Answered, Waiting and Pending Ones Included
+void dropSilentMatches(Server& server, double time)
+{
+	const double timeout = server.options.timeout;
+	for (std::vector<uint32_t>* list : { &server.running, &server.pending }) {
+		for (uint32_t i = (uint32_t)list->size(); i > 0; i--) {
+			uint32_t slot = (*list)[i - 1];
+			Match& match = slabGet(server.matches, slot);
+			if (time - seatHeard(match, 0) > timeout || time - seatHeard(match, 1) > timeout) {
+				endMatch(server, slot);
+			}
+		}
+	}
+	if (server.waiting >= 0 && time - seatHeard(slabGet(server.matches, server.waiting), 0) > timeout) {
+		endMatch(server, server.waiting);
+	}
+}
+
+//Fold the Last Period's Counters into the Stats Packet and Print it
+void updateStats(Server& server, StepPool& pool, double period)
+{
+	double busy = 0.0;
+	uint64_t noTicks = 0;
+	uint64_t noSent = 0;
+	for (Outbox& outbox : pool.outboxes) {
+		busy += outbox.busy;
+		noTicks += outbox.noTicks;
+		noSent += outbox.noSent;
+		outbox.busy = 0.0;
+		outbox.noTicks = 0;
+		outbox.noSent = 0;
+	}
+	server.noTicks += noTicks;
+
+	StatsPacket& stats = server.stats;
+	initNetHeader(stats.header, PACKET_STATS);
+	stats.noMatches = (uint32_t)server.running.size();
+	stats.noWaiting = (server.waiting >= 0 ? 1 : 0) + (uint32_t)server.pending.size();
+	stats.noThreads = (uint32_t)pool.outboxes.size();
+	stats.busyCores = (float)(busy / period);
+	stats.matchesPerCore = busy > 0.0 ? (float)(noTicks / busy / server.options.params.tickRate) : 0.0f;
+	stats.tickJitterMean = server.noRounds > 0 ? (float)(server.jitterSum / server.noRounds * 1e6) : 0.0f;
+	stats.tickJitterMax = (float)(server.jitterMax * 1e6);
+	stats.noOverruns = server.noOverruns;
+	stats.noTicks = server.noTicks;
+
+	std::cout << stats.noMatches << " matches, " << stats.busyCores << " cores busy, " << stats.matchesPerCore << " matches/core, jitter "
+		<< stats.tickJitterMean << " us mean " << stats.tickJitterMax << " us max, " << stats.noOverruns << " overruns, "
+		<< server.noReceived / period << " packets/s in, " << noSent / period << " out" << std::endl;
+
+	server.noReceived = 0;
+	server.jitterSum = 0.0;
+	server.jitterMax = 0.0;
+	server.noRounds = 0;
+}
+
+/* - Main - */
+
+volatile sig_atomic_t interrupted = 0;
+
+void onInterrupt(int)
+{
+	interrupted = 1;
+}
+
+bool openServer(Server& server)
+{
+	server.socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	int bufferSize = 8 << 20;
+	setsockopt(server.socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	setsockopt(server.socket, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(server.options.port);
+	if (server.socket < 0 || bind(server.socket, (const sockaddr*)&address, sizeof(address)) != 0) {
+		std::cout << "Could not bind UDP port " << server.options.port << ": " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	//Rounds on a Periodic Timer, so Late Rounds do not Push Back the Ones after them
+	double roundLength = (double)server.options.roundTicks / server.options.params.tickRate;
+	server.timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	itimerspec spec = {};
+	spec.it_interval.tv_sec = (time_t)roundLength;
+	spec.it_interval.tv_nsec = (long)((roundLength - (time_t)roundLength) * 1e9);
+	spec.it_value = spec.it_interval;
+	timerfd_settime(server.timer, 0, &spec, NULL);
+
+	server.epoll = epoll_create1(0);
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = server.socket;
+	epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.socket, &event);
+	event.data.fd = server.timer;
+	epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.timer, &event);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Server server;
+	ServerOptions& options = server.options;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+			options.port = (uint16_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			options.noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--round-ticks") == 0 && i + 1 < argc) {
+			options.roundTicks = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--snapshot-hz") == 0 && i + 1 < argc) {
+			options.snapshotHz = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+			options.noObstacles = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+			options.noBalls = std::max(1, std::min((int)MAX_BALLS, atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			options.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--fixed-point") == 0) {
+			options.params.fixedPoint = 1;
+		}
+		else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+			options.timeout = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			options.seconds = atof(argv[++i]);
+		}
+	}
+
+	genBrickLevel(server.level, options.noObstacles, options.params.arenaWidth, options.params.arenaHeight);
+	server.step = selectStepKernel(options.params, server.level, options.noBalls, false);
+	server.snapshotTicks = std::max(1u, options.params.tickRate / options.snapshotHz);
+	memset(&server.stats, 0, sizeof(server.stats));
+	initNetHeader(server.stats.header, PACKET_STATS);
+	if (!openServer(server)) {
+		return -1;
+	}
+
+	struct sigaction action = {};
+	action.sa_handler = onInterrupt;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	StepPool pool;
+	startPool(pool, server, options.noThreads);
+	std::cout << "Serving on UDP port " << options.port << " with " << options.noThreads << " threads, "
+		<< options.roundTicks << " ticks per round" << std::endl;
+
+	double roundLength = (double)options.roundTicks / options.params.tickRate;
+	double start = now();
+	double nextRound = start + roundLength;
+	double lastStats = start;
+	double lastHousekeeping = start;
+	epoll_event events[2];
+	while (!interrupted && (options.seconds <= 0.0 || now() - start < options.seconds)) {
+		int noEvents = epoll_wait(server.epoll, events, 2, 100);
+		for (int e = 0; e < noEvents; e++) {
+			if (events[e].data.fd == server.socket) {
+				drainSocket(server);
+				continue;
+			}
+
+			//Late Wake-Ups are the Jitter; Missed Rounds are Caught Up so Matches Keep Real Time
+			uint64_t noExpired = 0;
+			if (read(server.timer, &noExpired, sizeof(noExpired)) != sizeof(noExpired) || noExpired == 0) {
+				continue;
+			}
+			double time = now();
+			double late = time - (nextRound + (noExpired - 1) * roundLength);
+			nextRound += noExpired * roundLength;
+			server.jitterSum += late > 0.0 ? late : 0.0;
+			server.jitterMax = std::max(server.jitterMax, late);
+			server.noRounds++;
+			server.noOverruns += (uint32_t)(noExpired - 1);
+			runRound(pool, (uint32_t)noExpired * options.roundTicks);
+		}
+
+		double time = now();
+		if (time - lastHousekeeping >= 0.1) {
+			dropSilentMatches(server, time);
+			lastHousekeeping = time;
+		}
+		if (time - lastStats >= 1.0) {
+			updateStats(server, pool, time - lastStats);
+			lastStats = time;
+		}
+	}
+
+	stopPool(pool);
+	while (!server.running.empty()) {
+		endMatch(server, server.running.back());
+	}
+	while (!server.pending.empty()) {
+		endMatch(server, server.pending.back());
+	}
+	if (server.waiting >= 0) {
+		endMatch(server, server.waiting);
+	}
+	destroySlab(server.matches);
+	close(server.timer);
+	close(server.epoll);
+	close(server.socket);
+	return 0;
+}
@@ -0,0 +1,984 @@
+/*
+	Sharded batch runner across processes. A coordinator splits a batch of
+	bot matches into shards of consecutive match numbers, hands them to
+	worker processes over stream sockets, and writes the rallies they
+	stream back to a column store, as batch does in one process. Since
+	match i always draws the same random numbers, any worker can play any
+	shard, so a shard whose worker crashes or stalls is simply played again
+	elsewhere, and once none are left to hand out, idle workers back up the
+	slowest running ones, first to finish wins. Rows of a shard are kept
+	only once it is done, so the store never holds a shard twice or in part.
+	Linux only, no GL needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src shard.cpp -o shard
+
+	Usage: shard run <output dir> [options]
+		--matches N			matches to play, 1000 by default
+		--shard-matches N	matches per shard, 50 by default
+		--workers N			worker processes to launch here, 4 by default, 0 to wait for remote ones
+		--threads N			threads per launched worker, cores / workers by default
+		--listen A			socket path, or host:port for workers on other machines, /tmp/pong-shard-<pid>.sock by default
+		--timeout S			give a shard up when its worker makes no progress for S seconds, 10 by default
+		--seconds S, --obstacles N, --balls N, --seed N, --bot-noise U, --fixed-point as for batch
+		--crash-workers K	fault testing: the first K workers launched exit partway through their second shard
+		--slow-workers K	fault testing: the next K play a match only every 50 ms
+		--hang-workers K	fault testing: the next K stop making progress partway through their first shard
+
+	Usage: shard work <address> [--threads N]
+		Plays shards for the coordinator at address until it hangs up; run
+		launches these itself, start them by hand on other machines.
+
+	Every shard played is checksummed, and the sum over the batch is the
+	same whichever workers played it, so runs with and without faults can
+	be compared.
+*/
+
+#include "batch.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Protocol - */
+
+//Every Message is a Header and size Bytes of Payload, Little-Endian Structs as Both Ends are this Program
+const uint32_t SHARD_MAGIC = 0x44524853;	//"SHRD"
+const uint32_t SHARD_VERSION = 1;
+const uint32_t MAX_MESSAGE_SIZE = 1 << 20;
+const uint32_t ROWS_PER_MESSAGE = 4096;
+
+enum MessageType {
+	MESSAGE_HELLO = 1,		//Worker: HelloMessage, on Connecting
+	MESSAGE_CONFIG,			//Coordinator: ConfigMessage, Once
+	MESSAGE_ASSIGN,			//Coordinator: AssignMessage, to an Idle Worker
+	MESSAGE_CANCEL,			//Coordinator: Shard Number, another Worker Finished it First
+	MESSAGE_PROGRESS,		//Worker: ProgressMessage, Several Times a Second while Playing
+	MESSAGE_ROWS,			//Worker: Shard Number, then RallyRows
+	MESSAGE_DONE			//Worker: DoneMessage, after the Shard's Last Rows
+};
+
+struct MessageHeader {
+	uint32_t type;
+	uint32_t size;
+};
+
+struct HelloMessage {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t configSize;	//Catches Workers Built with Different Params
+	uint32_t noThreads;
+	uint32_t pid;
+};
+
+struct ConfigMessage {
+	BatchParams batch;
+	uint32_t noObstacles;
+};
+
+struct AssignMessage {
+	uint32_t shard;
+	uint32_t firstMatch;
+	uint32_t noMatches;
+};
+
+struct ProgressMessage {
+	uint32_t shard;
+	uint32_t matchesDone;
+};
+
+struct DoneMessage {
+	uint32_t shard;
+	uint32_t noMatches;
+	uint64_t noRows;
+	uint64_t checksum;
+};
+
+//Order Independent, so Threads and Workers can Finish Rows in any Order
+inline uint64_t checksumRows(const RallyRow* rows, size_t count)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t h = ((uint64_t)rows[i].match << 32) ^ rows[i].length;
+		h = hashMix(h ^ ((uint64_t)rows[i].hits << 40) ^ ((uint64_t)rows[i].hitOffset << 24) ^ ((uint64_t)rows[i].speed << 1) ^ rows[i].winner);
+		sum += h;
+	}
+	return sum;
+}
+
+/* - Sockets - */
+
+//A Path when address has a '/', else host:port over TCP; False with a Message if it does not Resolve
+bool parseAddress(const std::string& address, sockaddr_storage& addr, socklen_t& size)
+{
+	memset(&addr, 0, sizeof(addr));
+	if (address.find('/') != std::string::npos) {
+		sockaddr_un* un = (sockaddr_un*)&addr;
+		if (address.size() >= sizeof(un->sun_path)) {
+			std::cout << "Socket path too long: " << address << std::endl;
+			return false;
+		}
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, address.c_str());
+		size = sizeof(sockaddr_un);
+		return true;
+	}
+
+	size_t colon = address.rfind(':');
+	if (colon == std::string::npos) {
+		std::cout << "Expected a socket path or host:port, got " << address << std::endl;
+		return false;
+	}
+	std::string host = address.substr(0, colon);
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo* found = NULL;
+	if (getaddrinfo(host.empty() ? NULL : host.c_str(), address.c_str() + colon + 1, &hints, &found) != 0 || !found) {
+		std::cout << "Could not resolve " << address << std::endl;
+		return false;
+	}
+	memcpy(&addr, found->ai_addr, found->ai_addrlen);
+	size = found->ai_addrlen;
+	freeaddrinfo(found);
+	return true;
+}
+
+//Small Messages go Out at Once over TCP
+void setNoDelay(int fd, const sockaddr_storage& addr)
+{
+	if (addr.ss_family == AF_INET) {
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+}
+
+bool sendAll(int fd, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	while (size > 0) {
+		ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR) {
+			continue;
+		}
+		if (sent <= 0) {
+			return false;
+		}
+		bytes += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+bool recvAll(int fd, void* data, size_t size)
+{
+	uint8_t* bytes = (uint8_t*)data;
+	while (size > 0) {
+		ssize_t got = recv(fd, bytes, size, 0);
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		if (got <= 0) {
+			return false;
+		}
+		bytes += got;
+		size -= got;
+	}
+	return true;
+}
+
+//Header and Payload in One Send, so the Peer Never Waits on Half a Message
+bool sendMessage(int fd, uint32_t type, const void* payload, uint32_t size, const void* extra = NULL, uint32_t extraSize = 0)
+{
+	std::vector<uint8_t> message(sizeof(MessageHeader) + size + extraSize);
+	MessageHeader header = { type, size + extraSize };
+	memcpy(message.data(), &header, sizeof(header));
+	memcpy(message.data() + sizeof(header), payload, size);
+	if (extraSize > 0) {
+		memcpy(message.data() + sizeof(header) + size, extra, extraSize);
+	}
+	return sendAll(fd, message.data(), message.size());
+}
+
+//Blocking; False when the Peer has Gone or Sent Nonsense
+bool recvMessage(int fd, MessageHeader& header, std::vector<uint8_t>& payload)
+{
+	if (!recvAll(fd, &header, sizeof(header)) || header.size > MAX_MESSAGE_SIZE) {
+		return false;
+	}
+	payload.resize(header.size);
+	return recvAll(fd, payload.data(), header.size);
+}
+
+/* - Worker - */
+
+//Fault Injection for Testing the Coordinator on One Machine
+struct WorkerFaults {
+	uint32_t crashAfter = 0;	//Exit without a Word after this many Matches
+	uint32_t hangAfter = 0;		//Stop Playing after this many Matches, Staying Connected
+	uint32_t delayMs = 0;		//Sleep after every Match
+};
+
+struct ShardRun {
+	AssignMessage assign;
+	std::atomic<uint32_t> nextMatch;
+	std::atomic<uint32_t> matchesDone;
+	std::atomic<bool> cancelled;
+	std::mutex mutex;
+	std::vector<RallyRow> rows;		//Played but not yet Sent
+};
+
+std::atomic<uint32_t> noMatchesPlayed(0);
+
+void shardThread(ShardRun& run, const BatchParams& batch, const Level& level, const WorkerFaults& faults)
+{
+	std::vector<RallyRow> rows;
+	uint32_t i;
+	while (!run.cancelled && (i = run.nextMatch++) < run.assign.noMatches) {
+		playMatch(batch, level, run.assign.firstMatch + i, rows);
+		uint32_t played = ++noMatchesPlayed;
+		if (faults.crashAfter > 0 && played >= faults.crashAfter) {
+			_exit(3);
+		}
+		while (faults.hangAfter > 0 && played >= faults.hangAfter) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+		}
+		if (faults.delayMs > 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(faults.delayMs));
+		}
+		{
+			std::lock_guard<std::mutex> lock(run.mutex);
+			run.rows.insert(run.rows.end(), rows.begin(), rows.end());
+		}
+		rows.clear();
+		run.matchesDone++;
+	}
+}
+
+//Send what has been Played so far; False if the Coordinator has Gone
+bool sendRows(int fd, ShardRun& run, uint64_t& noRows, uint64_t& checksum)
+{
+	std::vector<RallyRow> rows;
+	{
+		std::lock_guard<std::mutex> lock(run.mutex);
+		rows.swap(run.rows);
+	}
+	noRows += rows.size();
+	checksum += checksumRows(rows.data(), rows.size());
+	for (size_t first = 0; first < rows.size(); first += ROWS_PER_MESSAGE) {
+		size_t count = std::min(rows.size() - first, (size_t)ROWS_PER_MESSAGE);
+		if (!sendMessage(fd, MESSAGE_ROWS, &run.assign.shard, sizeof(uint32_t), rows.data() + first, (uint32_t)(count * sizeof(RallyRow)))) {
+			return false;
+		}
+	}
+	ProgressMessage progress = { run.assign.shard, run.matchesDone };
+	return sendMessage(fd, MESSAGE_PROGRESS, &progress, sizeof(progress));
+}
+
+//Play a Shard, Streaming Rows and Listening for a Cancel; False if the Coordinator has Gone
+bool playShard(int fd, const AssignMessage& assign, const BatchParams& batch, const Level& level, uint32_t noThreads, const WorkerFaults& faults)
+{
+	ShardRun run;
+	run.assign = assign;
+	run.nextMatch = 0;
+	run.matchesDone = 0;
+	run.cancelled = false;
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < std::min(noThreads, assign.noMatches); t++) {
+		threads.push_back(std::thread(shardThread, std::ref(run), std::cref(batch), std::cref(level), std::cref(faults)));
+	}
+
+	bool connected = true;
+	uint64_t noRows = 0;
+	uint64_t checksum = 0;
+	while (connected && !run.cancelled && run.matchesDone < assign.noMatches) {
+		pollfd pfd = { fd, POLLIN, 0 };
+		if (poll(&pfd, 1, 100) > 0) {
+			MessageHeader header;
+			std::vector<uint8_t> payload;
+			if (!recvMessage(fd, header, payload)) {
+				connected = false;
+			}
+			else if (header.type == MESSAGE_CANCEL && payload.size() >= sizeof(uint32_t) && memcmp(payload.data(), &assign.shard, sizeof(uint32_t)) == 0) {
+				run.cancelled = true;
+			}
+		}
+		if (connected && !run.cancelled) {
+			connected = sendRows(fd, run, noRows, checksum);
+		}
+	}
+	run.cancelled = run.cancelled || !connected;
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	if (run.cancelled) {
+		return connected;
+	}
+
+	if (!sendRows(fd, run, noRows, checksum)) {
+		return false;
+	}
+	DoneMessage done = { assign.shard, assign.noMatches, noRows, checksum };
+	return sendMessage(fd, MESSAGE_DONE, &done, sizeof(done));
+}
+
+//Connect, Retrying for Ten Seconds in case the Coordinator is still Starting
+int connectWorker(const std::string& address)
+{
+	sockaddr_storage addr;
+	socklen_t size;
+	if (!parseAddress(address, addr, size)) {
+		return -1;
+	}
+	for (int attempt = 0; attempt < 100; attempt++) {
+		int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd >= 0 && connect(fd, (sockaddr*)&addr, size) == 0) {
+			setNoDelay(fd, addr);
+			return fd;
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	std::cout << "Could not connect to " << address << ": " << strerror(errno) << std::endl;
+	return -1;
+}
+
+int runWorker(const std::string& address, uint32_t noThreads, const WorkerFaults& faults)
+{
+	int fd = connectWorker(address);
+	if (fd < 0) {
+		return -1;
+	}
+	HelloMessage hello = { SHARD_MAGIC, SHARD_VERSION, (uint32_t)sizeof(ConfigMessage), noThreads, (uint32_t)getpid() };
+	MessageHeader header;
+	std::vector<uint8_t> payload;
+	ConfigMessage config;
+	if (!sendMessage(fd, MESSAGE_HELLO, &hello, sizeof(hello)) || !recvMessage(fd, header, payload) ||
+		header.type != MESSAGE_CONFIG || payload.size() != sizeof(ConfigMessage)) {
+		std::cout << "Worker " << getpid() << " was turned away by " << address << std::endl;
+		close(fd);
+		return -1;
+	}
+	memcpy(&config, payload.data(), sizeof(config));
+	Level level;
+	genBrickLevel(level, config.noObstacles, config.batch.sim.arenaWidth, config.batch.sim.arenaHeight);
+
+	//Shards until the Coordinator Hangs Up; Cancels for Shards Already Finished are Stale
+	while (recvMessage(fd, header, payload)) {
+		if (header.type == MESSAGE_ASSIGN && payload.size() == sizeof(AssignMessage)) {
+			AssignMessage assign;
+			memcpy(&assign, payload.data(), sizeof(assign));
+			if (!playShard(fd, assign, config.batch, level, noThreads, faults)) {
+				break;
+			}
+		}
+	}
+	close(fd);
+	return 0;
+}
+
+/* - Coordinator - */
+
+struct Shard {
+	uint32_t firstMatch;
+	uint32_t noMatches;
+	uint32_t noRunning = 0;		//Workers Playing it Now
+	uint32_t noAttempts = 0;
+	bool done = false;
+};
+
+struct Worker {
+	int fd = -1;
+	pid_t pid = 0;				//Launched Here, else Remote
+	uint32_t remotePid = 0;
+	bool ready = false;			//Said Hello and was Sent the Config
+	std::vector<uint8_t> inbox;
+	int32_t shard = -1;			//Playing, or -1 when Idle
+	bool backup = false;		//Playing a Shard Someone else was already Playing
+	uint32_t matchesDone = 0;
+	double started = 0.0;
+	double lastProgress = 0.0;
+	std::vector<RallyRow> rows;	//Current Shard's Rows so far
+	uint64_t checksum = 0;
+	uint32_t noShardsDone = 0;
+};
+
+struct CoordinatorStats {
+	uint32_t noShardsDone = 0;
+	uint32_t noRequeued = 0;	//Shards Handed Out Again after a Worker Crashed or Stalled
+	uint32_t noBackups = 0;
+	uint32_t noBackupsWon = 0;
+	uint32_t noLost = 0;		//Workers Crashed, Stalled or Disconnected
+	uint32_t noLaunched = 0;
+	double shardSeconds = 0.0;	//Summed over Finished Shards, for Judging Stragglers
+	uint64_t noMatchesDone = 0;
+	uint64_t checksum = 0;
+};
+
+struct Coordinator {
+	std::string address;
+	int listener = -1;
+	ConfigMessage config;
+	std::vector<Shard> shards;
+	std::vector<Worker> workers;
+	RallyStore store;
+	CoordinatorStats stats;
+	double timeout = 10.0;
+	uint32_t noLocal = 0;		//Local Workers Wanted Running
+	uint32_t threadsPerWorker = 1;
+	uint32_t noCrashWorkers = 0;
+	uint32_t noSlowWorkers = 0;
+	uint32_t noHangWorkers = 0;
+};
+
+//Straggler Backups Start once a Shard has Run this many Times the Mean Shard Time
+const double BACKUP_FACTOR = 2.0;
+
+bool listenCoordinator(Coordinator& coord)
+{
+	sockaddr_storage addr;
+	socklen_t size;
+	if (!parseAddress(coord.address, addr, size)) {
+		return false;
+	}
+	if (addr.ss_family == AF_UNIX) {
+		unlink(coord.address.c_str());
+	}
+	coord.listener = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	int one = 1;
+	setsockopt(coord.listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (coord.listener < 0 || bind(coord.listener, (sockaddr*)&addr, size) != 0 || listen(coord.listener, 64) != 0) {
+		std::cout << "Could not listen on " << coord.address << ": " << strerror(errno) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//Fork and Exec this Program as a Worker; Fault Flags go to the First Few Launched
+void launchWorker(Coordinator& coord)
+{
+	uint32_t n = coord.stats.noLaunched++;
+	std::vector<std::string> args = { "shard", "work", coord.address, "--threads", std::to_string(coord.threadsPerWorker) };
+	uint32_t shardMatches = coord.shards.empty() ? 1 : coord.shards[0].noMatches;
+	if (n < coord.noCrashWorkers) {
+		args.insert(args.end(), { "--crash-after", std::to_string(shardMatches + shardMatches / 2 + 1) });
+	}
+	else if (n < coord.noCrashWorkers + coord.noSlowWorkers) {
+		args.insert(args.end(), { "--delay-ms", "50" });
+	}
+	else if (n < coord.noCrashWorkers + coord.noSlowWorkers + coord.noHangWorkers) {
+		args.insert(args.end(), { "--hang-after", std::to_string(shardMatches / 2 + 1) });
+	}
+	std::vector<char*> argv;
+	for (std::string& arg : args) {
+		argv.push_back(&arg[0]);
+	}
+	argv.push_back(NULL);
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		execv("/proc/self/exe", argv.data());
+		_exit(127);
+	}
+	if (pid < 0) {
+		std::cout << "Could not launch a worker: " << strerror(errno) << std::endl;
+		return;
+	}
+
+	//Known by pid until it Connects and Says Hello
+	Worker worker;
+	worker.pid = pid;
+	worker.lastProgress = now();
+	coord.workers.push_back(worker);
+}
+
+//Hand the Worker's Shard Back unless Someone else is still Playing it, then Forget the Worker
+void dropWorker(Coordinator& coord, size_t index, const char* reason)
+{
+	Worker& worker = coord.workers[index];
+	if (worker.shard >= 0) {
+		Shard& shard = coord.shards[worker.shard];
+		shard.noRunning--;
+		if (!shard.done && shard.noRunning == 0) {
+			coord.stats.noRequeued++;
+		}
+		std::cout << "Worker " << (worker.pid ? worker.pid : worker.remotePid) << " " << reason << " on shard " << worker.shard << " ("
+			<< worker.matchesDone << "/" << shard.noMatches << " matches), " << (shard.noRunning > 0 ? "its backup carries on" : "handing it out again") << std::endl;
+	}
+	else {
+		std::cout << "Worker " << (worker.pid ? worker.pid : worker.remotePid) << " " << reason << (worker.ready ? " while idle" : " before starting") << std::endl;
+	}
+	coord.stats.noLost++;
+	if (worker.fd >= 0) {
+		close(worker.fd);
+	}
+	if (worker.pid > 0) {
+		kill(worker.pid, SIGKILL);
+		waitpid(worker.pid, NULL, 0);
+	}
+	coord.workers[index] = std::move(coord.workers.back());
+	coord.workers.pop_back();
+}
+
+void assignShard(Coordinator& coord, Worker& worker, uint32_t index, bool backup)
+{
+	Shard& shard = coord.shards[index];
+	AssignMessage assign = { index, shard.firstMatch, shard.noMatches };
+	if (!sendMessage(worker.fd, MESSAGE_ASSIGN, &assign, sizeof(assign))) {
+		return;
+	}
+	shard.noRunning++;
+	shard.noAttempts++;
+	worker.shard = index;
+	worker.backup = backup;
+	worker.matchesDone = 0;
+	worker.started = now();
+	worker.lastProgress = worker.started;
+	worker.rows.clear();
+	worker.checksum = 0;
+	coord.stats.noBackups += backup;
+}
+
+//Idle Workers take the Lowest Shard Nobody is Playing, or else Back Up the Furthest Behind Straggler
+void assignShards(Coordinator& coord)
+{
+	double meanShard = coord.stats.noShardsDone > 0 ? coord.stats.shardSeconds / coord.stats.noShardsDone : 0.0;
+	uint32_t next = 0;
+	for (Worker& worker : coord.workers) {
+		if (!worker.ready || worker.shard >= 0) {
+			continue;
+		}
+		while (next < coord.shards.size() && (coord.shards[next].done || coord.shards[next].noRunning > 0)) {
+			next++;
+		}
+		if (next < coord.shards.size()) {
+			assignShard(coord, worker, next, false);
+			continue;
+		}
+		if (meanShard <= 0.0) {
+			continue;
+		}
+
+		const Worker* slowest = NULL;
+		double slowestShare = 1.0;
+		for (const Worker& other : coord.workers) {
+			if (other.shard < 0 || coord.shards[other.shard].noRunning > 1 || now() - other.started < BACKUP_FACTOR * meanShard) {
+				continue;
+			}
+			double share = (double)other.matchesDone / coord.shards[other.shard].noMatches;
+			if (share < slowestShare) {
+				slowest = &other;
+				slowestShare = share;
+			}
+		}
+		if (slowest) {
+			assignShard(coord, worker, slowest->shard, true);
+		}
+	}
+}
+
+//A Shard's Rows go to the Store Once, from whichever Worker Finished it First; the Rest are Cancelled
+void finishShard(Coordinator& coord, Worker& worker, const DoneMessage& done)
+{
+	Shard& shard = coord.shards[done.shard];
+	shard.noRunning--;
+	worker.shard = -1;
+	if (shard.done) {
+		return;
+	}
+	if (done.noRows != worker.rows.size() || done.checksum != worker.checksum || done.noMatches != shard.noMatches) {
+		std::cout << "Shard " << done.shard << " arrived damaged from worker " << worker.remotePid << ", handing it out again" << std::endl;
+		coord.stats.noRequeued += shard.noRunning == 0;
+		worker.rows.clear();
+		return;
+	}
+
+	shard.done = true;
+	coord.stats.noShardsDone++;
+	coord.stats.noBackupsWon += worker.backup;
+	coord.stats.shardSeconds += now() - worker.started;
+	coord.stats.noMatchesDone += shard.noMatches;
+	coord.stats.checksum += worker.checksum;
+	appendRallies(coord.store, worker.rows);
+	worker.noShardsDone++;
+
+	for (Worker& other : coord.workers) {
+		if (other.shard == (int32_t)done.shard) {
+			sendMessage(other.fd, MESSAGE_CANCEL, &done.shard, sizeof(uint32_t));
+			other.shard = -1;
+			other.rows.clear();
+			shard.noRunning--;
+		}
+	}
+}
+
+//False if the Worker Broke the Protocol
+bool handleMessage(Coordinator& coord, Worker& worker, const MessageHeader& header, const uint8_t* payload)
+{
+	if (!worker.ready) {
+		HelloMessage hello;
+		if (header.type != MESSAGE_HELLO || header.size != sizeof(hello)) {
+			return false;
+		}
+		memcpy(&hello, payload, sizeof(hello));
+		if (hello.magic != SHARD_MAGIC || hello.version != SHARD_VERSION || hello.configSize != sizeof(ConfigMessage)) {
+			std::cout << "Turned away a worker of a different build" << std::endl;
+			return false;
+		}
+		worker.remotePid = hello.pid;
+		worker.ready = sendMessage(worker.fd, MESSAGE_CONFIG, &coord.config, sizeof(coord.config));
+		return worker.ready;
+	}
+
+	//Rows and Progress for a Shard the Worker was Cancelled from are in Flight; Dropped
+	uint32_t shard;
+	if (header.size < sizeof(uint32_t)) {
+		return false;
+	}
+	memcpy(&shard, payload, sizeof(uint32_t));
+	bool current = worker.shard == (int32_t)shard;
+	if (header.type == MESSAGE_ROWS) {
+		uint32_t count = (header.size - sizeof(uint32_t)) / sizeof(RallyRow);
+		if (current) {
+			const RallyRow* rows = (const RallyRow*)(payload + sizeof(uint32_t));
+			worker.rows.insert(worker.rows.end(), rows, rows + count);
+			worker.checksum += checksumRows(rows, count);
+		}
+	}
+	else if (header.type == MESSAGE_PROGRESS && header.size == sizeof(ProgressMessage)) {
+		ProgressMessage progress;
+		memcpy(&progress, payload, sizeof(progress));
+		if (current && progress.matchesDone > worker.matchesDone) {
+			worker.matchesDone = progress.matchesDone;
+			worker.lastProgress = now();
+		}
+	}
+	else if (header.type == MESSAGE_DONE && header.size == sizeof(DoneMessage)) {
+		DoneMessage done;
+		memcpy(&done, payload, sizeof(done));
+		if (current) {
+			finishShard(coord, worker, done);
+		}
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+//Drain the Socket and Handle every Whole Message; False when the Worker has Gone or Broken the Protocol
+bool readWorker(Coordinator& coord, Worker& worker)
+{
+	uint8_t buffer[65536];
+	while (true) {
+		ssize_t got = recv(worker.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (got > 0) {
+			worker.inbox.insert(worker.inbox.end(), buffer, buffer + got);
+			continue;
+		}
+		if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		return false;
+	}
+
+	size_t used = 0;
+	bool ok = true;
+	while (ok && worker.inbox.size() - used >= sizeof(MessageHeader)) {
+		MessageHeader header;
+		memcpy(&header, worker.inbox.data() + used, sizeof(header));
+		if (header.size > MAX_MESSAGE_SIZE) {
+			return false;
+		}
+		if (worker.inbox.size() - used < sizeof(header) + header.size) {
+			break;
+		}
+		ok = handleMessage(coord, worker, header, worker.inbox.data() + used + sizeof(header));
+		used += sizeof(header) + header.size;
+	}
+	worker.inbox.erase(worker.inbox.begin(), worker.inbox.begin() + used);
+	return ok;
+}
+
+//Accepted Sockets Belong to the Launched Worker with that pid when there is One
+void acceptWorkers(Coordinator& coord)
+{
+	int fd;
+	while ((fd = accept4(coord.listener, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+		Worker worker;
+		worker.fd = fd;
+		worker.lastProgress = now();
+		coord.workers.push_back(worker);
+	}
+}
+
+//Launched Workers are Matched to their Sockets by the pid they Say Hello with
+void matchLaunched(Coordinator& coord)
+{
+	for (size_t i = 0; i < coord.workers.size(); i++) {
+		Worker& worker = coord.workers[i];
+		if (worker.fd < 0 || worker.pid != 0 || !worker.ready) {
+			continue;
+		}
+		for (size_t j = 0; j < coord.workers.size(); j++) {
+			if (coord.workers[j].fd < 0 && coord.workers[j].pid == (pid_t)worker.remotePid) {
+				worker.pid = coord.workers[j].pid;
+				coord.workers[j] = std::move(coord.workers.back());
+				coord.workers.pop_back();
+				break;
+			}
+		}
+	}
+}
+
+uint32_t countLocal(const Coordinator& coord)
+{
+	uint32_t count = 0;
+	for (const Worker& worker : coord.workers) {
+		count += worker.pid > 0;
+	}
+	return count;
+}
+
+int runCoordinator(Coordinator& coord, const std::string& dir)
+{
+	if (!listenCoordinator(coord) || !openRallyStore(coord.store, dir)) {
+		return -1;
+	}
+	for (uint32_t i = 0; i < coord.noLocal; i++) {
+		launchWorker(coord);
+	}
+	std::cout << coord.shards.size() << " shards of " << coord.shards[0].noMatches << " matches on " << coord.address << ", "
+		<< coord.noLocal << " local workers of " << coord.threadsPerWorker << " threads" << std::endl;
+
+	//Lost Local Workers are Replaced, within Reason
+	uint32_t maxLaunches = coord.noLocal * 4;
+	double start = now();
+	std::vector<pollfd> pfds;
+	while (coord.stats.noShardsDone < coord.shards.size()) {
+		assignShards(coord);
+
+		pfds.clear();
+		pfds.push_back({ coord.listener, POLLIN, 0 });
+		for (const Worker& worker : coord.workers) {
+			pfds.push_back({ worker.fd, POLLIN, 0 });
+		}
+		poll(pfds.data(), pfds.size(), 100);
+
+		if (pfds[0].revents & POLLIN) {
+			acceptWorkers(coord);
+		}
+		for (size_t i = pfds.size() - 1; i >= 1; i--) {
+			if (pfds[i].fd >= 0 && (pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !readWorker(coord, coord.workers[i - 1])) {
+				dropWorker(coord, i - 1, "disconnected");
+			}
+		}
+		matchLaunched(coord);
+
+		//Playing but Stuck, or Launched and Never Said Hello
+		double time = now();
+		for (size_t i = coord.workers.size(); i-- > 0;) {
+			const Worker& worker = coord.workers[i];
+			if ((worker.shard >= 0 || !worker.ready) && time - worker.lastProgress > coord.timeout) {
+				dropWorker(coord, i, "stalled");
+			}
+		}
+
+		//Launched Workers that Exited before Connecting
+		for (size_t i = coord.workers.size(); i-- > 0;) {
+			pid_t pid = coord.workers[i].pid;
+			if (coord.workers[i].fd < 0 && waitpid(pid, NULL, WNOHANG) == pid) {
+				coord.workers[i].pid = 0;
+				coord.workers[i].remotePid = pid;
+				dropWorker(coord, i, "exited");
+			}
+		}
+		while (countLocal(coord) < coord.noLocal && coord.stats.noLaunched < maxLaunches) {
+			launchWorker(coord);
+		}
+		if (coord.noLocal > 0 && coord.workers.empty()) {
+			std::cout << "Every worker failed, giving up" << std::endl;
+			break;
+		}
+	}
+	double elapsed = now() - start;
+
+	//Workers Exit when Hung Up on; Hung Ones are Killed
+	for (Worker& worker : coord.workers) {
+		if (worker.fd >= 0) {
+			close(worker.fd);
+		}
+	}
+	for (Worker& worker : coord.workers) {
+		if (worker.pid <= 0) {
+			continue;
+		}
+		double deadline = now() + 2.0;
+		while (waitpid(worker.pid, NULL, WNOHANG) == 0 && now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		if (now() >= deadline) {
+			kill(worker.pid, SIGKILL);
+			waitpid(worker.pid, NULL, 0);
+		}
+	}
+	close(coord.listener);
+	if (coord.address.find('/') != std::string::npos) {
+		unlink(coord.address.c_str());
+	}
+
+	bool complete = coord.stats.noShardsDone == coord.shards.size();
+	if (!closeRallyStore(coord.store)) {
+		std::cout << "Could not write the rally store in " << dir << std::endl;
+		return -1;
+	}
+
+	const CoordinatorStats& stats = coord.stats;
+	const BatchParams& batch = coord.config.batch;
+	double matchTime = (double)stats.noMatchesDone * batch.noTicks / batch.sim.tickRate;
+	std::cout << stats.noMatchesDone << " matches, " << coord.store.noRows << " rallies in " << elapsed << " s, " << matchTime / elapsed
+		<< "x real time, checksum " << std::hex << stats.checksum << std::dec << std::endl;
+	std::cout << stats.noLaunched << " workers launched, " << stats.noLost << " lost, " << stats.noRequeued << " shards handed out again, "
+		<< stats.noBackups << " backups (" << stats.noBackupsWon << " finished first)" << std::endl;
+	return complete ? 0 : -1;
+}
+
+/* - Main - */
+
+void printUsage()
+{
+	std::cout << "Usage: shard run <output dir> [--matches N] [--shard-matches N] [--workers N] [--threads N] [--listen A] [--timeout S]" << std::endl
+		<< "	[--seconds S] [--obstacles N] [--balls N] [--seed N] [--bot-noise U] [--fixed-point]" << std::endl
+		<< "	[--crash-workers K] [--slow-workers K] [--hang-workers K]" << std::endl
+		<< "       shard work <address> [--threads N]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		printUsage();
+		return -1;
+	}
+
+	if (strcmp(argv[1], "work") == 0) {
+		uint32_t noThreads = std::max(1u, std::thread::hardware_concurrency());
+		WorkerFaults faults;
+		for (int i = 3; i < argc; i++) {
+			if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+				noThreads = std::max(1, atoi(argv[++i]));
+			}
+			else if (strcmp(argv[i], "--crash-after") == 0 && i + 1 < argc) {
+				faults.crashAfter = atoi(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--hang-after") == 0 && i + 1 < argc) {
+				faults.hangAfter = atoi(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--delay-ms") == 0 && i + 1 < argc) {
+				faults.delayMs = atoi(argv[++i]);
+			}
+		}
+		return runWorker(argv[2], noThreads, faults);
+	}
+	if (strcmp(argv[1], "run") != 0) {
+		printUsage();
+		return -1;
+	}
+
+	Coordinator coord;
+	BatchParams& batch = coord.config.batch;
+	coord.config.noObstacles = 0;
+	coord.address = "/tmp/pong-shard-" + std::to_string(getpid()) + ".sock";
+	coord.noLocal = 4;
+	uint32_t noMatches = 1000;
+	uint32_t shardMatches = 50;
+	uint32_t noThreads = 0;
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+			noMatches = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--shard-matches") == 0 && i + 1 < argc) {
+			shardMatches = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+			coord.noLocal = std::max(0, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+			coord.address = argv[++i];
+		}
+		else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+			coord.timeout = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			batch.noTicks = (uint64_t)(atof(argv[++i]) * batch.sim.tickRate);
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+			coord.config.noObstacles = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+			batch.noBalls = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			batch.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--fixed-point") == 0) {
+			batch.sim.fixedPoint = 1;
+		}
+		else if (strcmp(argv[i], "--bot-noise") == 0 && i + 1 < argc) {
+			batch.bot.aimNoise = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--crash-workers") == 0 && i + 1 < argc) {
+			coord.noCrashWorkers = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--slow-workers") == 0 && i + 1 < argc) {
+			coord.noSlowWorkers = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--hang-workers") == 0 && i + 1 < argc) {
+			coord.noHangWorkers = atoi(argv[++i]);
+		}
+	}
+	uint32_t noCores = std::max(1u, std::thread::hardware_concurrency());
+	coord.threadsPerWorker = noThreads > 0 ? noThreads : std::max(1u, noCores / std::max(1u, coord.noLocal));
+
+	for (uint32_t first = 0; first < noMatches; first += shardMatches) {
+		Shard shard;
+		shard.firstMatch = first;
+		shard.noMatches = std::min(shardMatches, noMatches - first);
+		coord.shards.push_back(shard);
+	}
+
+	//Workers Killed Mid-Write Must not Take the Coordinator with them
+	signal(SIGPIPE, SIG_IGN);
+	return runCoordinator(coord, argv[2]);
+}
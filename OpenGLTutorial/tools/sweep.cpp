@@ -0,0 +1,428 @@
+/*
+	Monte Carlo parameter sweep for game balancing: plays many bot against
+	bot matches for each parameter set and reports rally length and win
+	rates with 95% confidence intervals. No GL needed:
+
+		g++ -std=c++14 -O2 -pthread -I../src sweep.cpp -o sweep
+
+	Usage: sweep <results.csv> [options]
+		--grid N				N evenly spaced values per parameter (default, 4)
+		--lhs N					N Latin hypercube samples instead of a grid
+		--paddle-speed LO HI	range swept, 100 to 300 by default
+		--paddle-height LO HI	range swept, 60 to 140 by default
+		--ball-speed LO HI		range swept, 200 to 450 by default
+		--matches N				matches per set, 1000 by default
+		--seconds S				length of each match, 60 by default
+		--threads N				worker threads, one per core by default
+		--seed N				seeds both the sampling and the matches
+		--fixed-point			step the simulation in Q16.16, the same on every build
+		--bot-noise U			largest bot aim error in arena units, 0 by default
+
+	Each set is appended to the CSV as soon as it finishes. Rerunning with
+	the same options skips the sets already in the file, so an interrupted
+	sweep resumes where it stopped. The first line is a # comment with the
+	options every set shares; a resume with different ones is refused. Every set plays the same match seeds,
+	so differences between sets come from the parameters, not the serves.
+*/
+
+#include "batch.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* - Timing - */
+
+double now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* - Parameter Sets - */
+
+const uint32_t NO_SWEEP_PARAMS = 3;
+const char* const SWEEP_PARAMS[NO_SWEEP_PARAMS] = { "paddleSpeed", "paddleHeight", "ballSpeed" };
+
+struct SweepRange {
+	float lo;
+	float hi;
+};
+
+struct SweepSet {
+	float values[NO_SWEEP_PARAMS];
+};
+
+//Write a Set's Values into the Simulation Parameters
+void applySweepSet(const SweepSet& set, SimParams& params)
+{
+	params.paddleSpeed = set.values[0];
+	params.paddleHeight = set.values[1];
+	params.ballSpeed = set.values[2];
+}
+
+//Every Combination of n Evenly Spaced Values, First Parameter Varying Slowest
+std::vector<SweepSet> gridSets(const SweepRange* ranges, uint32_t n)
+{
+	std::vector<SweepSet> sets;
+	uint32_t total = 1;
+	for (uint32_t p = 0; p < NO_SWEEP_PARAMS; p++) {
+		total *= n;
+	}
+	for (uint32_t i = 0; i < total; i++) {
+		SweepSet set;
+		uint32_t rest = i;
+		for (int p = NO_SWEEP_PARAMS - 1; p >= 0; p--) {
+			uint32_t step = rest % n;
+			rest /= n;
+			float t = n > 1 ? (float)step / (n - 1) : 0.5f;
+			set.values[p] = ranges[p].lo + t * (ranges[p].hi - ranges[p].lo);
+		}
+		sets.push_back(set);
+	}
+	return sets;
+}
+
+//SplitMix64, only for Placing Samples; the Matches have their own Seeds
+uint64_t splitMix(uint64_t& state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+//n Samples with Exactly One in each of the n Strata of every Parameter
+std::vector<SweepSet> latinHypercubeSets(const SweepRange* ranges, uint32_t n, uint64_t seed)
+{
+	std::vector<SweepSet> sets(n);
+	uint64_t rng = seed;
+	for (uint32_t p = 0; p < NO_SWEEP_PARAMS; p++) {
+		std::vector<uint32_t> strata(n);
+		for (uint32_t i = 0; i < n; i++) {
+			strata[i] = i;
+		}
+		for (uint32_t i = n - 1; i > 0; i--) {
+			std::swap(strata[i], strata[splitMix(rng) % (i + 1)]);
+		}
+		for (uint32_t i = 0; i < n; i++) {
+			double jitter = (splitMix(rng) >> 11) * (1.0 / 9007199254740992.0);
+			double t = (strata[i] + jitter) / n;
+			sets[i].values[p] = (float)(ranges[p].lo + t * (ranges[p].hi - ranges[p].lo));
+		}
+	}
+	return sets;
+}
+
+/* - Statistics - */
+
+//Sums over Matches, Merged across Workers
+struct SweepTally {
+	uint64_t noMatches = 0;
+	uint64_t noRallies = 0;
+	uint64_t noRallyMatches = 0;	//Matches with a Finished Rally, a Rally can Outlast the Match
+	double rallySum = 0.0;			//Per-Match Mean Rally Length, Seconds
+	double rallySumSq = 0.0;
+	uint64_t points[2] = { 0, 0 };
+	uint64_t matchWins[2] = { 0, 0 };
+};
+
+void mergeTally(SweepTally& into, const SweepTally& from)
+{
+	into.noMatches += from.noMatches;
+	into.noRallies += from.noRallies;
+	into.noRallyMatches += from.noRallyMatches;
+	into.rallySum += from.rallySum;
+	into.rallySumSq += from.rallySumSq;
+	for (int i = 0; i < 2; i++) {
+		into.points[i] += from.points[i];
+		into.matchWins[i] += from.matchWins[i];
+	}
+}
+
+//Wilson Score Interval for a Proportion, 95%
+void wilsonInterval(uint64_t successes, uint64_t trials, double& lo, double& hi)
+{
+	if (trials == 0) {
+		lo = 0.0;
+		hi = 1.0;
+		return;
+	}
+	const double z = 1.96;
+	double n = (double)trials;
+	double p = successes / n;
+	double centre = (p + z * z / (2.0 * n)) / (1.0 + z * z / n);
+	double half = z * sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / (1.0 + z * z / n);
+	lo = centre - half;
+	hi = centre + half;
+}
+
+/* - Workers - */
+
+//Play Matches of one Set until None are Left
+void sweepWorker(const BatchParams& batch, const Level& level, std::atomic<uint32_t>& nextMatch, uint32_t noMatches, SweepTally& tally)
+{
+	std::vector<RallyRow> rows;
+	uint32_t match;
+	while ((match = nextMatch++) < noMatches) {
+		rows.clear();
+		playMatch(batch, level, match, rows);
+
+		uint64_t points[2] = { 0, 0 };
+		uint64_t ticks = 0;
+		for (const RallyRow& row : rows) {
+			points[row.winner]++;
+			ticks += row.length;
+		}
+
+		//Matches are the Independent Samples, so Rally Length is Averaged per Match First
+		tally.noMatches++;
+		tally.noRallies += rows.size();
+		if (!rows.empty()) {
+			double meanRally = (double)ticks / rows.size() / batch.sim.tickRate;
+			tally.noRallyMatches++;
+			tally.rallySum += meanRally;
+			tally.rallySumSq += meanRally * meanRally;
+		}
+		tally.points[0] += points[0];
+		tally.points[1] += points[1];
+		if (points[0] != points[1]) {
+			tally.matchWins[points[0] > points[1] ? 0 : 1]++;
+		}
+	}
+}
+
+/* - Results File - */
+
+const char* SWEEP_CSV_HEADER = "set,paddleSpeed,paddleHeight,ballSpeed,matches,rallies,"
+	"rallySeconds,rallySecondsLo,rallySecondsHi,p0PointRate,p0PointRateLo,p0PointRateHi,"
+	"p0MatchRate,p0MatchRateLo,p0MatchRateHi";
+
+//Comment Line Recording the Options that Shape every Set's Results but are not Swept
+std::string sweepOptionsLine(const BatchParams& batch, uint32_t noMatches)
+{
+	char line[256];
+	snprintf(line, sizeof(line), "# matches %u, seed %llu, ticks %llu, bot noise %.9g, fixed point %u", noMatches,
+		(unsigned long long)batch.seed, (unsigned long long)batch.noTicks, batch.bot.aimNoise, (uint32_t)batch.sim.fixedPoint);
+	return line;
+}
+
+//Sets Already in the File, Checked against the Options and Sets about to Run so a Resume Cannot Mix Sweeps
+bool readFinishedSets(const char* path, const std::string& options, const std::vector<SweepSet>& sets, std::vector<bool>& finished)
+{
+	finished.assign(sets.size(), false);
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		return true;
+	}
+	std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	//Only Lines Ending in a Newline were Written Whole; a Cut Off Last Line is Trimmed Later and its Set Played Again
+	size_t end = contents.find_last_of('\n');
+	if (end == std::string::npos) {
+		return true;
+	}
+	std::istringstream file(contents.substr(0, end + 1));
+
+	std::string line;
+	std::getline(file, line);
+	if (line != options) {
+		std::cout << path << " was written by a sweep with different options:" << std::endl << "  " << line << std::endl
+			<< "this sweep has" << std::endl << "  " << options << std::endl;
+		return false;
+	}
+	std::getline(file, line);
+	while (std::getline(file, line)) {
+		std::istringstream in(line);
+		std::string field;
+		std::vector<std::string> fields;
+		while (std::getline(in, field, ',')) {
+			fields.push_back(field);
+		}
+		if (fields.size() != 15) {
+			std::cout << path << " has a malformed line: " << line << std::endl;
+			return false;
+		}
+
+		uint32_t set = (uint32_t)strtoul(fields[0].c_str(), NULL, 10);
+		if (set >= sets.size()) {
+			std::cout << path << " has set " << set << ", this sweep only has " << sets.size() << std::endl;
+			return false;
+		}
+		for (uint32_t p = 0; p < NO_SWEEP_PARAMS; p++) {
+			if (fabs(atof(fields[1 + p].c_str()) - sets[set].values[p]) > 1e-3 * (1.0 + fabs(sets[set].values[p]))) {
+				std::cout << path << " was written by a sweep with different options, set " << set << " differs" << std::endl;
+				return false;
+			}
+		}
+		finished[set] = true;
+	}
+	return true;
+}
+
+//Cut a Trailing Partial Line so Appended Sets Start on their Own Line
+void trimPartialLine(const char* path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		return;
+	}
+	std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+	size_t end = contents.find_last_of('\n');
+	if (end + 1 != contents.size()) {
+		contents.resize(end == std::string::npos ? 0 : end + 1);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out << contents;
+	}
+}
+
+/* - Main - */
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cout << "Usage: sweep <results.csv> [--grid N | --lhs N] [--paddle-speed LO HI] [--paddle-height LO HI] [--ball-speed LO HI]" << std::endl;
+		std::cout << "       [--matches N] [--seconds S] [--threads N] [--seed N] [--bot-noise U] [--fixed-point]" << std::endl;
+		return -1;
+	}
+
+	const char* path = argv[1];
+	SweepRange ranges[NO_SWEEP_PARAMS] = { { 100.0f, 300.0f }, { 60.0f, 140.0f }, { 200.0f, 450.0f } };
+	uint32_t gridSize = 4;
+	uint32_t noSamples = 0;
+	uint32_t noMatches = 1000;
+	uint32_t noThreads = std::max(1u, std::thread::hardware_concurrency());
+	BatchParams batch;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+			gridSize = std::max(1, atoi(argv[++i]));
+			noSamples = 0;
+		}
+		else if (strcmp(argv[i], "--lhs") == 0 && i + 1 < argc) {
+			noSamples = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--paddle-speed") == 0 && i + 2 < argc) {
+			ranges[0] = { (float)atof(argv[i + 1]), (float)atof(argv[i + 2]) };
+			i += 2;
+		}
+		else if (strcmp(argv[i], "--paddle-height") == 0 && i + 2 < argc) {
+			ranges[1] = { (float)atof(argv[i + 1]), (float)atof(argv[i + 2]) };
+			i += 2;
+		}
+		else if (strcmp(argv[i], "--ball-speed") == 0 && i + 2 < argc) {
+			ranges[2] = { (float)atof(argv[i + 1]), (float)atof(argv[i + 2]) };
+			i += 2;
+		}
+		else if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+			noMatches = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			batch.noTicks = (uint64_t)(atof(argv[++i]) * batch.sim.tickRate);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			noThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			batch.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--fixed-point") == 0) {
+			batch.sim.fixedPoint = 1;
+		}
+		else if (strcmp(argv[i], "--bot-noise") == 0 && i + 1 < argc) {
+			batch.bot.aimNoise = (float)atof(argv[++i]);
+		}
+	}
+
+	std::vector<SweepSet> sets = noSamples > 0 ? latinHypercubeSets(ranges, noSamples, batch.seed) : gridSets(ranges, gridSize);
+	std::string options = sweepOptionsLine(batch, noMatches);
+	std::vector<bool> finished;
+	if (!readFinishedSets(path, options, sets, finished)) {
+		return -1;
+	}
+	uint32_t noFinished = 0;
+	for (bool done : finished) {
+		noFinished += done ? 1 : 0;
+	}
+	if (noFinished > 0) {
+		std::cout << "Resuming, " << noFinished << " of " << sets.size() << " sets already in " << path << std::endl;
+	}
+
+	trimPartialLine(path);
+	std::ofstream results(path, std::ios::app);
+	if (!results.is_open()) {
+		std::cout << "Could not open " << path << std::endl;
+		return -1;
+	}
+	if (results.tellp() == 0) {
+		results << options << std::endl << SWEEP_CSV_HEADER << std::endl;
+	}
+
+	Level level;
+	double start = now();
+	for (uint32_t s = 0; s < sets.size(); s++) {
+		if (finished[s]) {
+			continue;
+		}
+
+		BatchParams setBatch = batch;
+		applySweepSet(sets[s], setBatch.sim);
+
+		std::atomic<uint32_t> nextMatch(0);
+		std::vector<SweepTally> tallies(noThreads);
+		std::vector<std::thread> workers;
+		for (uint32_t i = 0; i < noThreads; i++) {
+			workers.push_back(std::thread(sweepWorker, std::cref(setBatch), std::cref(level), std::ref(nextMatch), noMatches, std::ref(tallies[i])));
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+		SweepTally tally;
+		for (const SweepTally& t : tallies) {
+			mergeTally(tally, t);
+		}
+
+		//Mean Rally Length with a Normal Interval over Matches, Left Empty if no Rally ever Finished
+		double n = (double)tally.noRallyMatches;
+		double mean = n > 0 ? tally.rallySum / n : 0.0;
+		double variance = n > 1 ? (tally.rallySumSq - n * mean * mean) / (n - 1) : 0.0;
+		double half = n > 0 ? 1.96 * sqrt(std::max(0.0, variance) / n) : 0.0;
+		char rally[64] = ",,";
+		if (n > 0) {
+			snprintf(rally, sizeof(rally), "%.4f,%.4f,%.4f", mean, mean - half, mean + half);
+		}
+
+		double pointLo, pointHi, matchLo, matchHi;
+		uint64_t noPoints = tally.points[0] + tally.points[1];
+		uint64_t noDecided = tally.matchWins[0] + tally.matchWins[1];
+		wilsonInterval(tally.points[0], noPoints, pointLo, pointHi);
+		wilsonInterval(tally.matchWins[0], noDecided, matchLo, matchHi);
+
+		//One Flushed Line per Set, so Anything Reported Survives an Interruption
+		char line[512];
+		snprintf(line, sizeof(line), "%u,%.4f,%.4f,%.4f,%llu,%llu,%s,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f",
+			s, sets[s].values[0], sets[s].values[1], sets[s].values[2],
+			(unsigned long long)tally.noMatches, (unsigned long long)tally.noRallies, rally,
+			noPoints ? (double)tally.points[0] / noPoints : 0.5, pointLo, pointHi,
+			noDecided ? (double)tally.matchWins[0] / noDecided : 0.5, matchLo, matchHi);
+		results << line << std::endl;
+
+		std::cout << "set " << s << " (" << SWEEP_PARAMS[0] << " " << sets[s].values[0] << ", " << SWEEP_PARAMS[1] << " " << sets[s].values[1]
+			<< ", " << SWEEP_PARAMS[2] << " " << sets[s].values[2] << "): " << tally.noRallies << " rallies";
+		if (n > 0) {
+			std::cout << ", " << mean << " s +- " << half;
+		}
+		std::cout << ", p0 points " << (noPoints ? (double)tally.points[0] / noPoints : 0.5) << " [" << pointLo << ", " << pointHi << "]" << std::endl;
+	}
+
+	std::cout << sets.size() - noFinished << " sets in " << now() - start << " s" << std::endl;
+	return 0;
+}
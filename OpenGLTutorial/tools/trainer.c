@@ -0,0 +1,196 @@
+/*
+	Reference trainer in plain C for envserver's shared memory environments
+	(see env_shm.h). It plays every environment with a fixed policy rather
+	than learning, and times each step's round trip: write the actions,
+	post the request, wait for the server to post the step done. Linux
+	only:
+
+		gcc -std=c99 -O2 -I../src trainer.c -o trainer -lrt
+
+	Usage: trainer [options]
+		--name N		shared memory name, /pong-env by default
+		--steps N		steps to take, 10000 by default
+		--policy P		track (follow the nearest incoming ball) or random, track by default
+		--spin N		polls before sleeping on the futex, 100000 by default, 0 on a single core
+		--stop			shut the server down afterwards
+*/
+
+#define _GNU_SOURCE
+
+#include "env_shm.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/* - Timing - */
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* - Region - */
+
+//Map the Server's Region, Waiting up to Ten Seconds for it to Appear and be Filled In
+static EnvShmHeader* openRegion(const char* name)
+{
+	for (int attempt = 0; attempt < 1000; attempt++) {
+		int fd = shm_open(name, O_RDWR, 0);
+		if (fd >= 0) {
+			EnvShmHeader* header = (EnvShmHeader*)mmap(NULL, sizeof(EnvShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+			if (header != MAP_FAILED && __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == ENV_SHM_MAGIC) {
+				if (header->version != ENV_SHM_VERSION) {
+					printf("%s is version %u, this trainer reads version %d\n", name, header->version, ENV_SHM_VERSION);
+					close(fd);
+					return NULL;
+				}
+				size_t size = (size_t)header->totalSize;
+				munmap(header, sizeof(EnvShmHeader));
+				header = (EnvShmHeader*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				close(fd);
+				return header == MAP_FAILED ? NULL : header;
+			}
+			if (header != MAP_FAILED) {
+				munmap(header, sizeof(EnvShmHeader));
+			}
+			close(fd);
+		}
+		usleep(10000);
+	}
+	printf("No environments at %s\n", name);
+	return NULL;
+}
+
+/* - Policies - */
+
+//Move Towards the Soonest Incoming Ball, Centre when None; Observations are Scaled to about -1 to 1
+static uint8_t trackBall(const float* obs, uint32_t noBalls)
+{
+	float target = 0.0f;
+	float nearest = 3.0f;
+	for (uint32_t i = 0; i < noBalls; i++) {
+		const float* ball = obs + 2 + i * 4;
+		if (ball[2] < 0.0f && ball[0] + 1.0f < nearest) {
+			nearest = ball[0] + 1.0f;
+			target = ball[1];
+		}
+	}
+	if (target > obs[0] + 0.03f) {
+		return ENV_ACTION_UP;
+	}
+	if (target < obs[0] - 0.03f) {
+		return ENV_ACTION_DOWN;
+	}
+	return ENV_ACTION_STAY;
+}
+
+static uint32_t xorshift(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* - Main - */
+
+int main(int argc, char** argv)
+{
+	const char* name = ENV_SHM_DEFAULT_NAME;
+	uint32_t noSteps = 10000;
+	uint32_t spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 100000 : 0;
+	int randomPolicy = 0;
+	int stopServer = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+			name = argv[++i];
+		}
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+			noSteps = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+			randomPolicy = strcmp(argv[++i], "random") == 0;
+		}
+		else if (strcmp(argv[i], "--spin") == 0 && i + 1 < argc) {
+			spins = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--stop") == 0) {
+			stopServer = 1;
+		}
+	}
+
+	EnvShmHeader* header = openRegion(name);
+	if (!header) {
+		return -1;
+	}
+	uint32_t noEnvs = header->noEnvs;
+	uint32_t obsFloats = header->obsFloats;
+	float* obs = envObservations(header);
+	uint8_t* actions = envActions(header);
+	float* rewards = envRewards(header);
+	uint8_t* dones = envDones(header);
+
+	//Steps Carry on from wherever an Earlier Trainer Left Off
+	uint32_t first = __atomic_load_n(&header->done.value, __ATOMIC_ACQUIRE);
+	double* latencies = (double*)malloc(noSteps * sizeof(double));
+	double rewardSum = 0.0;
+	uint64_t noEpisodes = 0;
+	uint64_t noTruncated = 0;
+	uint32_t random = 12345;
+	double start = now();
+	for (uint32_t s = 0; s < noSteps; s++) {
+		for (uint32_t e = 0; e < noEnvs; e++) {
+			actions[e] = randomPolicy ? (uint8_t)(xorshift(&random) % 3) : trackBall(obs + (size_t)e * obsFloats, header->noBalls);
+		}
+
+		double sent = now();
+		uint32_t step = first + s + 1;
+		envShmPost(&header->request, step);
+		envShmWait(&header->done, step - 1, spins);
+		latencies[s] = now() - sent;
+
+		for (uint32_t e = 0; e < noEnvs; e++) {
+			rewardSum += rewards[e];
+			noEpisodes += dones[e] != ENV_DONE_NOT;
+			noTruncated += dones[e] == ENV_DONE_TRUNCATED;
+		}
+	}
+	double seconds = now() - start;
+
+	if (stopServer) {
+		__atomic_store_n(&header->stop, 1, __ATOMIC_RELEASE);
+		envShmPost(&header->request, first + noSteps + 1);
+	}
+
+	double latencySum = 0.0;
+	for (uint32_t s = 0; s < noSteps; s++) {
+		latencySum += latencies[s];
+	}
+	qsort(latencies, noSteps, sizeof(double), compareDoubles);
+	printf("%u steps of %u environments (%u ticks each) in %.3f s\n", noSteps, noEnvs, header->ticksPerStep, seconds);
+	printf("%.0f round trips/s, %.0f environment steps/s\n", noSteps / seconds, (double)noSteps * noEnvs / seconds);
+	if (noSteps > 0) {
+		printf("round trip: mean %.2f us, median %.2f us, p99 %.2f us, max %.2f us\n", latencySum / noSteps * 1e6,
+			latencies[noSteps / 2] * 1e6, latencies[(size_t)(noSteps * 0.99)] * 1e6, latencies[noSteps - 1] * 1e6);
+	}
+	printf("%llu episodes (%llu cut short), %.3f reward per episode\n", (unsigned long long)noEpisodes, (unsigned long long)noTruncated,
+		noEpisodes ? rewardSum / noEpisodes : 0.0);
+
+	free(latencies);
+	munmap(header, (size_t)header->totalSize);
+	return 0;
+}